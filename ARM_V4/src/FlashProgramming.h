@@ -6,40 +6,10 @@
 #include "FlashImage.h"
 #include "USBDM_API.h"
 #include "usbdmTcl.h"
+#include "ARM_FlashDriver.h"
 
 class ProgressTimer;
 
-#pragma pack(1)
-//! Header at the start of flash programming code (describes flash code)
-struct LargeTargetImageHeader {
-   uint32_t         loadAddress;       // Address where to load this image
-   uint32_t         entry;             // Pointer to entry routine
-   uint32_t         capabilities;      // Capabilities of routine
-   uint32_t         reserved1;
-   uint32_t         reserved2;
-   uint32_t         flashData;         // Pointer to information about operation
-};
-
-//! Header at the start of flash programming buffer (controls program action)
-struct LargeTargetFlashDataHeader {
-   uint32_t         flags;             // Controls actions of routine
-   uint32_t         controller;        // Ptr to flash controller
-   uint32_t         frequency;         // Target frequency (kHz)
-   uint16_t         errorCode;         // Error code from action
-   uint16_t         sectorSize;        // Size of flash sectors (minimum erase size)
-   uint32_t         address;           // Memory address being accessed (reserved/page/address)
-   uint32_t         dataSize;          // Size of memory range being accessed
-   uint32_t         dataAddress;       // Ptr to data to program
-};
-
-struct ResultStruct {
-   uint32_t         flags;             // Incomplete actions of routine
-   uint32_t         reserved1;
-   uint32_t         reserved2;
-   uint16_t         errorCode;         // Error code from action
-};
-#pragma pack()
-
 //! Describes the flash programming code (created from loaded flash routines)
 struct TargetProgramInfo {
    uint32_t         entry;                   //!< Address of entry routine (for currently loaded routine)
@@ -70,31 +40,18 @@ struct FlashOperationInfo {
 class FlashProgrammer {
 
 private:
-   // Error codes return from the flash driver
-   enum FlashDriverError_t {
-        FLASH_ERR_OK                = (0),
-        FLASH_ERR_LOCKED            = (1),  // Flash is still locked
-        FLASH_ERR_ILLEGAL_PARAMS    = (2),  // Parameters illegal
-        FLASH_ERR_PROG_FAILED       = (3),  // STM - Programming operation failed - general
-        FLASH_ERR_PROG_WPROT        = (4),  // STM - Programming operation failed - write protected
-        FLASH_ERR_VERIFY_FAILED     = (5),  // Verify failed
-        FLASH_ERR_ERASE_FAILED      = (6),  // Erase or Blank Check failed
-        FLASH_ERR_TRAP              = (7),  // Program trapped (illegal instruction/location etc.)
-        FLASH_ERR_PROG_ACCERR       = (8),  // Kinetis/CFVx - Programming operation failed - ACCERR
-        FLASH_ERR_PROG_FPVIOL       = (9),  // Kinetis/CFVx - Programming operation failed - FPVIOL
-        FLASH_ERR_PROG_MGSTAT0      = (10), // Kinetis - Programming operation failed - MGSTAT0
-        FLASH_ERR_CLKDIV            = (11), // CFVx - Clock divider not set
-        FLASH_ERR_ILLEGAL_SECURITY  = (12), // Kinetis - Illegal value for security location
-        FLASH_ERR_UNKNOWN           = (13), // Unspecified error
-        FLASH_ERR_TIMEOUT           = (14), // Timeout waiting for completion
-   };
-
    enum AddressModifiers {
       ADDRESS_LINEAR = 1UL<<31,
       ADDRESS_EEPROM = 1UL<<30,
    };
    typedef USBDM_ErrorCode (*CallBackT)(USBDM_ErrorCode status, int percent, const char *message);
 
+   //! Flash driver converted from S-record form
+   struct FlashDriverImage {
+      std::vector<memoryElementType> image;        //!< Binary image of driver
+      uint32_t                       loadAddress;  //!< Where image is located in target memory
+   };
+
    DeviceData              parameters;               //!< Parameters describing the target device
    Tcl_Interp              *tclInterpreter;          //!< TCL interpreter
    bool                    useTCLScript;
@@ -106,8 +63,10 @@ private:
    FlashProgramPtr         currentFlashProgram;
    FlashOperation          currentFlashOperation;
    uint32_t                currentFlashAlignment;
+   std::map<FlashProgramPtr, FlashDriverImage> flashDriverCache; //!< Flash drivers already converted from S-records
    ProgressTimer          *progressTimer;
    bool                    doRamWrites;
+   std::map<uint32_t,uint32_t> erasedRanges;     //!< Flash known to be erased this session, start=>end (flash image addresses)
 
    USBDM_ErrorCode initialiseTargetFlash();
    USBDM_ErrorCode initialiseTarget();
@@ -121,6 +80,11 @@ private:
                                    int            do9BitTrim);
    USBDM_ErrorCode configureExternal_Clock(unsigned long  *busFrequency);
    USBDM_ErrorCode eraseFlash(void);
+   USBDM_ErrorCode eraseFlashRegion(MemoryRegionPtr memoryRegionPtr);
+   void            clearErasedRanges(void);
+   void            markErased(uint32_t start, uint32_t end);
+   void            markRegionErased(MemoryRegionPtr memoryRegionPtr);
+   bool            isErased(uint32_t start, uint32_t end);
    USBDM_ErrorCode convertTargetErrorCode(FlashDriverError_t rc);
    USBDM_ErrorCode initSmallTargetBuffer(memoryElementType *buffer);
    USBDM_ErrorCode initLargeTargetBuffer(memoryElementType *buffer);
@@ -133,14 +97,20 @@ private:
    USBDM_ErrorCode selectiveEraseFlashSecurity(void);
    USBDM_ErrorCode doTargetVerify(FlashImage *flashImage);
    USBDM_ErrorCode doReadbackVerify(FlashImage *flashImage);
+   USBDM_ErrorCode doReadbackVerify(FlashImage *flashImage, uint32_t startBlock, uint32_t regionSize);
    USBDM_ErrorCode applyFlashOperation(FlashImage *flashImage, FlashOperation flashOperation);
    USBDM_ErrorCode doVerify(FlashImage *flashImage);
    USBDM_ErrorCode doSelectiveErase(FlashImage  *flashImage);
+   bool            getFlashSectorInfo(uint32_t         address,
+                                      MemoryRegionPtr &memoryRegionPtr,
+                                      uint32_t        &rangeStart,
+                                      uint32_t        &rangeEnd,
+                                      uint32_t        &sectorSize);
    USBDM_ErrorCode doProgram(FlashImage  *flashImage);
-   USBDM_ErrorCode doBlankCheck(FlashImage *flashImage);
    USBDM_ErrorCode doWriteRam(FlashImage *flashImage);
    USBDM_ErrorCode loadTargetProgram(FlashOperation flashOperation);
    USBDM_ErrorCode loadTargetProgram(FlashProgramPtr flashProgram, FlashOperation flashOperation);
+   USBDM_ErrorCode getFlashDriverImage(FlashProgramPtr flashProgram, const FlashDriverImage **flashDriverImage);
    USBDM_ErrorCode loadSmallTargetProgram(memoryElementType *buffer,
                                           uint32_t           loadAddress,
                                           uint32_t           size,
@@ -152,11 +122,19 @@ private:
                                           FlashProgramPtr    flashProgram,
                                           FlashOperation     flashOperation);
    USBDM_ErrorCode probeMemory(MemorySpace_t memorySpace, uint32_t address);
+   USBDM_ErrorCode waitFlashControllerIdle(uint32_t controller);
+   USBDM_ErrorCode executeFlashControllerCommand(uint32_t controller, uint32_t fccob[3]);
+   USBDM_ErrorCode readFlexNVMPartition(uint32_t controller, uint8_t *eeepromSize, uint8_t *partitionValue);
+   USBDM_ErrorCode doFlexRAMBlock(FlashImage    *flashImage,
+                                  uint32_t       address,
+                                  uint32_t       blockSize,
+                                  FlashOperation flashOperation);
    USBDM_ErrorCode partitionFlexNVM(void);
 
 public:
    USBDM_ErrorCode initTCL(void);
    USBDM_ErrorCode releaseTCL(void);
+   static USBDM_ErrorCode releaseTclInterpreterPool(void);
    USBDM_ErrorCode setDeviceData(const DeviceData  &theParameters);
    USBDM_ErrorCode checkTargetUnSecured();
    USBDM_ErrorCode runTCLScript(TclScriptPtr script);
@@ -83,6 +83,7 @@
 #include "TargetDefines.h"
 #include "Utils.h"
 #include "ProgressTimer.h"
+#include "Crc32.h"
 #include "SimpleSRecords.h"
 #if TARGET == ARM
 #include "USBDM_ARM_API.h"
@@ -733,8 +734,6 @@ USBDM_ErrorCode FlashProgrammer::loadTargetProgram(FlashOperation flashOperation
 //!         Confirms download (if necessary) and checks RAM boundaries.
 //!
 USBDM_ErrorCode FlashProgrammer::loadTargetProgram(FlashProgramPtr flashProgram, FlashOperation flashOperation) {
-   memoryElementType     buffer[4000];
-
    print("FlashProgrammer::loadTargetProgram(%s)\n", getFlashOperationName(flashOperation));
 
    if (!flashProgram) {
@@ -764,46 +763,81 @@ USBDM_ErrorCode FlashProgrammer::loadTargetProgram(FlashProgramPtr flashProgram,
    }
    currentFlashOperation = OpNone;
 
-   unsigned size; // In memoryElementType
-   uint32_t loadAddress;
-   USBDM_ErrorCode rc = loadSRec(flashProgram->flashProgram.c_str(),
-                                 buffer,
-                                 sizeof(buffer)/sizeof(buffer[0]),
-                                 &size,
-                                 &loadAddress);
-   if (rc !=  BDM_RC_OK) {
-      print("FlashProgrammer::loadTargetProgram(...) - loadSRec() failed\n");
-      return PROGRAMMING_RC_ERROR_INTERNAL_CHECK_FAILED;
+   const FlashDriverImage *flashDriverImage;
+   USBDM_ErrorCode rc = getFlashDriverImage(flashProgram, &flashDriverImage);
+   if (rc != PROGRAMMING_RC_OK) {
+      return rc;
    }
+   // Working copy as header is modified before download
+   std::vector<memoryElementType> buffer(flashDriverImage->image);
+   unsigned size        = (unsigned)buffer.size(); // In memoryElementType
+   uint32_t loadAddress = flashDriverImage->loadAddress;
+
+   if (currentFlashProgram != flashProgram) {
 #if TARGET == MC56F80xx
-   MemorySpace_t memorySpace = MS_XWord;
-#else      
-   MemorySpace_t memorySpace = MS_Byte;
-#endif   
-   // Probe RAM buffer
-   rc = probeMemory(memorySpace, parameters.getRamStart());
-   if (rc == BDM_RC_OK) {
-      rc = probeMemory(memorySpace, parameters.getRamEnd());
-   }
-   if (rc != BDM_RC_OK) {
-      return rc;
+      MemorySpace_t memorySpace = MS_XWord;
+#else
+      MemorySpace_t memorySpace = MS_Byte;
+#endif
+      // Probe RAM buffer (only needed before first download of this code)
+      rc = probeMemory(memorySpace, parameters.getRamStart());
+      if (rc == BDM_RC_OK) {
+         rc = probeMemory(memorySpace, parameters.getRamEnd());
+      }
+      if (rc != BDM_RC_OK) {
+         return rc;
+      }
    }
 #if (TARGET==HCS08)   
-   LoadInfoStruct *infoPtr = (LoadInfoStruct *)buffer;
+   LoadInfoStruct *infoPtr = (LoadInfoStruct *)&buffer[0];
    targetProgramInfo.smallProgram = (infoPtr->flags&OPT_SMALL_CODE) != 0;
    infoPtr->flags &= ~OPT_SMALL_CODE;
    if (targetProgramInfo.smallProgram) {
-      return loadSmallTargetProgram(buffer, loadAddress, size, flashProgram, flashOperation);
+      return loadSmallTargetProgram(&buffer[0], loadAddress, size, flashProgram, flashOperation);
    }
    else {
-      return loadLargeTargetProgram(buffer, loadAddress, size, flashProgram, flashOperation);
+      return loadLargeTargetProgram(&buffer[0], loadAddress, size, flashProgram, flashOperation);
    }
 #else
    targetProgramInfo.smallProgram = false;
-   return loadLargeTargetProgram(buffer, loadAddress, size, flashProgram, flashOperation);
+   return loadLargeTargetProgram(&buffer[0], loadAddress, size, flashProgram, flashOperation);
 #endif
 }
 
+//=======================================================================
+//! Obtain binary image of flash driver
+//!
+//! @param  flashProgram      flash program to convert
+//! @param  flashDriverImage  returns pointer to cached binary image
+//!
+//! @return error code, see \ref USBDM_ErrorCode
+//!
+//! @note The S-record form is only converted on first use
+//!
+USBDM_ErrorCode FlashProgrammer::getFlashDriverImage(FlashProgramPtr flashProgram, const FlashDriverImage **flashDriverImage) {
+   std::map<FlashProgramPtr, FlashDriverImage>::iterator it = flashDriverCache.find(flashProgram);
+   if (it != flashDriverCache.end()) {
+      print("FlashProgrammer::getFlashDriverImage() - using cached image\n");
+      *flashDriverImage = &it->second;
+      return PROGRAMMING_RC_OK;
+   }
+   FlashDriverImage image;
+   unsigned size; // In memoryElementType
+   image.image.resize(4000);
+   USBDM_ErrorCode rc = loadSRec(flashProgram->flashProgram.c_str(),
+                                 &image.image[0],
+                                 (unsigned)image.image.size(),
+                                 &size,
+                                 &image.loadAddress);
+   if (rc !=  BDM_RC_OK) {
+      print("FlashProgrammer::getFlashDriverImage() - loadSRec() failed\n");
+      return PROGRAMMING_RC_ERROR_INTERNAL_CHECK_FAILED;
+   }
+   image.image.resize(size);
+   *flashDriverImage = &(flashDriverCache[flashProgram] = image);
+   return PROGRAMMING_RC_OK;
+}
+
 //=======================================================================
 //! Loads the Flash programming code to target memory
 //!
@@ -1648,53 +1682,146 @@ USBDM_ErrorCode FlashProgrammer::eraseFlash(void) {
       if (!memoryRegionPtr->isProgrammableMemory()) {
          continue;
       }
-      MemType_t memoryType = memoryRegionPtr->getMemoryType();
-      print("FlashProgrammer::eraseFlash() - Erasing %s\n", MemoryRegion::getMemoryTypeName(memoryType));
+      rc = eraseFlashRegion(memoryRegionPtr);
+      if (rc != PROGRAMMING_RC_OK) {
+         return rc;
+      }
+   }
+   return rc;
+}
+
+//=======================================================================
+//! Erase a flash region using a block erase
+//!
+//! @param memoryRegionPtr - Region to erase
+//!
+//! @return error code see \ref USBDM_ErrorCode.
+//!
+//! @note Assumes flash has been initialised.
+//!
+USBDM_ErrorCode FlashProgrammer::eraseFlashRegion(MemoryRegionPtr memoryRegionPtr) {
+   USBDM_ErrorCode rc;
+   MemType_t memoryType = memoryRegionPtr->getMemoryType();
+   print("FlashProgrammer::eraseFlashRegion() - Erasing %s\n", MemoryRegion::getMemoryTypeName(memoryType));
 
-      uint32_t addressFlag  = 0;
-      uint32_t flashAddress = memoryRegionPtr->getDummyAddress();
+   uint32_t addressFlag  = 0;
+   uint32_t flashAddress = memoryRegionPtr->getDummyAddress();
 
 #if (TARGET == HCS08) || (TARGET == HCS12)
-      if (memoryRegionPtr->getAddressType() == AddrLinear) {
-         addressFlag |= ADDRESS_LINEAR;
-      }
-      if (memoryRegionPtr->getMemoryType() == MemEEPROM) {
-         addressFlag |= ADDRESS_EEPROM;
-      }
+   if (memoryRegionPtr->getAddressType() == AddrLinear) {
+      addressFlag |= ADDRESS_LINEAR;
+   }
+   if (memoryRegionPtr->getMemoryType() == MemEEPROM) {
+      addressFlag |= ADDRESS_EEPROM;
+   }
 #endif
 #if (TARGET == MC56F80xx)
-      if (memoryType == MemXROM) {
-         // |0x80 => XROM, |0x03 => Bank1 (Data)
-         addressFlag |= 0x83000000;
-      }
+   if (memoryType == MemXROM) {
+      // |0x80 => XROM, |0x03 => Bank1 (Data)
+      addressFlag |= 0x83000000;
+   }
 #endif      
 #if (TARGET == CFV1) || (TARGET == ARM)
-      if ((memoryType == MemFlexNVM) || (memoryType == MemDFlash)) {
-         // Flag needed for DFLASH/flexNVM access
-         addressFlag  |= (1<<23);
-         flashAddress  = 0;
-      }
+   if ((memoryType == MemFlexNVM) || (memoryType == MemDFlash)) {
+      // Flag needed for DFLASH/flexNVM access
+      addressFlag  |= (1<<23);
+      flashAddress  = 0;
+   }
 #endif
-      flashOperationInfo.flashAddress      = flashAddress|addressFlag;
-      flashOperationInfo.controller        = memoryRegionPtr->getRegisterAddress();
-      flashOperationInfo.sectorSize        = memoryRegionPtr->getSectorSize();
-      flashOperationInfo.alignment         = memoryRegionPtr->getAlignment();
-      flashOperationInfo.pageAddress       = memoryRegionPtr->getPageAddress();
-      flashOperationInfo.dataSize          = 0;
-      flashOperationInfo.flexNVMPartition  = (uint32_t)-1;
+   flashOperationInfo.flashAddress      = flashAddress|addressFlag;
+   flashOperationInfo.controller        = memoryRegionPtr->getRegisterAddress();
+   flashOperationInfo.sectorSize        = memoryRegionPtr->getSectorSize();
+   flashOperationInfo.alignment         = memoryRegionPtr->getAlignment();
+   flashOperationInfo.pageAddress       = memoryRegionPtr->getPageAddress();
+   flashOperationInfo.dataSize          = 0;
+   flashOperationInfo.flexNVMPartition  = (uint32_t)-1;
 
-      const FlashProgramPtr flashProgram = memoryRegionPtr->getFlashprogram();
-      rc = loadTargetProgram(flashProgram, OpBlockErase);
-      if (rc != PROGRAMMING_RC_OK) {
-         print("FlashProgrammer::eraseFlash() - loadTargetProgram() failed \n");
-         return rc;
+   const FlashProgramPtr flashProgram = memoryRegionPtr->getFlashprogram();
+   rc = loadTargetProgram(flashProgram, OpBlockErase);
+   if (rc != PROGRAMMING_RC_OK) {
+      print("FlashProgrammer::eraseFlashRegion() - loadTargetProgram() failed \n");
+      return rc;
+   }
+   rc = executeTargetProgram();
+   if (rc == PROGRAMMING_RC_OK) {
+      markRegionErased(memoryRegionPtr);
+   }
+   return rc;
+}
+
+//=======================================================================
+//! Discard record of erased flash
+//!
+void FlashProgrammer::clearErasedRanges(void) {
+   erasedRanges.clear();
+}
+
+//=======================================================================
+//! Record a range of flash as erased
+//!
+//! @param start - Start of range (flash image address)
+//! @param end   - End of range (inclusive)
+//!
+//! @note Overlapping and adjacent ranges are merged
+//!
+void FlashProgrammer::markErased(uint32_t start, uint32_t end) {
+   std::map<uint32_t,uint32_t>::iterator it = erasedRanges.upper_bound(start);
+   if (it != erasedRanges.begin()) {
+      std::map<uint32_t,uint32_t>::iterator previous = it;
+      previous--;
+      if (previous->second+1 >= start) {
+         // Merge with preceding range
+         start = previous->first;
+         if (previous->second > end) {
+            end = previous->second;
+         }
+         erasedRanges.erase(previous);
       }
-      rc = executeTargetProgram();
-      if (rc != PROGRAMMING_RC_OK) {
-         return rc;
+   }
+   // Absorb following ranges
+   it = erasedRanges.lower_bound(start);
+   while ((it != erasedRanges.end()) && (it->first <= end+1)) {
+      if (it->second > end) {
+         end = it->second;
       }
+      erasedRanges.erase(it++);
+   }
+   erasedRanges[start] = end;
+}
+
+//=======================================================================
+//! Record all of a flash region as erased
+//!
+//! @param memoryRegionPtr - Region that has been erased
+//!
+void FlashProgrammer::markRegionErased(MemoryRegionPtr memoryRegionPtr) {
+   uint32_t offset = 0;
+#if (TARGET == MC56F80xx)
+   if (memoryRegionPtr->getMemoryType() == MemXROM) {
+      offset = FlashImage::DataOffset;
+   }
+#endif
+   for (unsigned index=0; memoryRegionPtr->getMemoryRange(index) != NULL; index++) {
+      const MemoryRegion::MemoryRange *memoryRange = memoryRegionPtr->getMemoryRange(index);
+      markErased(memoryRange->start+offset, memoryRange->end+offset);
    }
-   return rc;
+}
+
+//=======================================================================
+//! Check if a range of flash is known to be erased
+//!
+//! @param start - Start of range (flash image address)
+//! @param end   - End of range (inclusive)
+//!
+//! @return true => entire range has been erased this session
+//!
+bool FlashProgrammer::isErased(uint32_t start, uint32_t end) {
+   std::map<uint32_t,uint32_t>::iterator it = erasedRanges.upper_bound(start);
+   if (it == erasedRanges.begin()) {
+      return false;
+   }
+   it--;
+   return (it->second >= end);
 }
 
 #if (TARGET == CFV1) || (TARGET == ARM) || (TARGET == HCS08)
@@ -1781,12 +1908,236 @@ USBDM_ErrorCode FlashProgrammer::selectiveEraseFlashSecurity(void) {
 #endif
 
 #if (TARGET == CFV1) || (TARGET == ARM)
+//=======================================================================
+// FTFL flash controller - used directly for FlexNVM status and FlexRAM (EEEPROM) access
+//
+#define FTFL_FSTAT_OFFSET       (0x00)
+#define FTFL_FCNFG_OFFSET       (0x01)
+#define FTFL_FCCOB_OFFSET       (0x04)       // FCCOB0-3, FCCOB4-7, FCCOB8-B accessed as longs
+
+#define FTFL_FSTAT_CCIF         (0x80)
+#define FTFL_FSTAT_ACCERR       (0x20)
+#define FTFL_FSTAT_FPVIOL       (0x10)
+#define FTFL_FSTAT_MGSTAT0      (0x01)
+#define FTFL_FCNFG_EEERDY       (0x01)
+
+#define F_RDRSRC                (0x03)       // Read resource command
+#define F_SETRAM                (0x81)       // Set FlexRAM function command
+#define SETRAM_EEE              (0x00)       // FlexRAM used for EEEPROM
+#define DFLASH_IFR_PARTITION    (0x8000FC)   // DFlash IFR location of EEESIZE & DEPART codes
+
+#define EEESIZE_MASK            (0x3F)       // EEEPROM split & size bits of EEESIZE code
+#define DEPART_MASK             (0x0F)       // Partition bits of DEPART code
+
+#define FLEXRAM_BATCH_SIZE      (0x100)      // Size of FlexRAM block transferred in one operation
+
+//=======================================================================
+//! Waits for flash controller command complete
+//!
+//! @param controller - address of flash controller
+//!
+//! @return error code see \ref USBDM_ErrorCode.
+//!
+USBDM_ErrorCode FlashProgrammer::waitFlashControllerIdle(uint32_t controller) {
+   uint8_t fstat;
+   for (int retry=100; retry>0; retry--) {
+      if (ReadMemory(MS_Byte, 1, controller+FTFL_FSTAT_OFFSET, &fstat) != BDM_RC_OK) {
+         return PROGRAMMING_RC_ERROR_BDM_READ;
+      }
+      if ((fstat&FTFL_FSTAT_CCIF) != 0) {
+         if ((fstat&(FTFL_FSTAT_ACCERR|FTFL_FSTAT_FPVIOL|FTFL_FSTAT_MGSTAT0)) != 0) {
+            print("FlashProgrammer::waitFlashControllerIdle() - Command failed, FSTAT=0x%02X\n", fstat);
+            return PROGRAMMING_RC_ERROR_FAILED_FLASH_COMMAND;
+         }
+         return PROGRAMMING_RC_OK;
+      }
+      milliSleep(1);
+   }
+   print("FlashProgrammer::waitFlashControllerIdle() - Timeout, FSTAT=0x%02X\n", fstat);
+   return PROGRAMMING_RC_ERROR_FAILED_FLASH_COMMAND;
+}
+
+//=======================================================================
+//! Executes a flash controller command directly
+//!
+//! @param controller - address of flash controller
+//! @param fccob      - FCCOB0-3, FCCOB4-7, FCCOB8-B (FCCOB0 is MSB of fccob[0]),
+//!                     updated with the values after the command completes
+//!
+//! @return error code see \ref USBDM_ErrorCode.
+//!
+USBDM_ErrorCode FlashProgrammer::executeFlashControllerCommand(uint32_t controller, uint32_t fccob[3]) {
+   uint8_t  clearErrors = FTFL_FSTAT_ACCERR|FTFL_FSTAT_FPVIOL;
+   uint8_t  launch      = FTFL_FSTAT_CCIF;
+   uint32_t buffer[3];
+
+   for (int index=0; index<3; index++) {
+      buffer[index] = nativeToTarget32(fccob[index]);
+   }
+   if ((WriteMemory(MS_Byte, 1,              controller+FTFL_FSTAT_OFFSET, &clearErrors)      != BDM_RC_OK) ||
+       (WriteMemory(MS_Long, sizeof(buffer), controller+FTFL_FCCOB_OFFSET, (uint8_t *)buffer) != BDM_RC_OK) ||
+       (WriteMemory(MS_Byte, 1,              controller+FTFL_FSTAT_OFFSET, &launch)           != BDM_RC_OK)) {
+      return PROGRAMMING_RC_ERROR_BDM_WRITE;
+   }
+   USBDM_ErrorCode rc = waitFlashControllerIdle(controller);
+   if (rc != PROGRAMMING_RC_OK) {
+      return rc;
+   }
+   if (ReadMemory(MS_Long, sizeof(buffer), controller+FTFL_FCCOB_OFFSET, (uint8_t *)buffer) != BDM_RC_OK) {
+      return PROGRAMMING_RC_ERROR_BDM_READ;
+   }
+   for (int index=0; index<3; index++) {
+      fccob[index] = targetToNative32(buffer[index]);
+   }
+   return PROGRAMMING_RC_OK;
+}
+
+//=======================================================================
+//! Reads the current FlexNVM partition from the DFlash IFR
+//!
+//! @param controller     - address of flash controller
+//! @param eeepromSize    - EEESIZE code (0xFF if unpartitioned)
+//! @param partitionValue - DEPART code (0xFF if unpartitioned)
+//!
+//! @return error code see \ref USBDM_ErrorCode.
+//!
+USBDM_ErrorCode FlashProgrammer::readFlexNVMPartition(uint32_t controller, uint8_t *eeepromSize, uint8_t *partitionValue) {
+   uint32_t fccob[3] = {(F_RDRSRC<<24)|DFLASH_IFR_PARTITION, 0, 0};
+
+   USBDM_ErrorCode rc = executeFlashControllerCommand(controller, fccob);
+   if (rc != PROGRAMMING_RC_OK) {
+      return rc;
+   }
+   // FCCOB6 = EEESIZE, FCCOB7 = DEPART
+   *eeepromSize    = (uint8_t)(fccob[1]>>8);
+   *partitionValue = (uint8_t)fccob[1];
+   print("FlashProgrammer::readFlexNVMPartition() - eeepromSize=0x%02X, partitionValue=0x%02X\n", *eeepromSize, *partitionValue);
+   return PROGRAMMING_RC_OK;
+}
+
+//=======================================================================
+//! Programs or verifies image data located in the FlexRAM (EEEPROM) window
+//!
+//! @param flashImage     - image to program
+//! @param address        - start of block
+//! @param blockSize      - size of block
+//! @param flashOperation - operation (only program and verify operations have any effect)
+//!
+//! @return error code see \ref USBDM_ErrorCode.
+//!
+//! @note The window is accessed in batches of FLEXRAM_BATCH_SIZE bytes. Each batch is
+//!       read first and only the longwords that differ from the image are written as every
+//!       write uses EEPROM backing store.  The controller must be idle before each longword
+//!       is written and the batch is read back once written.
+//!
+USBDM_ErrorCode FlashProgrammer::doFlexRAMBlock(FlashImage    *flashImage,
+                                                uint32_t       address,
+                                                uint32_t       blockSize,
+                                                FlashOperation flashOperation) {
+   USBDM_ErrorCode rc;
+   bool writeData = (flashOperation == OpProgram);
+
+   if (!writeData && (flashOperation != OpVerify)) {
+      print("FlashProgrammer::doFlexRAMBlock() - Skipping FlexRAM[0x%06X..0x%06X] for %s\n",
+            address, address+blockSize-1, getFlashOperationName(flashOperation));
+      return PROGRAMMING_RC_OK;
+   }
+   MemoryRegionPtr flexNvmRegionPtr;
+   for (int index=0; ; index++) {
+      flexNvmRegionPtr = parameters.getMemoryRegion(index);
+      if ((flexNvmRegionPtr == NULL) ||
+          (flexNvmRegionPtr->getMemoryType() == MemFlexNVM)) {
+         break;
+      }
+   }
+   if (flexNvmRegionPtr == NULL) {
+      print("FlashProgrammer::doFlexRAMBlock() - No FlexNVM Region found\n");
+      return PROGRAMMING_RC_ERROR_ILLEGAL_PARAMS;
+   }
+   uint32_t controller = flexNvmRegionPtr->getRegisterAddress();
+   if (writeData) {
+      // Make FlexRAM available as EEEPROM if necessary
+      uint8_t fcnfg;
+      if (ReadMemory(MS_Byte, 1, controller+FTFL_FCNFG_OFFSET, &fcnfg) != BDM_RC_OK) {
+         return PROGRAMMING_RC_ERROR_BDM_READ;
+      }
+      if ((fcnfg&FTFL_FCNFG_EEERDY) == 0) {
+         uint32_t fccob[3] = {((uint32_t)F_SETRAM<<24)|((uint32_t)SETRAM_EEE<<16), 0, 0};
+         rc = executeFlashControllerCommand(controller, fccob);
+         if ((rc == PROGRAMMING_RC_OK) &&
+             (ReadMemory(MS_Byte, 1, controller+FTFL_FCNFG_OFFSET, &fcnfg) != BDM_RC_OK)) {
+            rc = PROGRAMMING_RC_ERROR_BDM_READ;
+         }
+         if ((rc != PROGRAMMING_RC_OK) || ((fcnfg&FTFL_FCNFG_EEERDY) == 0)) {
+            print("FlashProgrammer::doFlexRAMBlock() - FlexRAM not available as EEEPROM\n");
+            return PROGRAMMING_RC_FLEXNVM_CONFIGURATION_FAILED;
+         }
+      }
+   }
+   uint8_t  targetData[FLEXRAM_BATCH_SIZE];
+   uint8_t  imageData[FLEXRAM_BATCH_SIZE];
+   uint32_t endAddress = address+blockSize;
+   unsigned batchesWritten = 0;
+   while (address < endAddress) {
+      // Batch is long aligned and does not cross a FLEXRAM_BATCH_SIZE boundary
+      uint32_t batchStart = address&~3;
+      uint32_t batchEnd   = (address|(FLEXRAM_BATCH_SIZE-1))+1;
+      if (batchEnd > endAddress) {
+         batchEnd = (endAddress+3)&~3;
+      }
+      uint32_t batchSize = batchEnd-batchStart;
+      if (ReadMemory(MS_Long, batchSize, batchStart, targetData) != BDM_RC_OK) {
+         return PROGRAMMING_RC_ERROR_BDM_READ;
+      }
+      bool changed = false;
+      for (uint32_t index=0; index<batchSize; index++) {
+         imageData[index] = targetData[index];
+         if (flashImage->isValid(batchStart+index)) {
+            imageData[index] = flashImage->getValue(batchStart+index);
+            changed = changed || (imageData[index] != targetData[index]);
+         }
+      }
+      if (changed) {
+         if (!writeData) {
+            print("FlashProgrammer::doFlexRAMBlock() - Verify failed FlexRAM[0x%06X..0x%06X]\n", batchStart, batchEnd-1);
+            return PROGRAMMING_RC_ERROR_FAILED_VERIFY;
+         }
+         for (uint32_t index=0; index<batchSize; index+=4) {
+            if (memcmp(imageData+index, targetData+index, 4) == 0) {
+               continue;
+            }
+            if (WriteMemory(MS_Long, 4, batchStart+index, imageData+index) != BDM_RC_OK) {
+               return PROGRAMMING_RC_ERROR_BDM_WRITE;
+            }
+            // Wait for EEEPROM update to complete before next write
+            rc = waitFlashControllerIdle(controller);
+            if (rc != PROGRAMMING_RC_OK) {
+               return rc;
+            }
+         }
+         if (ReadMemory(MS_Long, batchSize, batchStart, targetData) != BDM_RC_OK) {
+            return PROGRAMMING_RC_ERROR_BDM_READ;
+         }
+         if (memcmp(imageData, targetData, batchSize) != 0) {
+            print("FlashProgrammer::doFlexRAMBlock() - Write failed FlexRAM[0x%06X..0x%06X]\n", batchStart, batchEnd-1);
+            return PROGRAMMING_RC_ERROR_FAILED_VERIFY;
+         }
+         batchesWritten++;
+      }
+      address = batchEnd;
+   }
+   print("FlashProgrammer::doFlexRAMBlock() - %s complete, %d batches written\n",
+         getFlashOperationName(flashOperation), batchesWritten);
+   return PROGRAMMING_RC_OK;
+}
+
 //=======================================================================
 //! Program FlashNVM partion (DFlash/EEPROM backing store)
 //!
 //! @return error code see \ref USBDM_ErrorCode.
 //!
 //! @note - Assumes flash programming code has already been loaded to target.
+//! @note - The partition command is only issued if the current partition differs.
 //!
 USBDM_ErrorCode FlashProgrammer::partitionFlexNVM() {
    uint8_t eeepromSize  = parameters.getFlexNVMParameters()->eeepromSize;
@@ -1797,7 +2148,6 @@ USBDM_ErrorCode FlashProgrammer::partitionFlexNVM() {
       return BDM_RC_OK;
    }
    print("FlashProgrammer::programPartition(eeepromSize=0x%02X, partionValue=0x%02X)\n", eeepromSize, partionValue);
-   progressTimer->restart("Partitioning DFlash...");
 
    // Find flexNVM region
    MemoryRegionPtr memoryRegionPtr;
@@ -1812,6 +2162,18 @@ USBDM_ErrorCode FlashProgrammer::partitionFlexNVM() {
       print("FlashProgrammer::programPartition() - No FlexNVM Region found\n");
       return PROGRAMMING_RC_ERROR_ILLEGAL_PARAMS;
    }
+   uint8_t currentEeepromSize;
+   uint8_t currentPartionValue;
+   rc = readFlexNVMPartition(memoryRegionPtr->getRegisterAddress(), &currentEeepromSize, &currentPartionValue);
+   if (rc != PROGRAMMING_RC_OK) {
+      print("FlashProgrammer::programPartition() - Unable to read current partition, Reason= %s\n", USBDM_GetErrorString(rc));
+   }
+   else if (((currentEeepromSize&EEESIZE_MASK) == (eeepromSize&EEESIZE_MASK)) &&
+            ((currentPartionValue&DEPART_MASK) == (partionValue&DEPART_MASK))) {
+      print("FlashProgrammer::programPartition() - FlexNVM already partitioned - skipping\n");
+      return PROGRAMMING_RC_OK;
+   }
+   progressTimer->restart("Partitioning DFlash...");
    MemType_t memoryType = memoryRegionPtr->getMemoryType();
    print("FlashProgrammer::programPartition() - Partitioning %s\n", MemoryRegion::getMemoryTypeName(memoryType));
    const FlashProgramPtr flashProgram = memoryRegionPtr->getFlashprogram();
@@ -2077,6 +2439,9 @@ USBDM_ErrorCode FlashProgrammer::runTCLScript(TclScriptPtr script) {
 //=======================================================================
 // Executes a TCL command previously loaded in the TCL interpreter
 //
+// The command is invoked directly rather than being parsed as a script.
+// Arguments are treated as a TCL list i.e. no substitutions are done.
+//
 USBDM_ErrorCode FlashProgrammer::runTCLCommand(const char *command) {
    print("FlashProgrammer::runTCLCommand(): Running TCL Command '%s'\n", command);
 
@@ -2087,7 +2452,15 @@ USBDM_ErrorCode FlashProgrammer::runTCLCommand(const char *command) {
    if (tclInterpreter == NULL) {
       return PROGRAMMING_RC_ERROR_INTERNAL_CHECK_FAILED;
    }
-   if (evalTclScript(tclInterpreter, command) != 0) {
+   // Split into command name and arguments
+   std::string commandName(command);
+   const char *arguments = NULL;
+   std::string::size_type split = commandName.find_first_of(" \t");
+   if (split != std::string::npos) {
+      arguments = command+split+1;
+      commandName.erase(split);
+   }
+   if (evalTclCommand(tclInterpreter, commandName.c_str(), arguments) != 0) {
       print("FlashProgrammer::runTCLCommand(): TCL Command '%s' failed\n", command);
       return PROGRAMMING_RC_ERROR_TCL_SCRIPT;
    }
@@ -2095,9 +2468,34 @@ USBDM_ErrorCode FlashProgrammer::runTCLCommand(const char *command) {
    return PROGRAMMING_RC_OK;
 }
 
+//! Identifies a TCL interpreter in the pool - target type, (script CRC, script size)
+typedef std::pair<TargetType_t, std::pair<uint32_t, unsigned> > TclPoolKey;
+
+//! TCL interpreters that have already loaded flash scripts.
+//! These are shared by all FlashProgrammer instances until releaseTclInterpreterPool() is called.
+typedef std::map<TclPoolKey, Tcl_Interp *> TclInterpreterPool;
+static TclInterpreterPool tclInterpreterPool;
+
+//=======================================================================
+//! Release the TCL interpreters retained for re-use
+//!
+//! @note Must be called before TCL is torn down e.g. when the GDI or application closes.
+//!       Any FlashProgrammer still using a pooled interpreter must be released first.
+//!
+USBDM_ErrorCode FlashProgrammer::releaseTclInterpreterPool(void) {
+   for (TclInterpreterPool::iterator it = tclInterpreterPool.begin(); it != tclInterpreterPool.end(); ++it) {
+      freeTclInterpreter(it->second);
+   }
+   tclInterpreterPool.clear();
+   return PROGRAMMING_RC_OK;
+}
+
 //=======================================================================
 // Initialises TCL support for current target
 //
+// An interpreter that has already loaded the same script is re-used if available.
+// Its global variables and procs are reset to those present after loading the script.
+//
 USBDM_ErrorCode FlashProgrammer::initTCL(void) {
 
 //   print("FlashProgrammer::initTCL()\n");
@@ -2108,6 +2506,22 @@ USBDM_ErrorCode FlashProgrammer::initTCL(void) {
 	  
    useTCLScript = false;
 
+   TclScriptPtr script = parameters.getFlashScripts();
+   TclPoolKey   poolKey;
+   if (script) {
+      const std::string &scriptText = script->getScript();
+      Crc32 crc;
+      crc.add((const uint8_t *)scriptText.data(), (unsigned)scriptText.size());
+      poolKey = TclPoolKey(TARGET_TYPE, std::make_pair(crc.getValue(), (unsigned)scriptText.size()));
+      TclInterpreterPool::iterator it = tclInterpreterPool.find(poolKey);
+      if (it != tclInterpreterPool.end()) {
+         print("FlashProgrammer::initTCL() - re-using TCL interpreter\n");
+         tclInterpreter = it->second;
+         reuseTclInterpreter(tclInterpreter, TARGET_TYPE, getLogFileHandle());
+         useTCLScript = true;
+         return PROGRAMMING_RC_OK;
+      }
+   }
 //   FILE *fp = fopen("c:/delme.log", "wt");
 //   tclInterpreter = createTclInterpreter(TARGET_TYPE, fp);
    tclInterpreter = createTclInterpreter(TARGET_TYPE, getLogFileHandle());
@@ -2116,7 +2530,6 @@ USBDM_ErrorCode FlashProgrammer::initTCL(void) {
       return PROGRAMMING_RC_ERROR_TCL_SCRIPT;
    }
    // Run initial TCL script (loads routines)
-   TclScriptPtr script = parameters.getFlashScripts();
    if (!script) {
       print("FlashProgrammer::initTCL() - no TCL script found\n");
       return PROGRAMMING_RC_ERROR_TCL_SCRIPT;
@@ -2130,6 +2543,10 @@ USBDM_ErrorCode FlashProgrammer::initTCL(void) {
       print("FlashProgrammer::initTCL() - runTCLScript() failed\n");
       return rc;
    }
+   // Routines are now loaded - make available for re-use
+   // Script globals are returned to this state when the interpreter is re-used
+   saveTclInterpreterState(tclInterpreter);
+   tclInterpreterPool[poolKey] = tclInterpreter;
    useTCLScript = true;
    return PROGRAMMING_RC_OK;
 }
@@ -2137,9 +2554,14 @@ USBDM_ErrorCode FlashProgrammer::initTCL(void) {
 //=======================================================================
 //  Release the current TCL interpreter
 //
+//  Interpreters from the pool are retained for re-use
+//
 USBDM_ErrorCode FlashProgrammer::releaseTCL(void) {
    if (tclInterpreter != NULL) {
-      freeTclInterpreter(tclInterpreter);
+      if (!useTCLScript) {
+         // Not in pool
+         freeTclInterpreter(tclInterpreter);
+      }
       tclInterpreter = NULL;
    }
    return PROGRAMMING_RC_OK;
@@ -2205,8 +2627,14 @@ USBDM_ErrorCode FlashProgrammer::doFlashBlock(FlashImage     *flashImage,
       uint32_t lastContiguous;
       if (memoryRegionPtr->findLastContiguous((flashAddress-offset), &lastContiguous, memorySpace)) {
          lastContiguous = lastContiguous + offset; // Convert to last byte
+#if (TARGET == CFV1) || (TARGET == ARM)
+         // EEEPROM data in the FlexRAM window is written directly
+         bool flexRAM = (memoryRegionPtr->getMemoryType() == MemFlexRAM);
+#else
+         bool flexRAM = false;
+#endif
          // Check if programmable
-         if (!memoryRegionPtr->isProgrammableMemory()) {
+         if (!memoryRegionPtr->isProgrammableMemory() && !flexRAM) {
                print("FlashProgrammer::doFlashBlock() - Block not programmable memory\n");
                return PROGRAMMING_RC_ERROR_OUTSIDE_TARGET_FLASH;
          }
@@ -2223,6 +2651,13 @@ USBDM_ErrorCode FlashProgrammer::doFlashBlock(FlashImage     *flashImage,
             return rc;
          }
          else {
+#if (TARGET == CFV1) || (TARGET == ARM)
+            if (flexRAM) {
+               USBDM_ErrorCode rc = doFlexRAMBlock(flashImage, flashAddress, blockSize, flashOperation);
+               flashAddress += blockSize;
+               return rc;
+            }
+#endif
             // Check if programmable
             if (!memoryRegionPtr->isProgrammableMemory()) {
                if (((memoryRegionPtr->getMemoryType() == MemRAM) ||
@@ -2266,6 +2701,22 @@ USBDM_ErrorCode FlashProgrammer::doFlashBlock(FlashImage     *flashImage,
    if (rc != PROGRAMMING_RC_OK) {
       return rc;
    }
+   // Block for any separate verify
+   uint32_t programStart = flashAddress;
+   unsigned programSize  = blockSize;
+   if ((flashOperation == OpProgram) && ((targetProgramInfo.programOperation&DO_BLANK_CHECK_RANGE) == 0)) {
+      // Flash code only programs - blank check this block first
+      if (parameters.isParanoidBlankCheck() || !isErased(flashAddress, flashAddress+blockSize-1)) {
+         uint32_t blankCheckAddress = flashAddress;
+         rc = doFlashBlock(flashImage, blockSize, blankCheckAddress, OpBlankCheck);
+         if (rc == PROGRAMMING_RC_OK) {
+            rc = loadTargetProgram(memoryRegionPtr->getFlashprogram(), flashOperation);
+         }
+         if (rc != PROGRAMMING_RC_OK) {
+            return rc;
+         }
+      }
+   }
    // Maximum split block size must be made less than buffer RAM available
    unsigned int maxSplitBlockSize = targetProgramInfo.maxDataSize;
 
@@ -2395,6 +2846,10 @@ USBDM_ErrorCode FlashProgrammer::doFlashBlock(FlashImage     *flashImage,
       oddBytes       = 0; // No odd bytes on subsequent blocks
       progressTimer->progress(splitBlockSize*sizeof(memoryElementType), NULL);
    }
+   if ((flashOperation == OpProgram) && ((targetProgramInfo.programOperation&DO_VERIFY_RANGE) == 0)) {
+      // Flash code doesn't verify when programming - verify this block by read-back
+      return doReadbackVerify(flashImage, programStart, programSize);
+   }
    return PROGRAMMING_RC_OK;
 }
 
@@ -2446,35 +2901,74 @@ USBDM_ErrorCode FlashProgrammer::applyFlashOperation(FlashImage     *flashImage,
 //!
 //! @return error code see \ref USBDM_ErrorCode
 //!
+//! @note Each block is blank checked, programmed and verified by a single execution
+//!       of the flash code with the data already in target RAM.  Where the flash code
+//!       for a region only programs, doFlashBlock() blank checks and verifies that block
+//!       separately.
+//!
 USBDM_ErrorCode FlashProgrammer::doProgram(FlashImage *flashImage) {
    print("FlashProgrammer::doProgram()\n");
 
-   // Load target flash code to check programming options
-   flashOperationInfo.alignment = 2;
-   loadTargetProgram(OpBlankCheck);
-   USBDM_ErrorCode rc;
-   if ((targetProgramInfo.programOperation&DO_BLANK_CHECK_RANGE) == 0) {
-      // Do separate blank check if not done by program operation
-      rc = doBlankCheck(flashImage);
+   progressTimer->restart("Programming && Verifying...");
+   USBDM_ErrorCode rc = applyFlashOperation(flashImage, OpProgram);
+   if (rc != PROGRAMMING_RC_OK) {
+      print("FlashProgrammer::doProgram() - Programming failed, Reason= %s\n", USBDM_GetErrorString(rc));
    }
-   if ((targetProgramInfo.programOperation&DO_VERIFY_RANGE) == 0) {
-      progressTimer->restart("Programming");
+   // Programmed areas are no longer erased
+   clearErasedRanges();
+   return rc;
+}
+
+//==============================================================================
+//! Get information about the flash memory range containing an address
+//!
+//! @param address          Address to look up (flash image address)
+//! @param memoryRegionPtr  Memory region containing address
+//! @param rangeStart       Start of memory range containing address (flash image address)
+//! @param rangeEnd         End of memory range containing address (flash image address)
+//! @param sectorSize       Sector size of region
+//!
+//! @return true  => address is within programmable memory with known sector size \n
+//!         false => address is not within flash
+//!
+bool FlashProgrammer::getFlashSectorInfo(uint32_t         address,
+                                         MemoryRegionPtr &memoryRegionPtr,
+                                         uint32_t        &rangeStart,
+                                         uint32_t        &rangeEnd,
+                                         uint32_t        &sectorSize) {
+   MemorySpace_t memorySpace = MS_None;
+   uint32_t      offset      = 0;
+#if (TARGET == MC56F80xx)
+   if (address >= FlashImage::DataOffset) {
+      memorySpace = MS_Data;
+      offset      = FlashImage::DataOffset;
    }
    else {
-      progressTimer->restart("Programming && Verifying...");
+      memorySpace = MS_Program;
    }
-   rc = applyFlashOperation(flashImage, OpProgram);
-   if (rc != PROGRAMMING_RC_OK) {
-      print("FlashProgrammer::doProgram() - Programming failed, Reason= %s\n", USBDM_GetErrorString(rc));
+#endif
+   memoryRegionPtr = parameters.getMemoryRegionFor(address-offset, memorySpace);
+   if (!memoryRegionPtr || !memoryRegionPtr->isProgrammableMemory()) {
+      return false;
    }
-   if ((targetProgramInfo.programOperation&DO_VERIFY_RANGE) == 0) {
-      // Do separate verify operation
-      progressTimer->restart("Verifying...");
-      rc = doVerify(flashImage);
+   const MemoryRegion::MemoryRange *memoryRange = memoryRegionPtr->getMemoryRangeFor(address-offset);
+   sectorSize = memoryRegionPtr->getSectorSize();
+   if ((memoryRange == NULL) || (sectorSize == 0)) {
+      return false;
    }
-   return rc;
+   rangeStart = memoryRange->start+offset;
+   rangeEnd   = memoryRange->end+offset;
+   return true;
 }
 
+//! Sector aligned range of flash to erase
+struct EraseRange {
+   MemoryRegionPtr memoryRegionPtr;  //!< Region containing range (NULL if not flash)
+   uint32_t        start;            //!< Start of range
+   uint32_t        end;              //!< End of range (inclusive)
+   uint32_t        rangeStart;       //!< Start of memory range containing the range
+};
+
 //==============================================================================
 //! Selective erase target.  Area erased is determined from flash image
 //!
@@ -2482,21 +2976,170 @@ USBDM_ErrorCode FlashProgrammer::doProgram(FlashImage *flashImage) {
 //!
 //! @return error code see \ref USBDM_ErrorCode
 //!
-//! Todo This is sub-optimal as it may erase the same sector multiple times.
+//! The occupied blocks of the image are mapped onto the sectors of the
+//! memory regions.  Sectors are only erased once and adjacent sectors are
+//! merged so that each range is erased by a single execution of the flash code.
+//! A region that is entirely covered is erased using a block erase.
 //!
 USBDM_ErrorCode FlashProgrammer::doSelectiveErase(FlashImage *flashImage) {
 
    print("FlashProgrammer::doSelectiveErase()\n");
    progressTimer->restart("Selective Erasing...");
 
-   USBDM_ErrorCode rc;
-   rc = applyFlashOperation(flashImage, OpSelectiveErase);
+   std::vector<EraseRange> eraseRanges;
+   FlashImage::Enumerator *enumerator = flashImage->getEnumerator();
+
+   // Create list of sector aligned ranges to erase
+   while (enumerator->isValid()) {
+      // Find occupied block [startBlock..endBlock]
+      uint32_t startBlock = enumerator->getAddress();
+      enumerator->lastValid();
+      uint32_t endBlock = enumerator->getAddress();
+      enumerator->setAddress(endBlock+1);
+
+      EraseRange eraseRange;
+      uint32_t   rangeEnd, sectorSize;
+      if (getFlashSectorInfo(startBlock, eraseRange.memoryRegionPtr, eraseRange.rangeStart, rangeEnd, sectorSize)) {
+         // Extend to sector boundaries
+         eraseRange.start = startBlock-((startBlock-eraseRange.rangeStart)%sectorSize);
+         eraseRange.end   = endBlock-((endBlock-eraseRange.rangeStart)%sectorSize)+sectorSize-1;
+         if (eraseRange.end > rangeEnd) {
+            eraseRange.end = rangeEnd;
+         }
+      }
+      else {
+         // Not flash - leave for doFlashBlock() to report
+         eraseRange.memoryRegionPtr.reset();
+         eraseRange.rangeStart = startBlock;
+         eraseRange.start      = startBlock;
+         eraseRange.end        = endBlock;
+      }
+      if (!eraseRanges.empty()) {
+         EraseRange &last = eraseRanges.back();
+         if ((last.memoryRegionPtr == eraseRange.memoryRegionPtr) &&
+             (last.rangeStart == eraseRange.rangeStart) &&
+             (last.end+1 >= eraseRange.start)) {
+            // Merge with previous range (removes duplicate sectors)
+            if (eraseRange.end > last.end) {
+               last.end = eraseRange.end;
+            }
+            continue;
+         }
+      }
+      eraseRanges.push_back(eraseRange);
+   }
+   delete enumerator;
+
+   USBDM_ErrorCode rc = PROGRAMMING_RC_OK;
+   std::vector<EraseRange>::iterator it;
+   for (it = eraseRanges.begin(); (rc == PROGRAMMING_RC_OK) && (it != eraseRanges.end()); it++) {
+      MemoryRegionPtr memoryRegionPtr = it->memoryRegionPtr;
+      if (memoryRegionPtr) {
+         // Check if entire region is to be erased
+         uint32_t regionSize = 0;
+         for (unsigned index=0; memoryRegionPtr->getMemoryRange(index) != NULL; index++) {
+            const MemoryRegion::MemoryRange *memoryRange = memoryRegionPtr->getMemoryRange(index);
+            regionSize += memoryRange->end-memoryRange->start+1;
+         }
+         uint32_t eraseSize  = 0;
+         bool     firstRange = true;
+         std::vector<EraseRange>::iterator other;
+         for (other = eraseRanges.begin(); other != eraseRanges.end(); other++) {
+            if (other->memoryRegionPtr == memoryRegionPtr) {
+               eraseSize += other->end-other->start+1;
+               if (other < it) {
+                  firstRange = false;
+               }
+            }
+         }
+         if (eraseSize == regionSize) {
+            if (firstRange) {
+               // Only do block erase once for the region
+               print("FlashProgrammer::doSelectiveErase() - Block erasing %s\n", memoryRegionPtr->getMemoryTypeName());
+               rc = eraseFlashRegion(memoryRegionPtr);
+            }
+            continue;
+         }
+      }
+      print("FlashProgrammer::doSelectiveErase() - Erasing [0x%06X..0x%06X]\n", it->start, it->end);
+      uint32_t startBlock = it->start;
+      rc = doFlashBlock(flashImage, it->end-it->start+1, startBlock, OpSelectiveErase);
+      if ((rc == PROGRAMMING_RC_OK) && memoryRegionPtr) {
+         markErased(it->start, it->end);
+      }
+   }
    if (rc != PROGRAMMING_RC_OK) {
       print("FlashProgrammer::doSelectiveErase() - Selective erase failed, Reason= %s\n", USBDM_GetErrorString(rc));
    }
    return rc;
 }
 
+//==================================================================================
+//! doReadbackVerify - Verifies a range of Target memory against memory image
+//!
+//! @param flashImage  Description of flash contents to be verified.
+//! @param startBlock  Start address of range to verify
+//! @param regionSize  Size of range to verify (in memoryElementType)
+//!
+//! @return error code see \ref USBDM_ErrorCode
+//!
+//! @note Assumes target connection has been established
+//! @note Unoccupied locations in the flash image are not checked.
+//!
+USBDM_ErrorCode FlashProgrammer::doReadbackVerify(FlashImage *flashImage, uint32_t startBlock, uint32_t regionSize) {
+   const unsigned MAX_BUFFER=0x800;
+   memoryElementType buffer[MAX_BUFFER];
+   int checkResult = TRUE;
+   int blockResult;
+
+#if (TARGET==HCS08)||(TARGET==HC12)
+   USBDM_ErrorCode rc = setPageRegisters(startBlock);
+   if (rc != PROGRAMMING_RC_OK) {
+      return rc;
+   }
+#endif
+   print("FlashProgrammer::doReadbackVerify() - Verifying Block[0x%8.8X..0x%8.8X]\n", startBlock, startBlock+regionSize-1);
+   MemorySpace_t memorySpace = MS_Byte;
+   while (regionSize>0) {
+      unsigned blockSize = regionSize;
+      if (blockSize > MAX_BUFFER) {
+         blockSize = MAX_BUFFER;
+      }
+      if (ReadMemory(memorySpace, blockSize*sizeof(memoryElementType), startBlock, (uint8_t *)buffer) != BDM_RC_OK) {
+         return PROGRAMMING_RC_ERROR_BDM_READ;
+      }
+      blockResult = TRUE;
+      uint32_t testIndex;
+      for (testIndex=0; testIndex<blockSize; testIndex++) {
+         if (flashImage->isValid(startBlock+testIndex) &&
+             (flashImage->getValue(startBlock+testIndex) != buffer[testIndex])) {
+            if (blockResult) {
+               print("FlashProgrammer::doReadbackVerify() - Verifying location[0x%8.8X]=>failed, image=%2.2X != target=%2.2X\n",
+                     startBlock+testIndex,
+                     flashImage->getValue(startBlock+testIndex),
+                     buffer[testIndex]);
+            }
+            blockResult = FALSE;
+#ifndef LOG
+            break;
+#endif
+         }
+      }
+      print("FlashProgrammer::doReadbackVerify() - Verifying Sub-block[0x%8.8X..0x%8.8X]=>%s\n",
+            startBlock, startBlock+blockSize-1,blockResult?"OK":"FAIL");
+      checkResult = checkResult && blockResult;
+      regionSize -= blockSize;
+      startBlock += blockSize;
+      progressTimer->progress(blockSize, NULL);
+#ifndef LOG
+      if (!checkResult) {
+         break;
+      }
+#endif
+   }
+   return checkResult?PROGRAMMING_RC_OK:PROGRAMMING_RC_ERROR_FAILED_VERIFY;
+}
+
 //==================================================================================
 //! doReadbackVerify - Verifies the Target memory against memory image
 //!
@@ -2511,73 +3154,30 @@ USBDM_ErrorCode FlashProgrammer::doSelectiveErase(FlashImage *flashImage) {
 //!       locations are ignored.
 //!
 USBDM_ErrorCode FlashProgrammer::doReadbackVerify(FlashImage *flashImage) {
-   const unsigned MAX_BUFFER=0x800;
-   memoryElementType buffer[MAX_BUFFER];
-   int checkResult = TRUE;
-   int blockResult;
+   USBDM_ErrorCode rc = PROGRAMMING_RC_OK;
    print("FlashProgrammer::doReadbackVerify()\n");
 
    FlashImage::Enumerator *enumerator = flashImage->getEnumerator();
 
    while (enumerator->isValid()) {
       uint32_t startBlock = enumerator->getAddress();
-#if (TARGET==HCS08)||(TARGET==HC12)
-      USBDM_ErrorCode rc = setPageRegisters(startBlock);
-      if (rc != PROGRAMMING_RC_OK) {
-         return rc;
-      }
-#endif
       // Find end of block to verify
       enumerator->lastValid();
       unsigned regionSize = enumerator->getAddress() - startBlock + 1;
-      print("FlashProgrammer::doReadbackVerify() - Verifying Block[0x%8.8X..0x%8.8X]\n", startBlock, startBlock+regionSize-1);
-      MemorySpace_t memorySpace = MS_Byte;
-      while (regionSize>0) {
-         unsigned blockSize = regionSize;
-         if (blockSize > MAX_BUFFER) {
-            blockSize = MAX_BUFFER;
-         }
-         if (ReadMemory(memorySpace, blockSize*sizeof(memoryElementType), startBlock, (uint8_t *)buffer) != BDM_RC_OK) {
-            return PROGRAMMING_RC_ERROR_BDM_READ;
-         }
-         blockResult = TRUE;
-         uint32_t testIndex;
-         for (testIndex=0; testIndex<blockSize; testIndex++) {
-            if (flashImage->getValue(startBlock+testIndex) != buffer[testIndex]) {
-               blockResult = FALSE;
-#ifndef LOG
-               break;
-#endif
-//               print("Verifying location[0x%8.8X]=>failed, image=%2.2X != target=%2.2X\n",
-//                     startBlock+testIndex,
-//                     (uint8_t)(flashImage->getValue(startBlock+testIndex]),
-//                     buffer[testIndex]);
-            }
-         }
-         print("FlashProgrammer::doReadbackVerify() - Verifying Sub-block[0x%8.8X..0x%8.8X]=>%s\n",
-               startBlock, startBlock+blockSize-1,blockResult?"OK":"FAIL");
-         checkResult = checkResult && blockResult;
-         regionSize -= blockSize;
-         startBlock += blockSize;
-         progressTimer->progress(blockSize, NULL);
-#ifndef LOG
-         if (!checkResult) {
-            break;
-         }
+      USBDM_ErrorCode blockRc = doReadbackVerify(flashImage, startBlock, regionSize);
+      if (blockRc != PROGRAMMING_RC_OK) {
+         rc = blockRc;
+#ifdef LOG
+         // Report all failing blocks when logging
+         if (blockRc != PROGRAMMING_RC_ERROR_FAILED_VERIFY)
 #endif
-      }
-#ifndef LOG
-      if (!checkResult) {
          break;
       }
-#endif
       // Advance to start of next occupied region
       enumerator->nextValid();
    }
-   if (enumerator != NULL)
-      delete enumerator;
-
-   return checkResult?PROGRAMMING_RC_OK:PROGRAMMING_RC_ERROR_FAILED_VERIFY;
+   delete enumerator;
+   return rc;
 }
 
 //==============================================================================
@@ -2621,25 +3221,6 @@ USBDM_ErrorCode FlashProgrammer::doVerify(FlashImage *flashImage) {
    return rc;
 }
 
-//==============================================================================
-//! Blank check target against flash image
-//!
-//! @param flashImage - Flash image to verify
-//!
-//! @return error code see \ref USBDM_ErrorCode
-//!
-USBDM_ErrorCode FlashProgrammer::doBlankCheck(FlashImage *flashImage) {
-
-   print("FlashProgrammer::doBlankCheck()\n");
-   progressTimer->restart("Blank Checking...");
-
-   USBDM_ErrorCode rc = applyFlashOperation(flashImage, OpBlankCheck);
-   if (rc != PROGRAMMING_RC_OK) {
-      print("FlashProgrammer::doBlankCheck() - Blank check failed, Reason= %s\n", USBDM_GetErrorString(rc));
-   }
-   return rc;
-}
-
 //==============================================================================
 //! Write RAM portion of image
 //!
@@ -2824,6 +3405,7 @@ USBDM_ErrorCode FlashProgrammer::programFlash(FlashImage  *flashImage,
 
    flashReady = FALSE;
    currentFlashProgram.reset();
+   clearErasedRanges();
 
    rc = initTCL();
    if (rc != PROGRAMMING_RC_OK) {
@@ -2899,6 +3481,13 @@ USBDM_ErrorCode FlashProgrammer::programFlash(FlashImage  *flashImage,
       if (rc != PROGRAMMING_RC_OK) {
          return rc;
       }
+      // Everything is now erased
+      for (int index=0; parameters.getMemoryRegion(index) != NULL; index++) {
+         MemoryRegionPtr memoryRegionPtr = parameters.getMemoryRegion(index);
+         if (memoryRegionPtr->isProgrammableMemory()) {
+            markRegionErased(memoryRegionPtr);
+         }
+      }
    }
    // Program EEPROM/DFLASH Split
    rc = partitionFlexNVM();
@@ -2958,6 +3547,165 @@ USBDM_ErrorCode FlashProgrammer::programFlash(FlashImage  *flashImage,
    return rc;
 }
 
+//=======================================================================
+//! Trim the target clock and program only the non-volatile trim locations
+//!
+//! @param progressCallBack  - Callback function to indicate progress
+//!
+//! @return error code see \ref USBDM_ErrorCode
+//!
+//! @note Assumes the target device has already been opened & USBDM options set.
+//! @note If the trim locations are unprogrammed then only they are programmed.
+//!       Otherwise, only if selective erase has been selected, the flash sector containing
+//!       them is read, erased and reprogrammed with the new trim values.  The security
+//!       area (if in the sector) is programmed first to minimise the time the device
+//!       would be secured if interrupted.
+//!
+USBDM_ErrorCode FlashProgrammer::programTrimValue(CallBackT progressCallBack) {
+   USBDM_ErrorCode rc;
+   if ((this == NULL) || (parameters.getTargetName().empty())) {
+      print("FlashProgrammer::programTrimValue() - Error: device parameters not set\n");
+      return PROGRAMMING_RC_ERROR_INTERNAL_CHECK_FAILED;
+   }
+   const uint32_t trimAddress = parameters.getClockTrimNVAddress();
+   print("===========================================================\n"
+         "FlashProgrammer::programTrimValue()\n"
+         "\tprogressCallBack = %p\n"
+         "\tDevice = \'%s\'\n"
+         "\tTrim, F=%ld, NVA@%4.4X, clock@%4.4X\n",
+         progressCallBack,
+         parameters.getTargetName().c_str(),
+         parameters.getClockTrimFreq(),
+         trimAddress,
+         parameters.getClockAddress());
+
+   if ((parameters.getClockTrimFreq() == 0) || (trimAddress == 0)) {
+      print("FlashProgrammer::programTrimValue() - Error: trim frequency and NV location required\n");
+      return PROGRAMMING_RC_ERROR_ILLEGAL_PARAMS;
+   }
+   this->doRamWrites = false;
+   if (progressTimer != NULL) {
+      delete progressTimer;
+   }
+   progressTimer = new ProgressTimer(progressCallBack, 0);
+   progressTimer->restart("Initialising...");
+
+   flashReady = FALSE;
+   currentFlashProgram.reset();
+   clearErasedRanges();
+
+   rc = initTCL();
+   if (rc != PROGRAMMING_RC_OK) {
+      return rc;
+   }
+   // Connect to target
+   rc = resetAndConnectTarget();
+   if (rc != PROGRAMMING_RC_OK) {
+      return rc;
+   }
+   rc = checkTargetUnSecured();
+   if (rc != PROGRAMMING_RC_OK) {
+      return rc;
+   }
+   rc = confirmSDID();
+   if (rc != PROGRAMMING_RC_OK) {
+      return rc;
+   }
+   // Locate flash sector containing the trim locations
+   MemoryRegionPtr memoryRegionPtr;
+   uint32_t        rangeStart, rangeEnd, sectorSize;
+   if (!getFlashSectorInfo(trimAddress, memoryRegionPtr, rangeStart, rangeEnd, sectorSize)) {
+      print("FlashProgrammer::programTrimValue() - Error: trim location is not within flash\n");
+      return PROGRAMMING_RC_ERROR_ILLEGAL_PARAMS;
+   }
+   uint32_t sectorStart = trimAddress-((trimAddress-rangeStart)%sectorSize);
+   uint32_t sectorEnd   = sectorStart+sectorSize-1;
+   if (sectorEnd > rangeEnd) {
+      sectorEnd = rangeEnd;
+   }
+   // Read present contents of sector
+   std::vector<uint8_t> sectorData(sectorEnd-sectorStart+1);
+   if (ReadMemory(MS_Byte, (unsigned)sectorData.size(), sectorStart, &sectorData[0]) != BDM_RC_OK) {
+      return PROGRAMMING_RC_ERROR_BDM_READ;
+   }
+   // Check if the trim locations are unprogrammed
+   // This includes any other bytes in the same flash programming unit as these are reprogrammed
+   uint32_t alignMask = memoryRegionPtr->getAlignment()-1;
+   uint32_t trimStart = trimAddress&~alignMask;
+   uint32_t trimEnd   = (trimAddress+1)|alignMask;
+   if (trimStart < sectorStart) {
+      trimStart = sectorStart;
+   }
+   if (trimEnd > sectorEnd) {
+      trimEnd = sectorEnd;
+   }
+   bool trimBlank = true;
+   for (uint32_t address=trimStart; address<=trimEnd; address++) {
+      if (sectorData[address-sectorStart] != 0xFF) {
+         trimBlank = false;
+         break;
+      }
+   }
+   if (!trimBlank && (parameters.getEraseOption() != DeviceData::eraseSelective)) {
+      print("FlashProgrammer::programTrimValue() - Error: trim locations are programmed & selective erase not selected\n");
+      return PROGRAMMING_RC_ERROR_NOT_BLANK;
+   }
+   // Security area (if any) is programmed separately before the rest of the sector
+   uint32_t        securityStart   = 1;
+   uint32_t        securityEnd     = 0;
+   uint32_t        securityAddress = memoryRegionPtr->getSecurityAddress();
+   SecurityInfoPtr securityInfo    = memoryRegionPtr->getSecureInfo();
+   if (!trimBlank && (securityAddress != 0) && (securityInfo != NULL)) {
+      securityStart = securityAddress&~alignMask;
+      securityEnd   = (securityAddress+securityInfo->getSize()-1)|alignMask;
+   }
+   // Image of either the trim locations or entire sector
+   FlashImage trimImage;
+   FlashImage securityImage;
+   if (!trimBlank) {
+      trimStart = sectorStart;
+      trimEnd   = sectorEnd;
+   }
+   for (uint32_t address=trimStart; address<=trimEnd; address++) {
+      if ((address >= securityStart) && (address <= securityEnd)) {
+         securityImage.setValue(address, sectorData[address-sectorStart]);
+      }
+      else {
+         trimImage.setValue(address, sectorData[address-sectorStart]);
+      }
+   }
+   // Calculate clock trim values & update memory image
+   rc = setFlashTrimValues(&trimImage);
+   if (rc != PROGRAMMING_RC_OK) {
+      return rc;
+   }
+   // Set up for Flash operations (clock etc)
+   rc = initialiseTargetFlash();
+   if (rc != PROGRAMMING_RC_OK) {
+      return rc;
+   }
+   if (!trimBlank) {
+      print("FlashProgrammer::programTrimValue() - Reprogramming sector [0x%06X..0x%06X]\n", sectorStart, sectorEnd);
+      rc = doSelectiveErase(&trimImage);
+      if (rc != PROGRAMMING_RC_OK) {
+         return rc;
+      }
+      if (securityImage.getByteCount() > 0) {
+         // Restore security area first
+         rc = doProgram(&securityImage);
+         if (rc != PROGRAMMING_RC_OK) {
+            return rc;
+         }
+      }
+   }
+   rc = doProgram(&trimImage);
+
+   uint16_t trimValue = parameters.getClockTrimValue();
+   print("FlashProgrammer::programTrimValue() - Device Trim Value = %2.2X.%1X, Time = %3.2f s, rc = %d\n",
+         trimValue>>1, trimValue&0x01, progressTimer->elapsedTime(), rc);
+   return rc;
+}
+
 //=======================================================================
 //! Set device data for flash operations
 //!
@@ -2967,6 +3715,7 @@ USBDM_ErrorCode FlashProgrammer::programFlash(FlashImage  *flashImage,
 //!
 USBDM_ErrorCode FlashProgrammer::setDeviceData(const DeviceData  &theParameters) {
    currentFlashProgram.reset();
+   flashDriverCache.clear();
    parameters = theParameters;
    print("FlashProgrammer::setDeviceData(%s)\n", parameters.getTargetName().c_str());
    releaseTCL();
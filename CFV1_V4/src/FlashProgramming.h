@@ -131,6 +131,12 @@ private:
    } ;
    typedef USBDM_ErrorCode (*CallBackT)(USBDM_ErrorCode status, int percent, const char *message);
 
+   //! Flash driver converted from S-record form
+   struct FlashDriverImage {
+      std::vector<memoryElementType> image;        //!< Binary image of driver
+      uint32_t                       loadAddress;  //!< Where image is located in target memory
+   };
+
    DeviceData              parameters;               //!< Parameters describing the target device
    Tcl_Interp              *tclInterpreter;          //!< TCL interpreter
    bool                    useTCLScript;
@@ -142,8 +148,10 @@ private:
    FlashProgramPtr         currentFlashProgram;
    FlashOperation          currentFlashOperation;
    uint32_t                currentFlashAlignment;
+   std::map<FlashProgramPtr, FlashDriverImage> flashDriverCache; //!< Flash drivers already converted from S-records
    ProgressTimer          *progressTimer;
    bool                    doRamWrites;
+   std::map<uint32_t,uint32_t> erasedRanges;     //!< Flash known to be erased this session, start=>end (flash image addresses)
 
    USBDM_ErrorCode initialiseTargetFlash();
    USBDM_ErrorCode initialiseTarget();
@@ -169,6 +177,11 @@ private:
    USBDM_ErrorCode configureTargetClock(unsigned long  *busFrequency);
    USBDM_ErrorCode configureExternal_Clock(unsigned long  *busFrequency);
    USBDM_ErrorCode eraseFlash(void);
+   USBDM_ErrorCode eraseFlashRegion(MemoryRegionPtr memoryRegionPtr);
+   void            clearErasedRanges(void);
+   void            markErased(uint32_t start, uint32_t end);
+   void            markRegionErased(MemoryRegionPtr memoryRegionPtr);
+   bool            isErased(uint32_t start, uint32_t end);
    USBDM_ErrorCode convertTargetErrorCode(FlashDriverError_t rc);
    USBDM_ErrorCode initSmallTargetBuffer(memoryElementType *buffer);
    USBDM_ErrorCode initLargeTargetBuffer(memoryElementType *buffer);
@@ -181,14 +194,20 @@ private:
    USBDM_ErrorCode selectiveEraseFlashSecurity(void);
    USBDM_ErrorCode doTargetVerify(FlashImage *flashImage);
    USBDM_ErrorCode doReadbackVerify(FlashImage *flashImage);
+   USBDM_ErrorCode doReadbackVerify(FlashImage *flashImage, uint32_t startBlock, uint32_t regionSize);
    USBDM_ErrorCode applyFlashOperation(FlashImage *flashImage, FlashOperation flashOperation);
    USBDM_ErrorCode doVerify(FlashImage *flashImage);
    USBDM_ErrorCode doSelectiveErase(FlashImage  *flashImage);
+   bool            getFlashSectorInfo(uint32_t         address,
+                                      MemoryRegionPtr &memoryRegionPtr,
+                                      uint32_t        &rangeStart,
+                                      uint32_t        &rangeEnd,
+                                      uint32_t        &sectorSize);
    USBDM_ErrorCode doProgram(FlashImage  *flashImage);
-   USBDM_ErrorCode doBlankCheck(FlashImage *flashImage);
    USBDM_ErrorCode doWriteRam(FlashImage *flashImage);
    USBDM_ErrorCode loadTargetProgram(FlashOperation flashOperation);
    USBDM_ErrorCode loadTargetProgram(FlashProgramPtr flashProgram, FlashOperation flashOperation);
+   USBDM_ErrorCode getFlashDriverImage(FlashProgramPtr flashProgram, const FlashDriverImage **flashDriverImage);
    USBDM_ErrorCode loadSmallTargetProgram(memoryElementType *buffer,
                                           uint32_t           loadAddress,
                                           uint32_t           size,
@@ -201,11 +220,19 @@ private:
                                           FlashOperation     flashOperation);
    USBDM_ErrorCode probeMemory(MemorySpace_t memorySpace, uint32_t address);
    USBDM_ErrorCode dummyTrimLocations(FlashImage *flashImage);
+   USBDM_ErrorCode waitFlashControllerIdle(uint32_t controller);
+   USBDM_ErrorCode executeFlashControllerCommand(uint32_t controller, uint32_t fccob[3]);
+   USBDM_ErrorCode readFlexNVMPartition(uint32_t controller, uint8_t *eeepromSize, uint8_t *partitionValue);
+   USBDM_ErrorCode doFlexRAMBlock(FlashImage    *flashImage,
+                                  uint32_t       address,
+                                  uint32_t       blockSize,
+                                  FlashOperation flashOperation);
    USBDM_ErrorCode partitionFlexNVM(void);
 
 public:
    USBDM_ErrorCode initTCL(void);
    USBDM_ErrorCode releaseTCL(void);
+   static USBDM_ErrorCode releaseTclInterpreterPool(void);
    USBDM_ErrorCode setDeviceData(const DeviceData  &theParameters);
    USBDM_ErrorCode checkTargetUnSecured();
    USBDM_ErrorCode runTCLScript(TclScriptPtr script);
@@ -213,6 +240,7 @@ public:
    USBDM_ErrorCode massEraseTarget();
    USBDM_ErrorCode programFlash(FlashImage *flashImage, CallBackT errorCallBack=NULL, bool doRamWrites=false);
    USBDM_ErrorCode verifyFlash(FlashImage  *flashImage, CallBackT errorCallBack=NULL);
+   USBDM_ErrorCode programTrimValue(CallBackT errorCallBack=NULL);
    USBDM_ErrorCode readTargetChipId(uint32_t *targetSDID, bool doInit=false);
    USBDM_ErrorCode confirmSDID(void);
    
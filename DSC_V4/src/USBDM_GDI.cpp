@@ -659,6 +659,7 @@ DiReturnT DiGdiClose ( DiBoolT fClose ) {
       delete flashProgrammer;
       flashProgrammer = NULL;
    }
+   FlashProgrammer::releaseTclInterpreterPool();
 #endif
    return DI_OK;
 }
@@ -0,0 +1,95 @@
+/*
+ * ARM_FlashDriver.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: agent
+ *
+ *  Interface between the host and the ARM target flash driver
+ *  (image header, data header, action flags, capabilities & error codes)
+ */
+
+#ifndef ARM_FLASHDRIVER_H_
+#define ARM_FLASHDRIVER_H_
+
+#include "Common.h"
+
+#pragma pack(1)
+//! Header at the start of flash programming code (describes flash code)
+struct LargeTargetImageHeader {
+   uint32_t         loadAddress;       // Address where to load this image
+   uint32_t         entry;             // Pointer to entry routine
+   uint32_t         capabilities;      // Capabilities of routine
+   uint32_t         reserved1;
+   uint32_t         reserved2;
+   uint32_t         flashData;         // Pointer to information about operation
+};
+
+//! Header at the start of flash programming buffer (controls program action)
+struct LargeTargetFlashDataHeader {
+   uint32_t         flags;             // Controls actions of routine
+   uint32_t         controller;        // Ptr to flash controller
+   uint32_t         frequency;         // Target frequency (kHz)
+   uint16_t         errorCode;         // Error code from action
+   uint16_t         sectorSize;        // Size of flash sectors (minimum erase size)
+   uint32_t         address;           // Memory address being accessed (reserved/page/address)
+   uint32_t         dataSize;          // Size of memory range being accessed
+   uint32_t         dataAddress;       // Ptr to data to program
+};
+
+struct ResultStruct {
+   uint32_t         flags;             // Incomplete actions of routine
+   uint32_t         reserved1;
+   uint32_t         reserved2;
+   uint16_t         errorCode;         // Error code from action
+};
+#pragma pack()
+
+//==============================================================================
+// Flag masks
+#define DO_INIT_FLASH         (1<<0) // Do initialisation of flash
+#define DO_ERASE_BLOCK        (1<<1) // Erase entire flash block e.g. Flash, FlexNVM etc
+#define DO_ERASE_RANGE        (1<<2) // Erase range (including option region)
+#define DO_BLANK_CHECK_RANGE  (1<<3) // Blank check region
+#define DO_PROGRAM_RANGE      (1<<4) // Program range (including option region)
+#define DO_VERIFY_RANGE       (1<<5) // Verify range
+#define DO_PARTITION_FLEXNVM  (1<<7) // Program FlexNVM DFLASH/EEPROM partitioning
+#define DO_TIMING_LOOP        (1<<8) // Counting loop to determine clock speed
+
+// 24-30 reserved
+#define IS_COMPLETE           (1U<<31)
+
+// Capability masks
+#define CAP_ERASE_BLOCK        (1<<1)
+#define CAP_ERASE_RANGE        (1<<2)
+#define CAP_BLANK_CHECK_RANGE  (1<<3)
+#define CAP_PROGRAM_RANGE      (1<<4)
+#define CAP_VERIFY_RANGE       (1<<5)
+#define CAP_PARTITION_FLEXNVM  (1<<7)
+#define CAP_TIMING             (1<<8)
+
+#define CAP_DSC_OVERLAY        (1<<11) // Indicates DSC code in pMEM overlays xRAM
+#define CAP_DATA_FIXED         (1<<12) // Indicates TargetFlashDataHeader is at fixed address
+#define CAP_RELOCATABLE        (1<<31) // Code may be relocated
+
+#define OPT_SMALL_CODE         (0x80)
+
+// Error codes return from the flash driver
+enum FlashDriverError_t {
+     FLASH_ERR_OK                = (0),
+     FLASH_ERR_LOCKED            = (1),  // Flash is still locked
+     FLASH_ERR_ILLEGAL_PARAMS    = (2),  // Parameters illegal
+     FLASH_ERR_PROG_FAILED       = (3),  // STM - Programming operation failed - general
+     FLASH_ERR_PROG_WPROT        = (4),  // STM - Programming operation failed - write protected
+     FLASH_ERR_VERIFY_FAILED     = (5),  // Verify failed
+     FLASH_ERR_ERASE_FAILED      = (6),  // Erase or Blank Check failed
+     FLASH_ERR_TRAP              = (7),  // Program trapped (illegal instruction/location etc.)
+     FLASH_ERR_PROG_ACCERR       = (8),  // Kinetis/CFVx - Programming operation failed - ACCERR
+     FLASH_ERR_PROG_FPVIOL       = (9),  // Kinetis/CFVx - Programming operation failed - FPVIOL
+     FLASH_ERR_PROG_MGSTAT0      = (10), // Kinetis - Programming operation failed - MGSTAT0
+     FLASH_ERR_CLKDIV            = (11), // CFVx - Clock divider not set
+     FLASH_ERR_ILLEGAL_SECURITY  = (12), // Kinetis - Illegal value for security location
+     FLASH_ERR_UNKNOWN           = (13), // Unspecified error
+     FLASH_ERR_TIMEOUT           = (14), // Timeout waiting for completion
+};
+
+#endif /* ARM_FLASHDRIVER_H_ */
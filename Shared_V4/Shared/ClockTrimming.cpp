@@ -27,12 +27,18 @@
 | Revision History
 +==============================================================================
 +-----------+------------------------------------------------------------------
+| 19 Oct 26 | 4.9.5 Trim history used to seed search
+| 19 Oct 26 | 4.9.5 Predicted trim with single verification
 | 13 Jun 12 | 4.9.5 Created                                               - pgo
 +==============================================================================
 \endverbatim
 */
 #include <math.h>
+#include <stdio.h>
+#include <string>
+#include <map>
 #include "Common.h"
+#include "ApplicationFiles.h"
 #include "ProgressTimer.h"
 #include "FlashProgramming.h"
 
@@ -311,9 +317,321 @@ USBDM_ErrorCode FlashProgrammer::configureTargetClock(unsigned long  *busFrequen
    return PROGRAMMING_RC_ERROR_ILLEGAL_PARAMS;
 }
 
+static const int maxTrim        = 505;   // Maximum acceptable trim value
+static const int minTrim        =   5;   // Minimum acceptable trim value
+
+//!  Writes a trim value to the target
+//!
+//!  @param      trimAddress           Address of trim register.
+//!  @param      trimValue             Trim value (9-bit number)
+//!  @param      do9BitTrim            True to write LSB as well (9-bit trim)
+//!
+//!  @note For a 9-bit trim the MSB and LSB are written in a single transfer. \n
+//!        The value is not read back - the resulting frequency is the check.
+//!
+static USBDM_ErrorCode writeTrimValue(uint32_t trimAddress, int trimValue, int do9BitTrim) {
+   uint8_t trim[2];
+   trim[0] = (uint8_t)(trimValue>>1);   // MSB
+   trim[1] = (uint8_t)(trimValue&0x01); // LSB
+   if (USBDM_WriteMemory(1, do9BitTrim?2:1, trimAddress, trim) != BDM_RC_OK) {
+      return PROGRAMMING_RC_ERROR_BDM_WRITE;
+   }
+   return PROGRAMMING_RC_OK;
+}
+
+//!  Measures the BDM frequency (average of several syncs)
+//!
+//!  @param      numAverage            Number of measurements to average
+//!  @param      frequency             Resulting frequency (Hz)
+//!
+static USBDM_ErrorCode measureBDMFrequency(int numAverage, double *frequency) {
+   unsigned long bdmSpeed;
+   double        sum = 0.0;
+   for (int index=numAverage; index>0; index--) {
+      if (USBDM_Connect() != BDM_RC_OK) {
+         return PROGRAMMING_RC_ERROR_BDM_CONNECT;
+      }
+      if (USBDM_GetSpeedHz(&bdmSpeed) != BDM_RC_OK) {
+         return PROGRAMMING_RC_ERROR_BDM_CONNECT;
+      }
+      sum += bdmSpeed;
+   }
+   *frequency = sum/numAverage;
+   return PROGRAMMING_RC_OK;
+}
+
+//!  Rounds a trim estimate to a value that may be programmed
+//!
+static int roundTrimValue(double trimValueF, int do9BitTrim) {
+   int trimValue;
+   if (do9BitTrim) {
+      trimValue = (int)round(trimValueF);
+   }
+   else {
+      trimValue = 2*(int)round(trimValueF/2.0);
+   }
+   if (trimValue > maxTrim) {
+      trimValue = maxTrim&~(do9BitTrim?0:1);
+   }
+   if (trimValue < minTrim) {
+      trimValue = minTrim+(do9BitTrim?0:1);
+   }
+   return trimValue;
+}
+
+//! Name of file used to record trim history (in application directory)
+static const char trimHistoryFilename[] = "ClockTrimHistory.cfg";
+
+//! Trim history entry
+struct TrimHistoryEntry {
+   int           trimValue;        //!< Final trim value (9-bit number)
+   unsigned long measuredFrequency;//!< Measured bus frequency at that trim (Hz)
+};
+
+//!  Creates the key used to identify a trim history entry
+//!
+//!  @param      targetName            Name of device
+//!  @param      clockType             Type of clock being trimmed
+//!  @param      targetBusFrequency    Bus Frequency being trimmed to
+//!
+static std::string getTrimHistoryKey(const std::string &targetName,
+                                     ClockTypes_t       clockType,
+                                     unsigned long      targetBusFrequency) {
+   char buff[20];
+   snprintf(buff, sizeof(buff), "%lu", targetBusFrequency);
+   return targetName+"/"+ClockTypes::getClockName(clockType)+"/"+buff;
+}
+
+//!  Loads the trim history file
+//!
+//!  @param      history               Map to load entries into
+//!
+//!  File format is one entry per line - "key trimValue measuredFrequency"
+//!
+static void loadTrimHistory(std::map<std::string, TrimHistoryEntry> &history) {
+   FILE *fp = openApplicationFile(trimHistoryFilename, "rt");
+   if (fp == NULL) {
+      return;
+   }
+   char             key[100];
+   TrimHistoryEntry entry;
+   while (fscanf(fp, "%99s %d %lu", key, &entry.trimValue, &entry.measuredFrequency) == 3) {
+      history[key] = entry;
+   }
+   fclose(fp);
+}
+
+//!  Looks up a previous trim value for the device
+//!
+//!  @param      key                   Key from getTrimHistoryKey()
+//!  @param      trimValue             Trim value found (9-bit number)
+//!
+//!  @return true if found
+//!
+static bool findTrimHistory(const std::string &key, int *trimValue) {
+   std::map<std::string, TrimHistoryEntry> history;
+   loadTrimHistory(history);
+   std::map<std::string, TrimHistoryEntry>::const_iterator it = history.find(key);
+   if (it == history.end()) {
+      return false;
+   }
+   *trimValue = it->second.trimValue;
+   return true;
+}
+
+//!  Records a trim value in the history file
+//!
+//!  @param      key                   Key from getTrimHistoryKey()
+//!  @param      trimValue             Trim value (9-bit number)
+//!  @param      measuredFrequency     Measured bus frequency at that trim (Hz)
+//!
+static void saveTrimHistory(const std::string &key, int trimValue, unsigned long measuredFrequency) {
+   std::map<std::string, TrimHistoryEntry> history;
+   loadTrimHistory(history);
+   history[key].trimValue         = trimValue;
+   history[key].measuredFrequency = measuredFrequency;
+   FILE *fp = openApplicationFile(trimHistoryFilename, "wt");
+   if (fp == NULL) {
+      print("saveTrimHistory() - Failed to open \'%s\'\n", trimHistoryFilename);
+      return;
+   }
+   std::map<std::string, TrimHistoryEntry>::const_iterator it;
+   for (it = history.begin(); it != history.end(); it++) {
+      fprintf(fp, "%s %d %lu\n", it->first.c_str(), it->second.trimValue, it->second.measuredFrequency);
+   }
+   fclose(fp);
+}
+
+//!  Estimates the trim value from a narrow window around a previous trim value
+//!
+//!  @param      trimAddress           Address of trim register.
+//!  @param      targetBDMFrequency    Target BDM Frequency to trim to.
+//!  @param      do9BitTrim            True to do 9-bit trim (rather than 8-bit)
+//!  @param      numAverage            Number of times to repeat measurements
+//!  @param      seedTrimValue         Previous trim value (9-bit number)
+//!  @param      returnTrimValue       Estimated trim value (9-bit number)
+//!  @param      returnSlope           Measured slope (Hz per unit of 9-bit trim value)
+//!
+//!  @return
+//!   == \ref PROGRAMMING_RC_OK  => Success \n
+//!   != \ref PROGRAMMING_RC_OK  => Window doesn't bracket the target frequency or measurement failed
+//!
+static USBDM_ErrorCode seededTrimValue(uint32_t       trimAddress,
+                                       unsigned long  targetBDMFrequency,
+                                       int            do9BitTrim,
+                                       int            numAverage,
+                                       int            seedTrimValue,
+                                       int           *returnTrimValue,
+                                       double        *returnSlope) {
+   static const int SeedWindow = 8; // Window is +/- this value
+   int    trimX[2];
+   double freqY[2];
+   USBDM_ErrorCode rc;
+
+   trimX[0] = roundTrimValue(seedTrimValue-SeedWindow, do9BitTrim);
+   trimX[1] = roundTrimValue(seedTrimValue+SeedWindow, do9BitTrim);
+   for (int sample=0; sample<2; sample++) {
+      rc = writeTrimValue(trimAddress, trimX[sample], do9BitTrim);
+      if (rc == PROGRAMMING_RC_OK) {
+         rc = measureBDMFrequency(numAverage, &freqY[sample]);
+      }
+      if (rc != PROGRAMMING_RC_OK) {
+         return rc;
+      }
+   }
+   // Frequency decreases as trim increases
+   if ((freqY[0] < targetBDMFrequency) || (freqY[1] > targetBDMFrequency) || (freqY[0] <= freqY[1])) {
+      print("seededTrimValue() Window [%d,%d] doesn't bracket target frequency\n", trimX[0], trimX[1]);
+      return PROGRAMMING_RC_ERROR_TRIM;
+   }
+   // Interpolate
+   double trimValueF = trimX[0] + (trimX[1]-trimX[0])*(freqY[0]-targetBDMFrequency)/(freqY[0]-freqY[1]);
+   *returnTrimValue = roundTrimValue(trimValueF, do9BitTrim);
+   *returnSlope     = (freqY[1]-freqY[0])/(trimX[1]-trimX[0]);
+   return PROGRAMMING_RC_OK;
+}
+
+//!  Sets the trim value and checks the resulting frequency
+//!
+//!  @param      trimAddress           Address of trim register.
+//!  @param      trimValue             Trim value (9-bit number)
+//!  @param      do9BitTrim            True to do 9-bit trim (rather than 8-bit)
+//!  @param      numAverage            Number of measurements to average
+//!  @param      targetBDMFrequency    Target BDM Frequency
+//!  @param      slope                 Slope of frequency vs. trim (Hz per unit of 9-bit trim value)
+//!  @param      bdmSpeed              Measured BDM frequency
+//!
+//!  @return true if within half a trim step of target i.e. no other trim value is closer
+//!
+static bool verifyTrimValue(uint32_t       trimAddress,
+                            int            trimValue,
+                            int            do9BitTrim,
+                            int            numAverage,
+                            unsigned long  targetBDMFrequency,
+                            double         slope,
+                            unsigned long *bdmSpeed) {
+   double frequency;
+   if ((writeTrimValue(trimAddress, trimValue, do9BitTrim) != PROGRAMMING_RC_OK) ||
+       (measureBDMFrequency(numAverage, &frequency) != PROGRAMMING_RC_OK)) {
+      return false;
+   }
+   *bdmSpeed = (unsigned long)round(frequency);
+   double tolerance = fabs(slope)*(do9BitTrim?1:2)/2;
+   return (fabs(frequency-targetBDMFrequency) <= tolerance);
+}
+
+//!  Predicts the trim value for the target internal clock from a few samples.
+//!
+//!  The trim is set to two widely spaced values and the frequency measured.  The
+//!  line through these points gives an initial estimate which is then measured.
+//!  A least-squares fit of the three points provides the slope used to correct
+//!  the estimate from the nearby sample.
+//!
+//!  @param      trimAddress           Address of trim register.
+//!  @param      targetBDMFrequency    Target BDM Frequency to trim to.
+//!  @param      do9BitTrim            True to do 9-bit trim (rather than 8-bit)
+//!  @param      numAverage            Number of times to repeat measurements
+//!  @param      returnTrimValue       Predicted trim value (9-bit number)
+//!  @param      returnSlope           Least-squares slope (Hz per unit of 9-bit trim value)
+//!
+//!  @return
+//!   == \ref PROGRAMMING_RC_OK  => Success \n
+//!   != \ref PROGRAMMING_RC_OK  => Measurement failed or estimate is unreliable
+//!
+static USBDM_ErrorCode predictTrimValue(uint32_t       trimAddress,
+                                        unsigned long  targetBDMFrequency,
+                                        int            do9BitTrim,
+                                        int            numAverage,
+                                        int           *returnTrimValue,
+                                        double        *returnSlope) {
+   static const int sampleTrims[] = {128, 384};
+   double trimX[3];
+   double freqY[3];
+   USBDM_ErrorCode rc;
+
+   for (int sample=0; sample<2; sample++) {
+      trimX[sample] = sampleTrims[sample];
+      rc = writeTrimValue(trimAddress, sampleTrims[sample], do9BitTrim);
+      if (rc == PROGRAMMING_RC_OK) {
+         rc = measureBDMFrequency(numAverage, &freqY[sample]);
+      }
+      if (rc != PROGRAMMING_RC_OK) {
+         return rc;
+      }
+   }
+   // Frequency must decrease as trim increases
+   double beta = (freqY[1]-freqY[0])/(trimX[1]-trimX[0]);
+   if (beta >= 0.0) {
+      return PROGRAMMING_RC_ERROR_TRIM;
+   }
+   double alpha = freqY[0]-beta*trimX[0];
+   int trimValue = roundTrimValue((targetBDMFrequency-alpha)/beta, do9BitTrim);
+
+   // Measure at initial estimate
+   trimX[2] = trimValue;
+   rc = writeTrimValue(trimAddress, trimValue, do9BitTrim);
+   if (rc == PROGRAMMING_RC_OK) {
+      rc = measureBDMFrequency(numAverage, &freqY[2]);
+   }
+   if (rc != PROGRAMMING_RC_OK) {
+      return rc;
+   }
+   // Least-squares slope of all samples
+   double sumX  = 0.0;
+   double sumY  = 0.0;
+   double sumXX = 0.0;
+   double sumXY = 0.0;
+   for (int sample=0; sample<3; sample++) {
+      sumX  += trimX[sample];
+      sumY  += freqY[sample];
+      sumXX += trimX[sample]*trimX[sample];
+      sumXY += trimX[sample]*freqY[sample];
+   }
+   beta = (3*sumXY-sumX*sumY)/(3*sumXX-sumX*sumX);
+   if (beta >= 0.0) {
+      return PROGRAMMING_RC_ERROR_TRIM;
+   }
+   // Correct estimate from nearby sample
+   double trimValueF = trimX[2] + (targetBDMFrequency-freqY[2])/beta;
+   if ((trimValueF <= minTrim) || (trimValueF >= maxTrim)) {
+      return PROGRAMMING_RC_ERROR_TRIM;
+   }
+   *returnTrimValue = roundTrimValue(trimValueF, do9BitTrim);
+   *returnSlope     = beta;
+
+// print("predictTrimValue(): f(%d)=%f, f(%d)=%f, f(%d)=%f => trim=%d\n",
+//       (int)trimX[0], freqY[0], (int)trimX[1], freqY[1], (int)trimX[2], freqY[2], *returnTrimValue);
+
+   return PROGRAMMING_RC_OK;
+}
+
 //!  Determines the trim value for the target internal clock.
 //!  The target clock is left trimmed for a bus freq. of targetBusFrequency.
 //!
+//!  The trim is first predicted from a few samples (see predictTrimValue()) and only
+//!  the final value is verified.  If that fails the binary search + linear sweep is used.
+//!  If trim history is enabled the search is first seeded from a previous trim of the device.
+//!
 //!     Target clock has been suitably configured.
 //!
 //!  @param      trimAddress           Address of trim register.
@@ -340,8 +658,6 @@ USBDM_ErrorCode FlashProgrammer::trimTargetClock(uint32_t       trimAddress,
    int              index;
    USBDM_ErrorCode  rc = PROGRAMMING_RC_OK;
 
-   static const int maxTrim        = 505;   // Maximum acceptable trim value
-   static const int minTrim        =   5;   // Minimum acceptable trim value
    static const int SearchOffset   =   8;   // Linear sweep range is +/- this value
    static const unsigned char zero =   0;
    const unsigned long targetBDMFrequency = targetBusFrequency/parameters.getBDMtoBUSFactor();
@@ -366,6 +682,43 @@ USBDM_ErrorCode FlashProgrammer::trimTargetClock(uint32_t       trimAddress,
    *measuredBusFrequency = 10000;
    trimMSB               = 0;
 
+   if (do9BitTrim) {
+      numAverage = 2;
+   }
+   else {
+      numAverage = 4;
+   }
+   const std::string historyKey = getTrimHistoryKey(parameters.getTargetName(),
+                                                    parameters.getClockType(),
+                                                    targetBusFrequency);
+   // Try trim value from narrow window around previous value - verify final value only
+   int    seedTrimValue;
+   double slope;
+   if (parameters.isTrimHistory() &&
+       findTrimHistory(historyKey, &seedTrimValue) &&
+       (seededTrimValue(trimAddress, targetBDMFrequency, do9BitTrim, numAverage, seedTrimValue, &trimValue, &slope) == PROGRAMMING_RC_OK)) {
+      if (verifyTrimValue(trimAddress, trimValue, do9BitTrim, numAverage, targetBDMFrequency, slope, &bdmSpeed)) {
+         print("trimTargetClock() Seeded trim=%d, bdmSpeed=%ld\n", trimValue, bdmSpeed);
+         *returnTrimValue      = trimValue;
+         *measuredBusFrequency = bdmSpeed*parameters.getBDMtoBUSFactor();
+         saveTrimHistory(historyKey, trimValue, *measuredBusFrequency);
+         return PROGRAMMING_RC_OK;
+      }
+      print("trimTargetClock() Seeded trim=%d rejected\n", trimValue);
+   }
+   // Try predicted trim value - verify final value only
+   if (predictTrimValue(trimAddress, targetBDMFrequency, do9BitTrim, numAverage, &trimValue, &slope) == PROGRAMMING_RC_OK) {
+      if (verifyTrimValue(trimAddress, trimValue, do9BitTrim, numAverage, targetBDMFrequency, slope, &bdmSpeed)) {
+         print("trimTargetClock() Predicted trim=%d, bdmSpeed=%ld\n", trimValue, bdmSpeed);
+         *returnTrimValue      = trimValue;
+         *measuredBusFrequency = bdmSpeed*parameters.getBDMtoBUSFactor();
+         if (parameters.isTrimHistory()) {
+            saveTrimHistory(historyKey, trimValue, *measuredBusFrequency);
+         }
+         return PROGRAMMING_RC_OK;
+      }
+      print("trimTargetClock() Predicted trim=%d rejected, using search\n", trimValue);
+   }
    // Set LSB trim value = 0
    if (USBDM_WriteMemory(1,1,trimAddress+1, &zero) != BDM_RC_OK) {
       return PROGRAMMING_RC_ERROR_BDM_WRITE;
@@ -415,12 +768,6 @@ USBDM_ErrorCode FlashProgrammer::trimTargetClock(uint32_t       trimAddress,
 //                   "========================================== \n",
 //                   targetBDMFrequency/1000);
 
-   if (do9BitTrim) {
-      numAverage = 2;
-   }
-   else {
-      numAverage = 4;
-   }
    for(trimValue=maxRange; trimValue>=minRange; trimValue--) {
       trimLSB = trimValue&0x01;
       trimMSB = (uint8_t)(trimValue>>1);
@@ -523,7 +870,7 @@ USBDM_ErrorCode FlashProgrammer::trimTargetClock(uint32_t       trimAddress,
    // Estimate required trim value
    trimValueF = ((targetBDMFrequency-alpha)/beta);
 
-   if ((trimValueF <= 5.0) || (trimValue >= 505.0)) { // resulted in extreme value
+   if ((trimValueF <= 5.0) || (trimValueF >= 505.0)) { // resulted in extreme value
       trimValueF = 256.0;                             // replace with 'Safe' trim value
       rc = PROGRAMMING_RC_ERROR_TRIM;
    }
@@ -554,6 +901,9 @@ USBDM_ErrorCode FlashProgrammer::trimTargetClock(uint32_t       trimAddress,
    }
    *measuredBusFrequency = bdmSpeed*parameters.getBDMtoBUSFactor();
 
+   if ((rc == PROGRAMMING_RC_OK) && parameters.isTrimHistory()) {
+      saveTrimHistory(historyKey, trimValue, *measuredBusFrequency);
+   }
    return rc;
 }
 
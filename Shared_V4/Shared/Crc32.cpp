@@ -0,0 +1,28 @@
+/*
+ * Crc32.cpp
+ *
+ *  Created on: 19/10/2026
+ *      Author: agent
+ */
+#include "Crc32.h"
+
+uint32_t Crc32::table[256];
+bool     Crc32::tableValid = false;
+
+//! Create the byte look-up table for the CRC calculation
+//!
+void Crc32::initialiseTable(void) {
+   for (unsigned index=0; index<256; index++) {
+      uint32_t value = index;
+      for (int bit=0; bit<8; bit++) {
+         if (value&1) {
+            value = (value>>1)^0xEDB88320UL;
+         }
+         else {
+            value = (value>>1);
+         }
+      }
+      table[index] = value;
+   }
+   tableValid = true;
+}
@@ -0,0 +1,56 @@
+/*
+ * Crc32.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: agent
+ */
+
+#ifndef CRC32_H_
+#define CRC32_H_
+
+#include "Common.h"
+
+//! Calculates a CRC-32 (IEEE 802.3, reflected, polynomial 0xEDB88320)
+//!
+//! Memory elements larger than a byte are added least-significant byte first.
+//!
+class Crc32 {
+private:
+   uint32_t        crc;
+   static uint32_t table[256];
+   static bool     tableValid;
+
+   static void initialiseTable(void);
+
+public:
+   Crc32() : crc(0xFFFFFFFFUL) {
+      if (!tableValid) {
+         initialiseTable();
+      }
+   }
+   //! Restart the calculation
+   void reset(void) {
+      crc = 0xFFFFFFFFUL;
+   }
+   //! Add a byte to the CRC
+   void add(uint8_t data) {
+      crc = table[(crc^data)&0xFF]^(crc>>8);
+   }
+   //! Add a 16-bit value to the CRC (LS byte first)
+   void add(uint16_t data) {
+      add((uint8_t)data);
+      add((uint8_t)(data>>8));
+   }
+   //! Add a block of bytes to the CRC
+   void add(const uint8_t *data, unsigned size) {
+      while (size-- > 0) {
+         add(*data++);
+      }
+   }
+   //! @return CRC of data added so far
+   uint32_t getValue(void) const {
+      return ~crc;
+   }
+};
+
+#endif /* CRC32_H_ */
@@ -540,6 +540,8 @@ private:
    uint32_t                      SDIDAddress;            //!< Address of SDID registers
    SecurityOptions_t             security;               //!< Determines security options of programmed target (modifies NVFOPT value)
    EraseOptions                  eraseOption;            //!< How to handle erasing of flash before programming
+   bool                          paranoidBlankCheck;     //!< Blank check flash even when known to be erased
+   bool                          trimHistory;            //!< Use/record clock trim history to seed trimming
    uint16_t                      clockTrimValue;         //!< Clock trim value calculated for a particular device
    uint16_t                      targetSDIDMask;         //!< Mask for valid bits in SDID
    std::vector<MemoryRegionPtr>  memoryRegions;          //!< Different memory regions e.g. EEPROM, RAM etc.
@@ -569,6 +571,8 @@ public:
    unsigned long     getConnectionFreq() /*Hz*/   const { return connectionFreq; }
    SecurityOptions_t getSecurity()                const { return security; }
    EraseOptions      getEraseOption()             const { return eraseOption; }
+   bool              isParanoidBlankCheck()       const { return paranoidBlankCheck; }
+   bool              isTrimHistory()              const { return trimHistory; }
 #if (TARGET == HC12)||(TARGET == MC56F80xx)
    uint32_t          getCOPCTLAddress()           const { return COPCTLAddress; }
 #else
@@ -653,6 +657,8 @@ public:
    void setConnectionFreq(unsigned long value /*Hz*/) { connectionFreq = value; }
    void setSecurity(SecurityOptions_t value)          { security = value; }
    void setEraseOption(EraseOptions value)            { eraseOption = value; }
+   void setParanoidBlankCheck(bool value = true)      { paranoidBlankCheck = value; }
+   void setTrimHistory(bool value = true)             { trimHistory = value; }
 #if (TARGET == HC12)||(TARGET == MC56F80xx)
    void setCOPCTLAddress(uint32_t value)              { COPCTLAddress = value; }
 #else
@@ -711,6 +717,8 @@ public:
                       SDIDAddress(SDIDAddress),
                       security(security),
                       eraseOption(eraseAll),
+                      paranoidBlankCheck(false),
+                      trimHistory(false),
                       clockTrimValue(clockTrimValue),
                       targetSDIDMask(0),
                       valid(true)
@@ -735,6 +743,8 @@ public:
                   SDIDAddress(0),
                   security(SEC_DEFAULT),
                   eraseOption(eraseAll),
+                  paranoidBlankCheck(false),
+                  trimHistory(false),
                   clockTrimValue(0),
                   targetSDIDMask(0),
                   valid(true)
@@ -250,4 +250,43 @@ USBDM_ErrorCode executeJTAGSequence(uint8_t       sequenceLength,
                                     uint8_t       dataInLength,
                                     uint8_t       *dataInStart,
                                     bool     log = false);
+
+//! Low-level JTAG operations used when sequences are executed on the PC
+//!
+//! The operations have the same meaning as USBDM_JTAG_Reset() etc.
+//!
+class JTAGTransport {
+public:
+   virtual ~JTAGTransport() {}
+   virtual USBDM_ErrorCode reset(void) = 0;
+   virtual USBDM_ErrorCode selectShift(uint8_t mode) = 0;
+   virtual USBDM_ErrorCode write(uint8_t bitCount, uint8_t exit, const uint8_t *buffer) = 0;
+   virtual USBDM_ErrorCode read(uint8_t bitCount, uint8_t exit, uint8_t *buffer) = 0;
+   virtual USBDM_ErrorCode readWrite(uint8_t bitCount, uint8_t exit, const uint8_t *outBuffer, uint8_t *inBuffer) = 0;
+   //! Execute a complete sequence in a single operation (e.g. by the BDM)
+   //! BDM_RC_ILLEGAL_COMMAND => not supported, sequence is interpreted using the above operations
+   virtual USBDM_ErrorCode executeSequence(uint8_t /* sequenceLength */, const uint8_t * /* sequence */, uint8_t /* dataInLength */, uint8_t * /* dataIn */) {
+      return BDM_RC_ILLEGAL_COMMAND;
+   }
+};
+
+//! Statistics for executed JTAG sequences
+typedef struct {
+   unsigned long transactions;      //!< Sequences executed (= USB round-trips when using the BDM)
+   unsigned long bytesOut;          //!< Sequence bytes sent (including data out)
+   unsigned long bytesIn;           //!< Data bytes returned
+   unsigned long opcodeCounts[256]; //!< Times each opcode was executed (PC execution only)
+   unsigned long optimisedBytes;    //!< Sequence bytes removed by optimiseJTAGSequence()
+   unsigned long optimisedClocks;   //!< Approximate JTAG clocks removed by optimiseJTAGSequence()
+} JTAGSequenceStatistics;
+
+const JTAGSequenceStatistics &getJTAGSequenceStatistics(void);
+void resetJTAGSequenceStatistics(void);
+
+unsigned optimiseJTAGSequence(uint8_t       sequenceLength,
+                              const uint8_t *sequence,
+                              uint8_t       *buffer,
+                              unsigned      *clocksSaved);
+void setJTAGSequenceOptimisation(bool enable);
+bool getJTAGSequenceOptimisation(void);
 #endif /* JTAGSEQUENCE_HPP_ */
@@ -94,6 +94,9 @@ private:
    bool                     verify;
    bool                     program;
    bool                     verbose;
+   bool                     paranoid;
+   bool                     trimHistory;
+   bool                     trimOnly;
    wxString                 hexFileName;
    double                   trimFrequency;
    long                     trimNVAddress;
@@ -192,6 +195,8 @@ void FlashProgrammerApp::doCommandLineProgram() {
       deviceData.setEraseOption(DeviceData::eraseSelective);
       deviceData.setEraseOption(eraseOptions);
       deviceData.setSecurity(deviceSecurity);
+      deviceData.setParanoidBlankCheck(paranoid);
+      deviceData.setTrimHistory(trimHistory);
       if (trimNVAddress != 0)
          deviceData.setClockTrimNVAddress(trimNVAddress);
       if (flashProgrammer.setDeviceData(deviceData) != PROGRAMMING_RC_OK) {
@@ -199,6 +204,17 @@ void FlashProgrammerApp::doCommandLineProgram() {
          break;
       }
       USBDM_ErrorCode rc;
+#if (TARGET==HCS08) || (TARGET==CFV1)
+      if (trimOnly) {
+         if (verbose) {
+            rc = flashProgrammer.programTrimValue(callBack);
+         }
+         else{
+            rc = flashProgrammer.programTrimValue(NULL);
+         }
+      }
+      else
+#endif
       if (program) {
          if (verbose) {
             rc = flashProgrammer.programFlash(&flashImage, callBack);
@@ -315,6 +331,9 @@ int FlashProgrammerApp::OnRun(void) {
 int FlashProgrammerApp::OnExit(void) {
 
 //   print("FlashProgrammerApp::OnExit()\n");
+#if TARGET!=RS08
+   FlashProgrammer::releaseTclInterpreterPool();
+#endif
    return wxApp::OnExit();
 }
 
@@ -337,6 +356,8 @@ static const wxCmdLineEntryDesc g_cmdLineDesc[] = {
       { wxCMD_LINE_SWITCH, _("masserase"), NULL, _("Equivalent to erase=Mass") },
       { wxCMD_LINE_SWITCH, _("noerase"),   NULL, _("Equivalent to erase=None") },
       { wxCMD_LINE_SWITCH, _("verify"),    NULL, _("Verify flash contents") },
+      { wxCMD_LINE_SWITCH, _("paranoid"),  NULL, _("Blank check flash even if known to be erased") },
+      { wxCMD_LINE_SWITCH, _("trimhistory"), NULL, _("Seed clock trimming from previous trims of this device type") },
       { wxCMD_LINE_OPTION, _("reset"),     NULL, _("Reset timing (active,release,recovery) 100-10000 ms"),  wxCMD_LINE_VAL_STRING },
       { wxCMD_LINE_OPTION, _("power"),     NULL, _("Power timing (off,recovery) 100-10000 ms"),             wxCMD_LINE_VAL_STRING },
       { wxCMD_LINE_OPTION, _("speed"),     NULL, _("Interface speed (CFVx/Kinetis/DSC) kHz"),               wxCMD_LINE_VAL_STRING },
@@ -344,6 +365,9 @@ static const wxCmdLineEntryDesc g_cmdLineDesc[] = {
       { wxCMD_LINE_SWITCH, _("verbose"),   NULL, _("Print progress messages to stdout") },
 #endif
       { wxCMD_LINE_SWITCH, _("program"),   NULL, _("Program and verify flash contents"), },
+#if (TARGET==HCS08) || (TARGET==CFV1)
+      { wxCMD_LINE_SWITCH, _("trimonly"),  NULL, _("Trim clock and program only the trim locations"), },
+#endif
       { wxCMD_LINE_NONE }
 };
 
@@ -369,6 +393,17 @@ void FlashProgrammerApp::OnInitCmdLine(wxCmdLineParser& parser)
           "in flash are still unprogrammed (0xFF) when using the -trim option. The \n"
           "target must not be secured and cannot be made secured when using -erase=None."
           ));
+#if (TARGET==HCS08) || (TARGET==CFV1)
+    parser.AddUsageText(_(
+          "\nRe-trimming the clock of an already programmed chip:\n"
+          "  FlashProgrammer -device=MC9S08QG8 -trim=35.25 -trimonly \n"
+          "This will trim the internal clock of MC9S08QG8 to 35.25kHz and program only\n"
+          "the clock trim locations. No image file is needed. If these are already\n"
+          "programmed then -erase=Selective must be given; the flash sector containing\n"
+          "them is then read, erased and reprogrammed. As this sector may contain the\n"
+          "security options and vectors the device must not be interrupted meanwhile."
+          ));
+#endif
 #endif
 }
 
@@ -380,13 +415,19 @@ bool FlashProgrammerApp::OnCmdLineParsed(wxCmdLineParser& parser) {
 
    commandLine  = false;
    verbose      = false;
+   paranoid     = false;
+   trimHistory  = false;
+   trimOnly     = false;
 
 //   USBDM_Init();
 
    if (parser.GetParamCount() > 0) {
       hexFileName = parser.GetParam(0);
    }
-   if (parser.Found(_("verify")) || parser.Found(_("program"))) {
+#if (TARGET==HCS08) || (TARGET==CFV1)
+   trimOnly = parser.Found(_("trimonly"));
+#endif
+   if (parser.Found(_("verify")) || parser.Found(_("program")) || trimOnly) {
       commandLine           = true;
       bdmOptions.size       = sizeof(USBDM_ExtendedOptions_t);
       bdmOptions.targetType = targetType;
@@ -411,6 +452,12 @@ bool FlashProgrammerApp::OnCmdLineParsed(wxCmdLineParser& parser) {
       if (parser.Found(_("noerase"))) {
          eraseOptions = DeviceData::eraseNone;
       }
+      if (parser.Found(_("paranoid"))) {
+         paranoid = true;
+      }
+      if (parser.Found(_("trimhistory"))) {
+         trimHistory = true;
+      }
       if (parser.Found(_("secure"))) {
          deviceSecurity = SEC_SECURED;
       }
@@ -831,6 +831,62 @@ typedef struct {
    unsigned                jtagBufferSize;       //!< Size of JTAG buffer (if supported)
 } USBDM_bdmInformation_t;
 
+//! Number of buckets in the latency histogram of \ref USBDM_CommandStatistics_t
+//! Bucket n counts transactions taking less than (64<<n) us that are not in a lower bucket.
+//! The last bucket counts all longer transactions.
+#define USBDM_LATENCY_BUCKETS (12)
+
+//! Statistics for a single BDM command
+typedef struct {
+   unsigned long           count;                //!< Number of transactions
+   unsigned long           errors;               //!< Number of transactions returning an error
+   uint64_t                bytesOut;             //!< Bytes sent to BDM
+   uint64_t                bytesIn;              //!< Bytes received from BDM
+   uint64_t                totalTime;            //!< Total transaction time (us)
+   unsigned long           maxTime;              //!< Longest transaction (us)
+   unsigned long           latency[USBDM_LATENCY_BUCKETS]; //!< Histogram of transaction time
+} USBDM_CommandStatistics_t;
+
+//! Statistics for BDM communication
+typedef struct {
+   unsigned                  size;               //!< Size of this structure
+   unsigned long             toggleRetries;      //!< Responses re-read due to a USB or toggle error
+   unsigned long             usbRetries;         //!< Commands re-sent due to a USB error
+   unsigned long             busyResponses;      //!< BDM_RC_BUSY responses
+   unsigned long             sleepCount;         //!< Number of delays (e.g. USB retries, target reset)
+   uint64_t                  sleepTime;          //!< Total time in delays (us)
+   USBDM_CommandStatistics_t commands[128];      //!< Statistics indexed by command (CMD_USBDM_xxx)
+} USBDM_Statistics_t;
+
+//! Round-trip & idle time for a single BDM command (see \ref USBDM_GetCaptureTiming)
+typedef struct {
+   unsigned long           count;                //!< Number of transactions
+   unsigned long           errors;               //!< Number of transactions returning an error
+   uint64_t                roundTrip;            //!< Total round-trip time (us)
+   unsigned long           minimum;              //!< Shortest round-trip time (us)
+   unsigned long           maximum;              //!< Longest round-trip time (us)
+   uint64_t                idle;                 //!< Total time from the end of the previous transaction (us)
+} USBDM_CommandTiming_t;
+
+//! Breakdown of time for a sequence of captured transactions
+//! Idle time is time spent in the host (DLL & application) between transactions.
+typedef struct {
+   unsigned long           records;              //!< Number of transactions
+   unsigned long           discarded;            //!< Earlier transactions not recorded in the file (capture file size limit)
+   uint64_t                roundTrip;            //!< Total round-trip time (us)
+   uint64_t                idle;                 //!< Total idle time (us)
+   USBDM_CommandTiming_t   commands[128];        //!< Timing indexed by command (CMD_USBDM_xxx)
+} USBDM_TimingBreakdown_t;
+
+//! Timing of transactions captured (USBDM_CAPTURE) or replayed (USBDM_REPLAY)
+typedef struct {
+   unsigned                size;                 //!< Size of this structure
+   USBDM_TimingBreakdown_t capture;              //!< Transactions captured so far
+   USBDM_TimingBreakdown_t recorded;             //!< Transactions recorded in the file being replayed
+   unsigned long           replayed;             //!< Records replayed so far
+   unsigned long           divergences;          //!< Replayed commands that differed from the recording
+} USBDM_CaptureTiming_t;
+
 // The following functions are available when in BDM mode
 //====================================================================
 //
@@ -1010,6 +1066,45 @@ USBDM_ErrorCode  USBDM_GetCapabilities(HardwareCapabilities_t *capabilities);
 USBDM_API 
 USBDM_ErrorCode USBDM_GetBdmInformation(USBDM_bdmInformation_t *info);
 
+//! \brief Obtains statistics for communication with the BDM
+//!
+//! Statistics are accumulated from USBDM_Init() or USBDM_ResetStatistics()
+//!
+//! @param statistics ptr to structure to contain the statistics
+//!
+//! @return \n
+//!     BDM_RC_OK => OK \n
+//!     other     => Error code - see \ref USBDM_ErrorCode
+//!
+//! @note The size element of statistics should be initialised before call.
+//!
+USBDM_API
+USBDM_ErrorCode USBDM_GetStatistics(USBDM_Statistics_t *statistics);
+
+//! \brief Clears statistics for communication with the BDM
+//!
+//! @return \n
+//!     BDM_RC_OK => OK
+//!
+USBDM_API
+USBDM_ErrorCode USBDM_ResetStatistics(void);
+
+//! \brief Obtains the timing breakdown of captured or replayed BDM transactions
+//!
+//! Capture & replay are enabled by the environment variables USBDM_CAPTURE & USBDM_REPLAY
+//! when USBDM_Init() is called.  The breakdowns are empty if they are not enabled.
+//!
+//! @param timing ptr to structure to contain the timing
+//!
+//! @return \n
+//!     BDM_RC_OK => OK \n
+//!     other     => Error code - see \ref USBDM_ErrorCode
+//!
+//! @note The size element of timing should be initialised before call.
+//!
+USBDM_API
+USBDM_ErrorCode USBDM_GetCaptureTiming(USBDM_CaptureTiming_t *timing);
+
 //! Set BDM interface options
 //!
 //! @param bdmOptions : Options to pass to BDM interface
@@ -22,6 +22,7 @@
 #include "Names.h"
 #include "DeviceData.h"
 #include "GdbHandler.h"
+#include "FlashProgramming.h"
 #include "ProgressTimer.h"
 
 #include "GdbInput.h"
@@ -313,6 +314,7 @@ int main(int argc, char **argv) {
    }
    // Now do the actual processing of GDB messages
    handleGdb(gdbInput, gdbOutput, deviceData, progressTimer);
+   FlashProgrammer::releaseTclInterpreterPool();
    usbdmClose();
    print("gdbServer() - Exiting\n");
    fprintf(stderr, "gdbServer() - Exiting\n");
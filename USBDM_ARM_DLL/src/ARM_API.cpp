@@ -41,6 +41,7 @@
 #include "Log.h"
 #include "Conversion.h"
 #include "JTAGSequence.h"
+#include "JTAGSequenceBuilder.h"
 #ifdef DLL
 #undef DLL
 #endif
@@ -64,39 +65,13 @@ typedef enum {TARGET_UNKNOWN, TARGET_KINETIS, TARGET_STM32F10x} TargetSubTypesT;
 #define DATA32(x) (((x)>>24U)&0xFFUL),(((x)>>16)&0xFFUL),(((x)>>8)&0xFFUL),((x)&0xFFUL)
 #define JTAG16(x) (((x)>>8)&0xFF),((x)&0xFF)
 
-// ARM JTAG Commands
-#define ARM_JTAG_MASTER_IR_LENGTH   (4)     // IR length for commands below
-
+// Generic JTAG Commands (ARM JTAG-DP commands are in ARM_Definitions.h)
 #define JTAG_IDCODE_LENGTH          (32)
 #define JTAG_IDCODE_COMMAND         (0x00)  // Device ID Code Register (IDCODE) reg
 #define JTAG_EZPORT_IDCODE_LENGTH   (32)
 #define JTAG_EZPORT_IDCODE_COMMAND  (0x01)  // EZPORT reg
-#define JTAG_DP_ABORT_SEL_LENGTH    (35)
-#define JTAG_DP_ABORT_SEL_COMMAND   (0x08)  // JTAG-DP Abort Register (ABORT)
-#define JTAG_DP_DPACC_SEL_LENGTH    (35)
-#define JTAG_DP_DPACC_SEL_COMMAND   (0x0A)  // JTAG-DP DP Access Register (DPACC)
-#define JTAG_DP_APACC_SEL_LENGTH    (35)
-#define JTAG_DP_APACC_SEL_COMMAND   (0x0B)  // JTAG-DP AP Access Register (APACC)
-#define JTAG_ARM_IDCODE_LENGTH      (32)
-#define JTAG_ARM_IDCODE_COMMAND     (0x0E)  // ARM Device ID Code Register (IDCODE)
 #define JTAG_BYPASS_LENGTH          (1)
 #define JTAG_BYPASS_COMMAND         (~0x00) // BYPASS reg
-
-// Responses from DP/AP access
-#define ACK_OK_FAULT       (0x02) //!< Access completed (either OK or FAULT)
-#define ACK_WAIT           (0x01) //!< Access incomplete - try again
-
-// Mask for DPACC
-// Note: As used in access i.e. A[3:2] as x[1:0]
-#define DP_IDR_REG         (0x0) //!< R access DP ID registers
-#define DP_CTRL_STAT_REG   (0x2) //!< R/W access DP STATUS/CONTROL registers
-#define DP_SELECT_REG      (0x4) //!< R/W access AP SELECT register (controls AP access address)
-#define DP_RDBUFF_REG      (0x6) //!< RAX/WI access to RDBUFF register
-
-#define DP_WRITE           (0x0)
-#define DP_READ            (0x1)
-
-#define DP_AP_DP_MASK      (0x8) //!< Mask used to select b/w DP & AP registers
 #define DP_DP_SELECT       (0x0)           //!< Select DP registers
 #define DP_AP_SELECT       (DP_AP_DP_MASK) //!< Select AP registers
 
@@ -705,6 +680,57 @@ static USBDM_ErrorCode readMemoryHalfword(uint32_t address, uint16_t *data) {
    return BDM_RC_OK;
 }
 
+// Variable fields of the memory transfer sequences
+struct CswValue;
+struct TarValue;
+struct TransferCount;
+
+//! Sets AHB-AP CSW (first transfer only)
+typedef JTAGBuilder::Program<
+   JTAGBuilder::ArmWriteAPImmediate<AHB_AP_CSW, CswValue,
+   JTAGBuilder::NoEnd> > CswSequence;
+
+//! Sets AHB-AP TAR (first transfer & after crossing a page boundary)
+typedef JTAGBuilder::Program<
+   JTAGBuilder::ArmWriteAPImmediate<AHB_AP_TAR, TarValue,
+   JTAGBuilder::NoEnd> > TarSequence;
+
+//! Block read via AHB-AP DRW
+typedef JTAGBuilder::Program<
+   JTAGBuilder::ArmReadAP<TransferCount, AHB_AP_DRW,
+   JTAGBuilder::End> > ReadDrwSequence;
+
+//! Block write via AHB-AP DRW (data follows sequence)
+typedef JTAGBuilder::Program<
+   JTAGBuilder::ArmWriteAP<TransferCount, AHB_AP_DRW,
+   JTAGBuilder::End> > WriteDrwSequence;
+
+//! Add CSW and TAR setup to a memory transfer sequence as needed
+//!
+//! @param outDataPtr - where to place sequence
+//! @param setCsw     - include CSW setup
+//! @param cswValue   - value for CSW
+//! @param setTar     - include TAR setup
+//! @param address    - value for TAR
+//!
+//! @return pointer to byte following sequence
+//!
+static uint8_t *addTransferSetup(uint8_t *outDataPtr, bool setCsw, uint32_t cswValue, bool setTar, uint32_t address) {
+   if (setCsw) {
+      // Initial transfer includes CSW register setup
+      CswSequence::copyTo(outDataPtr);
+      CswSequence::set<CswValue>(outDataPtr, cswValue);
+      outDataPtr += CswSequence::size;
+   }
+   if (setTar) {
+      // Transfer includes TAR register setup
+      TarSequence::copyTo(outDataPtr);
+      TarSequence::set<TarValue>(outDataPtr, address);
+      outDataPtr += TarSequence::size;
+   }
+   return outDataPtr;
+}
+
 //! Read words from target memory
 //!
 //! @note Breaks transfers on 2**10 boundary as TAR may not increment across this boundary
@@ -730,31 +756,10 @@ static USBDM_ErrorCode readMemoryWord(uint32_t address, unsigned numWords, uint3
       return BDM_RC_ILLEGAL_PARAMS;
    }
    while (numWords > 0) {
-      const int tSize = 5;
       bool crossedBoundary = false;
-      uint8_t *outDataPtr = outBuffer;
+      uint8_t *outDataPtr = addTransferSetup(outBuffer, initialTransfer, cswValue, writeAddressToTAR, address);
       uint8_t transferSize = armInfo.maxMemoryReadSize-4; // Allow for return status value
-      if (initialTransfer) {
-//         print("     readMemoryWord() - CSW <= 0x%08X)\n", cswValue);
-         // Initial transfer includes CSW register setup
-         const uint8_t initSequence[] = {
-            JTAG_ARM_WRITEAP_I, ADDR16(AHB_AP_CSW), DATA32(cswValue),
-         };
-         memcpy(outDataPtr, initSequence, sizeof(initSequence));
-         outDataPtr   += sizeof(initSequence);
-         transferSize -= sizeof(initSequence);
-      }
-      if (writeAddressToTAR) {
-//         print("     readMemoryWord() - TAR <= 0x%08X)\n", address);
-         // Transfer includes TAR register setup
-         const uint8_t tarSequence[] = {
-            JTAG_ARM_WRITEAP_I, ADDR16(AHB_AP_TAR), DATA32(address),
-         };
-         memcpy(outDataPtr, tarSequence, sizeof(tarSequence));
-         outDataPtr   += sizeof(tarSequence);
-         transferSize -= sizeof(tarSequence);
-      }
-      transferSize -= tSize;
+      transferSize -= (outDataPtr-outBuffer)+ReadDrwSequence::size;
       if (transferSize>4*numWords)
          transferSize = 4*numWords;
       // Check if range crosses page boundary
@@ -766,13 +771,10 @@ static USBDM_ErrorCode readMemoryWord(uint32_t address, unsigned numWords, uint3
 //               address, address+transferSize-1);
       }
       transferSize /= 4;
-      const uint8_t transferSequence[] = {
-         JTAG_ARM_READAP, transferSize, ADDR16(AHB_AP_DRW), // Do transfer & get final CSW
-         JTAG_END,
-      };
-      assert(sizeof(transferSequence)==tSize);
-      memcpy(outDataPtr, transferSequence, sizeof(transferSequence));
-      outDataPtr += sizeof(transferSequence);
+      // Do transfer & get final CSW
+      ReadDrwSequence::copyTo(outDataPtr);
+      ReadDrwSequence::set<TransferCount>(outDataPtr, transferSize);
+      outDataPtr += ReadDrwSequence::size;
       // Read data from memory via DRW + status
       rc = executeJTAGSequence(outDataPtr-outBuffer, outBuffer, 4*transferSize+4, inBuffer, debugJTAG);
       if (rc != BDM_RC_OK) {
@@ -999,31 +1001,10 @@ static USBDM_ErrorCode writeMemoryWord(uint32_t address, unsigned numWords, cons
    assert(armInfo.maxMemoryWriteSize>40);
 
    while (numWords > 0) {
-      const int tSize = 5;
       bool crossedBoundary = false;
-      uint8_t *outDataPtr = outBuffer;
+      uint8_t *outDataPtr = addTransferSetup(outBuffer, initialTransfer, cswValue, writeAddressToTAR, address);
       uint8_t transferSize = armInfo.maxMemoryWriteSize;
-      if (initialTransfer) {
-//         print("     writeMemoryWord() - CSW <= 0x%08X)\n", cswValue);
-         // Initial transfer includes CSW register setup
-         const uint8_t initSequence[] = {
-            JTAG_ARM_WRITEAP_I, ADDR16(AHB_AP_CSW), DATA32(cswValue),
-         };
-         memcpy(outDataPtr, initSequence, sizeof(initSequence));
-         outDataPtr   += sizeof(initSequence);
-         transferSize -= sizeof(initSequence);
-      }
-      if (writeAddressToTAR) {
-//         print("     writeMemoryWord() - TAR <= 0x%08X)\n", address);
-         // Transfer includes TAR register setup
-         const uint8_t tarSequence[] = {
-            JTAG_ARM_WRITEAP_I, ADDR16(AHB_AP_TAR), DATA32(address),
-         };
-         memcpy(outDataPtr, tarSequence, sizeof(tarSequence));
-         outDataPtr   += sizeof(tarSequence);
-         transferSize -= sizeof(tarSequence);
-      }
-      transferSize -= tSize;
+      transferSize -= (outDataPtr-outBuffer)+WriteDrwSequence::size;
       if (transferSize>4*numWords)
          transferSize = 4*numWords;
       // Check if range crosses page boundary
@@ -1035,13 +1016,9 @@ static USBDM_ErrorCode writeMemoryWord(uint32_t address, unsigned numWords, cons
 //               address, address+transferSize-1);
       }
       transferSize /= 4;
-      const uint8_t transferSequence[] = {
-         JTAG_ARM_WRITEAP, transferSize, ADDR16(AHB_AP_DRW),
-         JTAG_END,
-      };
-      assert(sizeof(transferSequence)==tSize);
-      memcpy(outDataPtr, transferSequence, sizeof(transferSequence));
-      outDataPtr += sizeof(transferSequence);
+      WriteDrwSequence::copyTo(outDataPtr);
+      WriteDrwSequence::set<TransferCount>(outDataPtr, transferSize);
+      outDataPtr += WriteDrwSequence::size;
       numWords   -= transferSize;
       // Copy data to buffer
       int index=0;
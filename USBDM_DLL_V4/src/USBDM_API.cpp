@@ -30,6 +30,9 @@
 \verbatim
  Change History
 +==================================================================================================
+| 19 Oct 2026 | Added USBDM_GetStatistics(), USBDM_ResetStatistics()                        V4.10.0
+| 19 Oct 2026 | Added capture & replay (USBDM_CAPTURE, USBDM_REPLAY)                        V4.10.0
+| 19 Oct 2026 | Added loopback BDM (USBDM_LOOPBACK environment variable)                    V4.10.0
 |  7 Aug 2012 | USBDM_ControlInterface() now uses USBDM_ControlPins()               - pgo - V4.10.0
 | 20 May 2012 | Extended firmware version information                                       V4.9.5
 | 16 May 2012 | Corrected possible buffer overrun in USBDM_JTAG_ExecuteSequence()   - pgo - V4.9.5
@@ -54,6 +57,7 @@
 \endverbatim
 */
 #include <stdio.h>
+#include <stdlib.h>
 #include <math.h>
 #include <string.h>
 #include "Log.h"
@@ -62,6 +66,8 @@
 #include "USBDM_API.h"
 #include "USBDM_API_Private.h"
 #include "low_level_usb.h"
+#include "low_level_loopback.h"
+#include "low_level_capture.h"
 #include "Names.h"
 #include "TargetDefines.h"
 #include "ARM_Definitions.h"
@@ -80,7 +86,9 @@ static const BDMState_t defaultBDMState = {
       false,           // powerCycleRetryAbort; - Disable connection retries
       true,            // useOnlyEp0;           - JB16 BDM only use EP0
       T_OFF,           // targetType;           - Target connected to BDM
-      BDM_INACTIVE};   // activityFlag;         - Indicates the BDM has been asked to do something interesting
+      BDM_INACTIVE,    // activityFlag;         - Indicates the BDM has been asked to do something interesting
+      false,           // useLoopback;          - Use simulated BDM instead of USB
+      false};          // useReplay;            - Replay captured transactions
 BDMState_t bdmState = defaultBDMState;
 
 //! Structure describing characteristics of currently open BDM
@@ -128,6 +136,24 @@ static USBDM_ErrorCode updateBdmInfo(void);
 //=============================================================================
 //=============================================================================
 
+//! Splits an environment variable of the form <file>[,<number>]
+//!
+//! @param value    - Value to split
+//! @param fileName - Buffer for file name
+//! @param size     - Size of fileName buffer
+//! @param option   - Number following file name (0 if none)
+//!
+static void splitFileOption(const char *value, char *fileName, unsigned size, unsigned *option) {
+   strncpy(fileName, value, size-1);
+   fileName[size-1] = '\0';
+   *option = 0;
+   char *separator = strrchr(fileName, ',');
+   if (separator != NULL) {
+      *separator = '\0';
+      *option    = strtoul(separator+1, NULL, 10);
+   }
+}
+
 //! Initialises USB interface
 //!
 //! This must be done before any other operations.
@@ -136,6 +162,13 @@ static USBDM_ErrorCode updateBdmInfo(void);
 //!     BDM_RC_OK => OK \n
 //!     other     => USB Error - see \ref USBDM_ErrorCode
 //!
+//! @note If the environment variable USBDM_LOOPBACK is set a simulated BDM & target
+//!       are used instead of USB devices.  The value is the latency added to each
+//!       transaction in microseconds.
+//! @note If the environment variable USBDM_CAPTURE is set transactions are captured to a file.
+//!       If the environment variable USBDM_REPLAY is set transactions are replayed from a file.
+//!       See low_level_capture.h
+//!
 USBDM_API
 USBDM_ErrorCode USBDM_Init(void) {
 
@@ -145,6 +178,32 @@ USBDM_ErrorCode USBDM_Init(void) {
 
    bdmState = defaultBDMState;
 
+   const char *loopbackLatency = getenv("USBDM_LOOPBACK");
+   if (loopbackLatency != NULL) {
+      print("USBDM_Init() - Using loopback BDM, latency = %s us\n", loopbackLatency);
+      bdmState.useLoopback = true;
+      bdm_loopback_setLatency(strtoul(loopbackLatency, NULL, 10));
+   }
+   char        fileName[300];
+   unsigned    option;
+   const char *capture = getenv("USBDM_CAPTURE");
+   if (capture != NULL) {
+      // <file>[,<file size limit KB>]
+      splitFileOption(capture, fileName, sizeof(fileName), &option);
+      bdm_capture_open(fileName, option);
+   }
+   const char *replay = getenv("USBDM_REPLAY");
+   if (replay != NULL) {
+      // <file>[,<reproduce timing>]
+      splitFileOption(replay, fileName, sizeof(fileName), &option);
+      if (bdm_replay_open(fileName, option != 0) != BDM_RC_OK) {
+         return BDM_RC_FAIL;
+      }
+      // Loopback BDM provides device enumeration
+      bdmState.useReplay   = true;
+      bdmState.useLoopback = true;
+   }
+
    USBDM_ErrorCode rc = bdm_usb_init();
 
    bdmState.initialised = (rc == BDM_RC_OK);
@@ -169,6 +228,10 @@ USBDM_ErrorCode USBDM_Exit(void) {
 
    USBDM_ErrorCode rc = bdm_usb_exit();
 
+   bdm_capture_close();
+   if (bdmState.useReplay) {
+      bdm_replay_close();
+   }
    closeLogFile();
 
    bdmState.initialised = false;
@@ -562,6 +625,90 @@ USBDM_ErrorCode USBDM_GetBdmInformation(USBDM_bdmInformation_t *info) {
    return BDM_RC_OK;
 }
 
+//! \brief Obtains statistics for communication with the BDM
+//!
+//! Statistics are accumulated from USBDM_Init() or USBDM_ResetStatistics()
+//!
+//! @param statistics ptr to structure to contain the statistics
+//!
+//! @return \n
+//!     BDM_RC_OK => OK \n
+//!     other     => Error code - see \ref USBDM_ErrorCode
+//!
+//! @note The size element of statistics should be initialised before call.
+//!
+USBDM_API
+USBDM_ErrorCode USBDM_GetStatistics(USBDM_Statistics_t *statistics) {
+   static USBDM_Statistics_t currentStatistics;
+
+   print("USBDM_GetStatistics()\n");
+
+   unsigned size = statistics->size;
+
+   if (size > sizeof(USBDM_Statistics_t)) {
+      size = sizeof(USBDM_Statistics_t); // Must be a later version!
+   }
+   if (size == 0) {
+      return BDM_RC_ILLEGAL_PARAMS;
+   }
+   bdm_usb_getStatistics(&currentStatistics);
+
+   // Copy subset of structure that is common.
+   memcpy(statistics, &currentStatistics, size);
+   statistics->size = size; // Actual size returned
+
+   return BDM_RC_OK;
+}
+
+//! \brief Clears statistics for communication with the BDM
+//!
+//! @return \n
+//!     BDM_RC_OK => OK
+//!
+USBDM_API
+USBDM_ErrorCode USBDM_ResetStatistics(void) {
+
+   print("USBDM_ResetStatistics()\n");
+
+   return bdm_usb_resetStatistics();
+}
+
+//! \brief Obtains the timing breakdown of captured or replayed BDM transactions
+//!
+//! Capture & replay are enabled by the environment variables USBDM_CAPTURE & USBDM_REPLAY
+//! when USBDM_Init() is called.  The breakdowns are empty if they are not enabled.
+//!
+//! @param timing ptr to structure to contain the timing
+//!
+//! @return \n
+//!     BDM_RC_OK => OK \n
+//!     other     => Error code - see \ref USBDM_ErrorCode
+//!
+//! @note The size element of timing should be initialised before call.
+//!
+USBDM_API
+USBDM_ErrorCode USBDM_GetCaptureTiming(USBDM_CaptureTiming_t *timing) {
+   static USBDM_CaptureTiming_t currentTiming;
+
+   print("USBDM_GetCaptureTiming()\n");
+
+   unsigned size = timing->size;
+
+   if (size > sizeof(USBDM_CaptureTiming_t)) {
+      size = sizeof(USBDM_CaptureTiming_t); // Must be a later version!
+   }
+   if (size == 0) {
+      return BDM_RC_ILLEGAL_PARAMS;
+   }
+   bdm_capture_getTiming(&currentTiming);
+
+   // Copy subset of structure that is common.
+   memcpy(timing, &currentTiming, size);
+   timing->size = size; // Actual size returned
+
+   return BDM_RC_OK;
+}
+
 //! \brief Transmits BDM options to BDM interface
 //!
 //! @return \n
@@ -187,6 +187,8 @@ typedef struct {
    int                     useOnlyEp0;           //!< JB16 BDM only use EP0
    TargetType_t            targetType;           //!< Target connected to BDM
    BDMActivityState_t      activityFlag;         //!< Indicates the BDM has been asked to do something interesting
+   bool                    useLoopback;          //!< Use simulated BDM (see low_level_loopback.h) instead of USB
+   bool                    useReplay;            //!< Replay captured transactions (see low_level_capture.h)
 } BDMState_t;
 
 //! Internal state USBDM DLL
@@ -25,6 +25,9 @@
 
     Change History
    +=========================================================================
+   |  19 Oct 2026 | Added transaction statistics
+   |  19 Oct 2026 | Added capture & replay of transactions
+   |  19 Oct 2026 | Transactions may be redirected to loopback BDM
    |   6 May 2012 | Added BDM_RC_DEVICE_OPEN_FAILED error messages
    |  31 Mar 2011 | Added command toggle
    |  21 Dec 2010 | Fixed 1-off validation of device number in bdm_usb_open()
@@ -53,6 +56,8 @@
 #include "USBDM_API.h"
 #include "USBDM_API_Private.h"
 #include "low_level_usb.h"
+#include "low_level_loopback.h"
+#include "low_level_capture.h"
 #include "Names.h"
 
 #ifndef LIBUSB_SUCCESS
@@ -139,6 +144,9 @@ static libusb_device_handle *usbDeviceHandle = NULL;
 // Indicates LIBUSB has been initialised
 static bool initialised = FALSE;
 
+//! Statistics since bdm_usb_init() or bdm_usb_resetStatistics()
+static USBDM_Statistics_t statistics;
+
 //**********************************************************
 //!
 //! Sleep for given number of milliseconds (or longer!)
@@ -146,6 +154,7 @@ static bool initialised = FALSE;
 //! @param milliSeconds - number of milliseconds to sleep
 //!
 void milliSleep(int milliSeconds) {
+   uint32_t startTime = bdm_capture_getTime();
 #ifdef __unix__
    int rc;
    struct timespec sleepStruct = { 0, 1000000L*milliSeconds };
@@ -160,6 +169,65 @@ void milliSleep(int milliSeconds) {
 #else
    Sleep(milliSeconds);
 #endif
+   statistics.sleepCount++;
+   statistics.sleepTime += bdm_capture_getTime()-startTime;
+}
+
+//**********************************************************
+//!
+//! Add transaction to statistics
+//!
+//! @param command - Command byte
+//! @param txSize  - Bytes sent
+//! @param rxSize  - Bytes received
+//! @param rc      - Result of transaction
+//! @param time    - Transaction time (us)
+//!
+static void updateStatistics(uint8_t command, unsigned txSize, unsigned rxSize, USBDM_ErrorCode rc, uint32_t time) {
+   USBDM_CommandStatistics_t &entry = statistics.commands[command&0x7F];
+
+   entry.count++;
+   if (rc != BDM_RC_OK) {
+      entry.errors++;
+   }
+   entry.bytesOut  += txSize;
+   entry.bytesIn   += rxSize;
+   entry.totalTime += time;
+   if (time > entry.maxTime) {
+      entry.maxTime = time;
+   }
+   unsigned bucket = 0;
+   while ((bucket < USBDM_LATENCY_BUCKETS-1) && (time >= (64U<<bucket))) {
+      bucket++;
+   }
+   entry.latency[bucket]++;
+}
+
+//**********************************************************
+//!
+//! Get statistics for transactions
+//!
+//! @param stats - Updated with statistics
+//!
+//!  @return\n
+//!       BDM_RC_OK        - success
+//!
+USBDM_ErrorCode bdm_usb_getStatistics(USBDM_Statistics_t *stats) {
+   *stats      = statistics;
+   stats->size = sizeof(USBDM_Statistics_t);
+   return BDM_RC_OK;
+}
+
+//**********************************************************
+//!
+//! Clear statistics for transactions
+//!
+//!  @return\n
+//!       BDM_RC_OK        - success
+//!
+USBDM_ErrorCode bdm_usb_resetStatistics(void) {
+   memset(&statistics, 0, sizeof(statistics));
+   return BDM_RC_OK;
 }
 
 //**********************************************************
@@ -173,6 +241,12 @@ void milliSleep(int milliSeconds) {
 USBDM_ErrorCode bdm_usb_init( void ) {
 //   print("bdm_usb_init()\n");
 
+   bdm_usb_resetStatistics();
+
+   if (bdmState.useLoopback) {
+      return bdm_loopback_init();
+   }
+
    // Not initialised
    initialised = FALSE;
 
@@ -194,6 +268,10 @@ USBDM_ErrorCode bdm_usb_init( void ) {
 USBDM_ErrorCode bdm_usb_exit( void ) {
 //   print("bdm_usb_exit()\n");
 
+   if (bdmState.useLoopback) {
+      return bdm_loopback_exit();
+   }
+
    if (initialised) {
       bdm_usb_close();     // Close any open devices
       print("bdm_usb_exit() - libusb_exit() called\n");
@@ -247,6 +325,12 @@ USBDM_ErrorCode bdm_usb_findDevices(unsigned *devCount) {
    // Release any currently referenced devices
    bdm_usb_releaseDevices();
 
+   if (bdmState.useLoopback) {
+      rc = bdm_loopback_findDevices(devCount);
+      deviceCount = *devCount;
+      return rc;
+   }
+
    if (!initialised) {
       print("bdm_usb_find_devices() - Not initialised! \n");
       rc = bdm_usb_init(); // try again
@@ -336,6 +420,10 @@ USBDM_ErrorCode bdm_usb_open( unsigned int device_no ) {
 
 //   print("bdm_usb_open( %d )\n", device_no);
 
+   if (bdmState.useLoopback) {
+      return bdm_loopback_open(device_no);
+   }
+
    if (!initialised) {
       print("bdm_usb_open() - Not initialised! \n");
       return PROGRAMMING_RC_ERROR_INTERNAL_CHECK_FAILED;
@@ -419,6 +507,9 @@ USBDM_ErrorCode bdm_usb_close( void ) {
    int rc;
 
    //   print("bdm_usb_close()\n");
+   if (bdmState.useLoopback) {
+      return bdm_loopback_close();
+   }
    if (usbDeviceHandle == NULL) {
       print("bdm_usb_close() - device not open - no action\n");
       return BDM_RC_OK;
@@ -463,6 +554,9 @@ USBDM_ErrorCode bdm_usb_close( void ) {
 USBDM_ErrorCode bdm_usb_getStringDescriptor(int index, char *descriptorBuffer, unsigned maxLength) {
    const int DT_STRING = 3;
 
+   if (bdmState.useLoopback) {
+      return bdm_loopback_getStringDescriptor(index, descriptorBuffer, maxLength);
+   }
    memset(descriptorBuffer, '\0', maxLength);
 
    if (usbDeviceHandle == NULL) {
@@ -528,6 +622,10 @@ USBDM_ErrorCode bdm_usb_send_ep0( const unsigned char * data ) {
    int rc;
    unsigned index;
 
+   if (bdmState.useLoopback) {
+      print("bdm_usb_send_ep0() - Not supported by loopback BDM\n");
+      return BDM_RC_ILLEGAL_COMMAND;
+   }
    if (usbDeviceHandle == NULL) {
       print("bdm_usb_send_ep0() - Device handle NULL!\n");
       return BDM_RC_DEVICE_NOT_OPEN;
@@ -580,7 +678,7 @@ USBDM_ErrorCode bdm_usb_send_ep0( const unsigned char * data ) {
 //!    == BDM_RC_USB_ERROR  => USB failure \n
 //!    == else              => Error code from Device
 //!
-USBDM_ErrorCode bdm_usb_recv_ep0(unsigned char *data, unsigned *actualRxSize) {
+static USBDM_ErrorCode usb_recv_ep0(unsigned char *data, unsigned *actualRxSize) {
    unsigned char size = data[0];   // Transfer size is the first byte
    unsigned char cmd  = data[1];   // OSBDM/TBDML Command byte
    int rc;
@@ -588,6 +686,9 @@ USBDM_ErrorCode bdm_usb_recv_ep0(unsigned char *data, unsigned *actualRxSize) {
 
    *actualRxSize = 0;
 
+   if (bdmState.useLoopback) {
+      return bdm_loopback_recv_ep0(data, actualRxSize);
+   }
    if (usbDeviceHandle == NULL) {
       print("bdm_usb_recv_ep0() - ERROR : Device handle NULL!\n");
       data[0] = BDM_RC_DEVICE_NOT_OPEN;
@@ -640,6 +741,30 @@ USBDM_ErrorCode bdm_usb_recv_ep0(unsigned char *data, unsigned *actualRxSize) {
    return(BDM_RC_OK);
 }
 
+//! \brief Sends a message of up to 5 bytes to the USB device and
+//!  receives up to 255 bytes in response - see \ref usb_recv_ep0()
+//!
+//! The transfer is captured and/or replayed if enabled (see low_level_capture.h)
+//!
+USBDM_ErrorCode bdm_usb_recv_ep0(unsigned char *data, unsigned *actualRxSize) {
+   USBDM_ErrorCode rc;
+   unsigned char   command[6];
+   uint32_t        startTime = bdm_capture_getTime();
+
+   memcpy(command, data, sizeof(command));
+   if (bdmState.useReplay) {
+      rc = bdm_replay_recv_ep0(data, actualRxSize);
+   }
+   else {
+      rc = usb_recv_ep0(data, actualRxSize);
+   }
+   updateStatistics(command[1], sizeof(command), *actualRxSize, rc, bdm_capture_getTime()-startTime);
+   if (bdm_capture_isActive()) {
+      bdm_capture_record(CAPTURE_EP0, startTime, command, sizeof(command), data, *actualRxSize, rc);
+   }
+   return rc;
+}
+
 //*****************************************************************************
 //*****************************************************************************
 //*****************************************************************************
@@ -669,6 +794,10 @@ USBDM_ErrorCode bdm_usb_raw_send_ep0(unsigned int  request,
                                      unsigned int  size,
                                      const unsigned char *data) {
    int rc;
+   if (bdmState.useLoopback) {
+      print("bdm_usb_raw_send_ep0() - Not supported by loopback BDM\n");
+      return BDM_RC_ILLEGAL_COMMAND;
+   }
    if (usbDeviceHandle == NULL) {
       print("bdm_usb_raw_send_ep0() - device not open\n");
       return BDM_RC_DEVICE_NOT_OPEN;
@@ -717,6 +846,11 @@ USBDM_ErrorCode bdm_usb_raw_recv_ep0(unsigned int  request,
                                      unsigned int  size,
                                      unsigned char *data) {
    int rc;
+   if (bdmState.useLoopback) {
+      print("bdm_usb_raw_recv_ep0() - Not supported by loopback BDM\n");
+      data[0] = BDM_RC_ILLEGAL_COMMAND;
+      return BDM_RC_ILLEGAL_COMMAND;
+   }
    if (usbDeviceHandle == NULL) {
       print("bdm_usb_raw_recv_ep0() - device not open\n");
       data[0] = BDM_RC_DEVICE_NOT_OPEN;
@@ -920,7 +1054,7 @@ USBDM_ErrorCode bdmJB16_usb_transaction( unsigned int   txSize,
    if (txSize <= 5) {
       // Transmission fits in SETUP pkt, Use single IN Data transfer to/from EP0
       *data = rxSize;
-      rc = bdm_usb_recv_ep0( data, actualRxSize);
+      rc = usb_recv_ep0( data, actualRxSize);
    }
    else {
       // Transmission requires separate IN transaction
@@ -930,7 +1064,7 @@ USBDM_ErrorCode bdmJB16_usb_transaction( unsigned int   txSize,
          // Get response
          data[0] = rxSize;
          data[1] = CMD_USBDM_GET_COMMAND_RESPONSE; // dummy command
-         rc = bdm_usb_recv_ep0(data, actualRxSize);
+         rc = usb_recv_ep0(data, actualRxSize);
       }
    }
    if (rc != BDM_RC_OK) {
@@ -980,6 +1114,7 @@ USBDM_ErrorCode bdmJMxx_usb_transaction( unsigned int   txSize,
       if (rc != BDM_RC_OK) {
          reportFlag = true;
          print("bdmJMxx_usb_transaction() Tx1 failed\n");
+         statistics.usbRetries++;
          continue;
       }
       // Remainder of data (if any) is sent as 2nd transaction
@@ -996,6 +1131,7 @@ USBDM_ErrorCode bdmJMxx_usb_transaction( unsigned int   txSize,
       if (rc != BDM_RC_OK) {
          reportFlag = true;
          print("bdmJMxx_usb_transaction() Tx2 failed\n");
+         statistics.usbRetries++;
          continue;
       }
       // Get response
@@ -1005,6 +1141,7 @@ USBDM_ErrorCode bdmJMxx_usb_transaction( unsigned int   txSize,
       if ((rc == BDM_RC_USB_ERROR) || (commandToggle != receivedCommandToggle)) {
          // Retry on single USB fail or toggle error
          print("bdmJMxx_usb_transaction() USB or Toggle error, seq = %d, S=%d, R=%d\n", sequence, commandToggle?1:0, receivedCommandToggle?1:0);
+         statistics.toggleRetries++;
          milliSleep(100);
          rc = bdm_usb_recv_epIn(rxSize, data, actualRxSize);
          receivedCommandToggle = (data[0]&0x80) != 0;
@@ -1022,12 +1159,14 @@ USBDM_ErrorCode bdmJMxx_usb_transaction( unsigned int   txSize,
          // Retry entire command
          reportFlag = true;
          print("bdmJMxx_usb_transaction() USB error, seq = %d, retrying command\n", sequence);
+         statistics.usbRetries++;
          continue;
       }
       // Don't toggle on busy -
       if (rc == BDM_RC_BUSY) {
          reportFlag = true;
          print("bdmJMxx_usb_transaction() BUSY response, seq = %d\n", sequence);
+         statistics.busyResponses++;
          continue;
       }
       if (reportFlag) {
@@ -1072,27 +1211,49 @@ USBDM_ErrorCode bdmJMxx_usb_transaction( unsigned int   txSize,
 //!    == BDM_RC_USB_ERROR  => USB failure                           \n
 //!    == else              => Error code from BDM
 //!
+//! @note The transaction is captured and/or replayed if enabled (see low_level_capture.h)
+//!
 USBDM_ErrorCode bdm_usb_transaction( unsigned int   txSize,
                                      unsigned int   rxSize,
                                      unsigned char *data,
                                      unsigned int   timeout,
                                      unsigned int  *actualRxSize) {
    USBDM_ErrorCode rc;
-   unsigned tempRxSize;
-   uint8_t command = data[1];
-
-   if (usbDeviceHandle==NULL) {
+   unsigned tempRxSize = 0;
+   uint8_t  command    = data[1];
+   uint8_t  txData[MAX_PACKET_SIZE];   // Copy of command for capture
+   unsigned txCaptureSize = 0;
+   uint32_t startTime;
+   bool     capture    = bdm_capture_isActive();
+
+   if ((usbDeviceHandle==NULL) && !bdmState.useLoopback) {
       print("bdm_usb_transaction(): device not open\n");
 	  return BDM_RC_DEVICE_NOT_OPEN;
    }
    timeoutValue = timeout;
 
-   if (bdmState.useOnlyEp0) {
+   if (capture) {
+      // Capture records are limited to MAX_PACKET_SIZE bytes of command
+      txCaptureSize = (txSize<sizeof(txData))?txSize:sizeof(txData);
+      memcpy(txData, data, txCaptureSize);
+   }
+   startTime = bdm_capture_getTime();
+   if (bdmState.useReplay) {
+      rc = bdm_replay_transaction( txSize, rxSize, data, &tempRxSize);
+   }
+   else if (bdmState.useLoopback) {
+      rc = bdm_loopback_transaction( txSize, rxSize, data, &tempRxSize);
+   }
+   else if (bdmState.useOnlyEp0) {
       rc = bdmJB16_usb_transaction( txSize, rxSize, data, &tempRxSize);
    }
    else {
       rc = bdmJMxx_usb_transaction( txSize, rxSize, data, &tempRxSize);
    }
+   uint32_t transactionTime = bdm_capture_getTime()-startTime;
+   if (capture) {
+      bdm_capture_record(CAPTURE_TRANSACTION, startTime, txData, txCaptureSize, data, tempRxSize, rc);
+   }
    if (actualRxSize != NULL) {
       // Variable size data expected
       *actualRxSize = tempRxSize;
@@ -1103,6 +1264,7 @@ USBDM_ErrorCode bdm_usb_transaction( unsigned int   txSize,
             getCommandName(command), rxSize, tempRxSize);
       rc = BDM_RC_UNEXPECTED_RESPONSE;
    }
+   updateStatistics(command, txSize, tempRxSize, rc, transactionTime);
    if (rc != BDM_RC_OK) {
       print("bdm_usb_transaction() - Failed, cmd = %s, rc = %s\n",
             getCommandName(command), getErrorName(rc));
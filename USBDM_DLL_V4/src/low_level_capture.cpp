@@ -0,0 +1,563 @@
+/*! \file
+    \brief Capture & replay of BDM transactions at the bdm_usb_transaction() boundary.
+
+    \verbatim
+    USBDM - USB communication DLL
+    Copyright (C) 2026  agent
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    Change History
+   +=========================================================================
+   |  19 Oct 2026 | Capture file is appended as records are captured
+   |  19 Oct 2026 | Capture file is written periodically & after errors
+   |  19 Oct 2026 | Created
+   +==========================================================================
+    \endverbatim
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#include <errno.h>
+#endif
+#include "Log.h"
+#include "Common.h"
+#include "USBDM_API.h"
+#include "USBDM_API_Private.h"
+#include "low_level_capture.h"
+#include "Names.h"
+
+static const char     captureMagic[4]   = {'U','D','M','C'};
+static const unsigned captureVersion    = 1;
+static const unsigned fileHeaderSize    = 20;
+static const unsigned recordHeaderSize  = 12;
+
+//=============================================================================
+// Helpers
+
+static void put16(unsigned char *buffer, unsigned value) {
+   buffer[0] = (unsigned char)value;
+   buffer[1] = (unsigned char)(value>>8);
+}
+
+static void put32(unsigned char *buffer, uint32_t value) {
+   buffer[0] = (unsigned char)value;
+   buffer[1] = (unsigned char)(value>>8);
+   buffer[2] = (unsigned char)(value>>16);
+   buffer[3] = (unsigned char)(value>>24);
+}
+
+static unsigned get16(const unsigned char *buffer) {
+   return buffer[0]+(buffer[1]<<8);
+}
+
+static uint32_t get32(const unsigned char *buffer) {
+   return buffer[0]+(buffer[1]<<8)+(buffer[2]<<16)+((uint32_t)buffer[3]<<24);
+}
+
+//! Sleep for given number of microseconds
+//!
+static void microSleep(uint32_t microSeconds) {
+   if (microSeconds == 0) {
+      return;
+   }
+#ifdef __unix__
+   struct timespec sleepStruct = { microSeconds/1000000, 1000L*(microSeconds%1000000) };
+   while ((nanosleep(&sleepStruct, &sleepStruct) < 0) && (errno == EINTR)) {
+   }
+#else
+   Sleep((microSeconds+999)/1000);
+#endif
+}
+
+//! Get current time
+//!
+//! @return time in microseconds (modulo 2^32) from an arbitrary reference
+//!
+uint32_t bdm_capture_getTime(void) {
+#ifdef __unix__
+   struct timespec now;
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   return (uint32_t)(now.tv_sec*1000000ULL + now.tv_nsec/1000);
+#else
+   LARGE_INTEGER frequency, now;
+   QueryPerformanceFrequency(&frequency);
+   QueryPerformanceCounter(&now);
+   return (uint32_t)((now.QuadPart*1000000ULL)/frequency.QuadPart);
+#endif
+}
+
+//=============================================================================
+// Timing breakdown
+
+//! Add a transfer to a timing breakdown
+//!
+//! @param timing    - Breakdown to update
+//! @param lastEnd   - Time the previous transfer ended (updated)
+//! @param startTime - Time transfer was started
+//! @param roundTrip - Round-trip time of transfer
+//! @param command   - Command byte of transfer
+//! @param rc        - Result of transfer
+//!
+//! @note Idle time is the time from the end of one transfer to the start of the next
+//!       i.e. time spent in the host (DLL & application)
+//!
+static void addTiming(USBDM_TimingBreakdown_t &timing,
+                      uint32_t                &lastEnd,
+                      uint32_t                 startTime,
+                      uint32_t                 roundTrip,
+                      unsigned                 command,
+                      unsigned                 rc) {
+   USBDM_CommandTiming_t &entry = timing.commands[command&0x7F];
+   if ((entry.count == 0) || (roundTrip < entry.minimum)) {
+      entry.minimum = roundTrip;
+   }
+   if (roundTrip > entry.maximum) {
+      entry.maximum = roundTrip;
+   }
+   entry.count++;
+   if (rc != BDM_RC_OK) {
+      entry.errors++;
+   }
+   entry.roundTrip  += roundTrip;
+   timing.roundTrip += roundTrip;
+   if (timing.records > 0) {
+      // Unsigned difference is correct across wrap of 32-bit time
+      uint32_t idle = startTime-lastEnd;
+      entry.idle  += idle;
+      timing.idle += idle;
+   }
+   timing.records++;
+   lastEnd = startTime+roundTrip;
+}
+
+//! Log round-trip & idle-time breakdown
+//!
+//! @param title  - Heading for report
+//! @param timing - Breakdown to report
+//!
+static void reportTiming(const char *title, const USBDM_TimingBreakdown_t &timing) {
+   double elapsed = (double)(timing.roundTrip+timing.idle);
+   print("%s - %lu records (%lu discarded), elapsed = %.1f ms, USB = %.1f ms (%.0f%%), idle = %.1f ms\n",
+         title, timing.records, timing.discarded,
+         elapsed/1000.0, timing.roundTrip/1000.0,
+         (elapsed>0)?(100*timing.roundTrip/elapsed):0.0, timing.idle/1000.0);
+   print("   %-36s %7s %6s %11s %9s %9s %9s %11s\n",
+         "Command", "Count", "Errors", "USB(ms)", "Mean(us)", "Min(us)", "Max(us)", "Idle(ms)");
+   for (unsigned command=0; command<sizeof(timing.commands)/sizeof(timing.commands[0]); command++) {
+      const USBDM_CommandTiming_t &entry = timing.commands[command];
+      if (entry.count == 0) {
+         continue;
+      }
+      print("   %-36s %7lu %6lu %11.1f %9.0f %9lu %9lu %11.1f\n",
+            getCommandName(command), entry.count, entry.errors,
+            entry.roundTrip/1000.0, (double)entry.roundTrip/entry.count,
+            entry.minimum, entry.maximum, entry.idle/1000.0);
+   }
+}
+
+//=============================================================================
+// Capture
+
+static FILE                   *captureFp      = NULL;  //!< Capture file (NULL => capture inactive)
+static char                    captureFile[300];       //!< Name of capture file
+static unsigned long           fileLimit      = 0;     //!< Size limit for capture file (bytes)
+static unsigned long           fileSize       = 0;     //!< Bytes written to current capture file
+static unsigned long           fileRecords    = 0;     //!< Records in current capture file
+static unsigned long           earlierRecords = 0;     //!< Records in earlier capture files
+static uint32_t                lastFlushTime  = 0;     //!< Time capture file was last flushed
+static uint32_t                captureLastEnd = 0;     //!< End of last captured transfer
+static USBDM_TimingBreakdown_t captureTiming;          //!< Timing of all captured transfers
+
+//! Interval between flushes of the capture file (us)
+#define CAPTURE_FLUSH_INTERVAL (1000000)
+
+//! Write capture file header
+//!
+//! @param fp      - File to write header to (at start of file)
+//! @param records - Number of records in file (0 => unknown, read to end of file)
+//!
+//! @return true => success
+//!
+static bool writeFileHeader(FILE *fp, unsigned long records) {
+   unsigned char header[fileHeaderSize];
+   memcpy(header, captureMagic, sizeof(captureMagic));
+   put16(header+4,  captureVersion);
+   put16(header+6,  fileHeaderSize);
+   put32(header+8,  records);
+   put32(header+12, earlierRecords);
+   put32(header+16, fileLimit);
+   return fwrite(header, 1, fileHeaderSize, fp) == fileHeaderSize;
+}
+
+//! Start a new capture file
+//!
+//! @return \n
+//!    BDM_RC_OK     => Success \n
+//!    BDM_RC_FAIL   => Failed to create file
+//!
+static USBDM_ErrorCode startCaptureFile(void) {
+   captureFp = fopen(captureFile, "wb");
+   if ((captureFp == NULL) || !writeFileHeader(captureFp, 0)) {
+      print("startCaptureFile() - Failed to create \'%s\'\n", captureFile);
+      if (captureFp != NULL) {
+         fclose(captureFp);
+         captureFp = NULL;
+      }
+      return BDM_RC_FAIL;
+   }
+   fileSize      = fileHeaderSize;
+   fileRecords   = 0;
+   lastFlushTime = bdm_capture_getTime();
+   return BDM_RC_OK;
+}
+
+//! Finish current capture file
+//!
+//! The record count in the header is updated and the file closed
+//!
+//! @return \n
+//!    BDM_RC_OK     => Success \n
+//!    BDM_RC_FAIL   => Failed to write file
+//!
+static USBDM_ErrorCode finishCaptureFile(void) {
+   USBDM_ErrorCode rc = BDM_RC_OK;
+   if ((fseek(captureFp, 0, SEEK_SET) != 0) ||
+       !writeFileHeader(captureFp, fileRecords) ||
+       (fclose(captureFp) != 0)) {
+      print("finishCaptureFile() - Failed to write \'%s\'\n", captureFile);
+      rc = BDM_RC_FAIL;
+   }
+   captureFp = NULL;
+   return rc;
+}
+
+//! Move the current capture file to <captureFile>.1 and start a new one
+//!
+//! @return \n
+//!    BDM_RC_OK     => Success \n
+//!    BDM_RC_FAIL   => Failed to write file
+//!
+static USBDM_ErrorCode rotateCaptureFile(void) {
+   char oldFile[sizeof(captureFile)+2];
+
+   finishCaptureFile();
+   snprintf(oldFile, sizeof(oldFile), "%s.1", captureFile);
+   remove(oldFile);
+   if (rename(captureFile, oldFile) != 0) {
+      print("rotateCaptureFile() - Failed to rename \'%s\'\n", captureFile);
+   }
+   earlierRecords += fileRecords;
+   return startCaptureFile();
+}
+
+//! Open capture
+//!
+//! @param fileName    - File to write
+//! @param fileLimitKB - Size limit for capture file in KB (0 => 1024)
+//!
+//! @return \n
+//!    BDM_RC_OK                 => Success \n
+//!    BDM_RC_ILLEGAL_PARAMS     => Empty file name \n
+//!    BDM_RC_FAIL               => Failed to create file
+//!
+USBDM_ErrorCode bdm_capture_open(const char *fileName, unsigned fileLimitKB) {
+
+   bdm_capture_close();
+
+   if ((fileName == NULL) || (*fileName == '\0')) {
+      return BDM_RC_ILLEGAL_PARAMS;
+   }
+   if (fileLimitKB == 0) {
+      fileLimitKB = 1024;
+   }
+   strncpy(captureFile, fileName, sizeof(captureFile)-1);
+   captureFile[sizeof(captureFile)-1] = '\0';
+   fileLimit      = fileLimitKB*1024UL;
+   earlierRecords = 0;
+   captureLastEnd = 0;
+   memset(&captureTiming, 0, sizeof(captureTiming));
+   USBDM_ErrorCode rc = startCaptureFile();
+   if (rc != BDM_RC_OK) {
+      return rc;
+   }
+   print("bdm_capture_open() - Capturing to \'%s\', limit = %d KB\n", captureFile, fileLimitKB);
+   return BDM_RC_OK;
+}
+
+//! Indicates if capture is active
+//!
+bool bdm_capture_isActive(void) {
+   return captureFp != NULL;
+}
+
+//! Add record to capture
+//!
+//! @param type      - Type of transfer
+//! @param startTime - Time transfer was started (from bdm_capture_getTime())
+//! @param txData    - Command sent
+//! @param txSize    - Size of command
+//! @param rxData    - Response received
+//! @param rxSize    - Size of response
+//! @param rc        - Result of transfer
+//!
+//! @note The record is appended to the capture file.  The file is flushed periodically
+//!       and after a failed transfer so that it is available if the application does
+//!       not exit cleanly.
+//!
+void bdm_capture_record(CaptureType_t        type,
+                        uint32_t             startTime,
+                        const unsigned char *txData,
+                        unsigned int         txSize,
+                        const unsigned char *rxData,
+                        unsigned int         rxSize,
+                        USBDM_ErrorCode      rc) {
+   uint32_t roundTrip = bdm_capture_getTime()-startTime;
+
+   if (captureFp == NULL) {
+      return;
+   }
+   if (txSize > 255) {
+      txSize = 255;
+   }
+   if (rxSize > 255) {
+      rxSize = 255;
+   }
+   addTiming(captureTiming, captureLastEnd, startTime, roundTrip, (txSize>1)?txData[1]:0, rc);
+
+   unsigned recordSize = recordHeaderSize+txSize+rxSize;
+   if ((fileRecords > 0) && (fileSize+recordSize > fileLimit)) {
+      if (rotateCaptureFile() != BDM_RC_OK) {
+         return;
+      }
+   }
+   unsigned char header[recordHeaderSize];
+   put32(header,   startTime);
+   put32(header+4, roundTrip);
+   header[8]  = (unsigned char)type;
+   header[9]  = (unsigned char)rc;
+   header[10] = (unsigned char)txSize;
+   header[11] = (unsigned char)rxSize;
+   fwrite(header, 1, recordHeaderSize, captureFp);
+   fwrite(txData, 1, txSize, captureFp);
+   fwrite(rxData, 1, rxSize, captureFp);
+   fileSize += recordSize;
+   fileRecords++;
+
+   if ((rc != BDM_RC_OK) || (bdm_capture_getTime()-lastFlushTime >= CAPTURE_FLUSH_INTERVAL)) {
+      fflush(captureFp);
+      lastFlushTime = bdm_capture_getTime();
+   }
+}
+
+//! Close capture
+//!
+//! The capture file is completed and the timing report logged
+//!
+//! @return \n
+//!    BDM_RC_OK     => Success (or capture not active)\n
+//!    BDM_RC_FAIL   => Failed to write file
+//!
+USBDM_ErrorCode bdm_capture_close(void) {
+   if (captureFp == NULL) {
+      return BDM_RC_OK;
+   }
+   USBDM_ErrorCode rc = finishCaptureFile();
+   reportTiming("bdm_capture_close() - Capture", captureTiming);
+   return rc;
+}
+
+//=============================================================================
+// Replay
+
+static std::vector<unsigned char> replayData;           //!< Records from capture file
+static unsigned                   replayOffset = 0;     //!< Offset of next record
+static unsigned long              replayCount  = 0;     //!< Records replayed
+static unsigned long              divergences  = 0;     //!< Commands that differed from capture
+static bool                       replayTiming = false; //!< Reproduce recorded round-trip time
+static USBDM_TimingBreakdown_t    recordedTiming;       //!< Timing of records in capture file
+
+//! Open capture file for replay
+//!
+//! @param fileName        - Capture file to replay
+//! @param reproduceTiming - Delay each response by the recorded round-trip time
+//!
+//! @return \n
+//!    BDM_RC_OK     => Success \n
+//!    BDM_RC_FAIL   => File missing or invalid
+//!
+USBDM_ErrorCode bdm_replay_open(const char *fileName, bool reproduceTiming) {
+   unsigned char header[fileHeaderSize];
+
+   replayData.clear();
+   replayOffset = 0;
+   replayCount  = 0;
+   divergences  = 0;
+   replayTiming = reproduceTiming;
+   memset(&recordedTiming, 0, sizeof(recordedTiming));
+
+   FILE *fp = fopen(fileName, "rb");
+   if (fp == NULL) {
+      print("bdm_replay_open() - Failed to open \'%s\'\n", fileName);
+      return BDM_RC_FAIL;
+   }
+   if ((fread(header, 1, fileHeaderSize, fp) != fileHeaderSize) ||
+       (memcmp(header, captureMagic, sizeof(captureMagic)) != 0) ||
+       (get16(header+4) != captureVersion) ||
+       (get16(header+6) < fileHeaderSize)) {
+      print("bdm_replay_open() - \'%s\' is not a capture file\n", fileName);
+      fclose(fp);
+      return BDM_RC_FAIL;
+   }
+   fseek(fp, get16(header+6), SEEK_SET);
+   unsigned char buffer[1024];
+   size_t size;
+   while ((size = fread(buffer, 1, sizeof(buffer), fp)) > 0) {
+      replayData.insert(replayData.end(), buffer, buffer+size);
+   }
+   fclose(fp);
+
+   // The record count is 0 if the capture was not closed - records are read to end of file
+   uint32_t lastEnd = 0;
+   recordedTiming.discarded = get32(header+12);
+   for (unsigned offset=0; offset+recordHeaderSize <= replayData.size(); ) {
+      const unsigned char *record = &replayData[offset];
+      unsigned txSize = record[10];
+      addTiming(recordedTiming, lastEnd, get32(record), get32(record+4),
+                (txSize>1)?record[recordHeaderSize+1]:0, record[9]);
+      offset += recordHeaderSize+txSize+record[11];
+   }
+   if ((get32(header+8) != 0) && (get32(header+8) != recordedTiming.records)) {
+      print("bdm_replay_open() - \'%s\' has %lu records, header indicates %lu\n",
+            fileName, recordedTiming.records, (unsigned long)get32(header+8));
+   }
+   print("bdm_replay_open() - Replaying \'%s\'%s\n", fileName, reproduceTiming?", reproducing timing":"");
+   reportTiming("bdm_replay_open() - Recorded", recordedTiming);
+   return BDM_RC_OK;
+}
+
+//! Close replay
+//!
+//! @return BDM_RC_OK
+//!
+USBDM_ErrorCode bdm_replay_close(void) {
+   unsigned long remaining = 0;
+   for (unsigned offset=replayOffset; offset+recordHeaderSize <= replayData.size(); remaining++) {
+      offset += recordHeaderSize+replayData[offset+10]+replayData[offset+11];
+   }
+   print("bdm_replay_close() - %lu records replayed, %lu not used, %lu divergences\n",
+         replayCount, remaining, divergences);
+   replayData.clear();
+   replayOffset = 0;
+   return BDM_RC_OK;
+}
+
+//! Replay next record
+//!
+//! @param type         - Type of transfer
+//! @param txSize       - Size of command
+//! @param rxSize       - Maximum size of response
+//! @param data         - Command/Response buffer (see bdm_usb_transaction())
+//! @param actualRxSize - Size of response
+//!
+//! @return Result recorded for transfer \n
+//!    BDM_RC_USB_ERROR           => No more records \n
+//!    BDM_RC_UNEXPECTED_RESPONSE => Command differs from that recorded
+//!
+static USBDM_ErrorCode replay(CaptureType_t  type,
+                              unsigned int   txSize,
+                              unsigned int   rxSize,
+                              unsigned char *data,
+                              unsigned int  *actualRxSize) {
+   uint8_t command = data[1];
+
+   *actualRxSize = 0;
+   if (replayOffset+recordHeaderSize > replayData.size()) {
+      print("replay(%s) - Capture exhausted after %lu records\n", getCommandName(command), replayCount);
+      data[0] = BDM_RC_USB_ERROR;
+      return BDM_RC_USB_ERROR;
+   }
+   const unsigned char *record = &replayData[replayOffset];
+   unsigned recordedTxSize = record[10];
+   unsigned recordedRxSize = record[11];
+   const unsigned char *recordedTx = record+recordHeaderSize;
+   const unsigned char *recordedRx = recordedTx+recordedTxSize;
+
+   if (replayOffset+recordHeaderSize+recordedTxSize+recordedRxSize > replayData.size()) {
+      print("replay(%s) - Capture truncated\n", getCommandName(command));
+      replayOffset = replayData.size();
+      data[0] = BDM_RC_USB_ERROR;
+      return BDM_RC_USB_ERROR;
+   }
+   replayOffset += recordHeaderSize+recordedTxSize+recordedRxSize;
+   replayCount++;
+
+   if ((record[8] != type) || (recordedTxSize < 2) || (recordedTx[1] != command)) {
+      divergences++;
+      print("replay() - #%lu Command %s differs from capture %s\n", replayCount,
+            getCommandName(command), (recordedTxSize<2)?"-":getCommandName(recordedTx[1]));
+      data[0] = BDM_RC_UNEXPECTED_RESPONSE;
+      return BDM_RC_UNEXPECTED_RESPONSE;
+   }
+   // data[0] is not meaningful in the command
+   if ((recordedTxSize != txSize) || ((txSize > 2) && (memcmp(recordedTx+2, data+2, txSize-2) != 0))) {
+      divergences++;
+      print("replay() - #%lu Command %s parameters differ from capture\n", replayCount, getCommandName(command));
+      printDump(recordedTx, recordedTxSize);
+      printDump(data, txSize);
+   }
+   if (replayTiming) {
+      microSleep(get32(record+4));
+   }
+   if (recordedRxSize > rxSize) {
+      recordedRxSize = rxSize;
+   }
+   memset(data, 0, rxSize);
+   memcpy(data, recordedRx, recordedRxSize);
+   data[0]       = record[9];
+   *actualRxSize = recordedRxSize;
+   return (USBDM_ErrorCode)record[9];
+}
+
+//! Replay equivalent of bdm_usb_recv_ep0()
+//!
+USBDM_ErrorCode bdm_replay_recv_ep0(unsigned char *data, unsigned *actualRxSize) {
+   return replay(CAPTURE_EP0, 6, data[0], data, actualRxSize);
+}
+
+//! Replay equivalent of bdm_usb_transaction()
+//!
+USBDM_ErrorCode bdm_replay_transaction(unsigned int   txSize,
+                                       unsigned int   rxSize,
+                                       unsigned char *data,
+                                       unsigned int  *actualRxSize) {
+   return replay(CAPTURE_TRANSACTION, txSize, rxSize, data, actualRxSize);
+}
+
+//! Get timing breakdown of captured & replayed transfers
+//!
+//! @param timing - Structure to receive timing (size is not used)
+//!
+void bdm_capture_getTiming(USBDM_CaptureTiming_t *timing) {
+   timing->capture     = captureTiming;
+   timing->recorded    = recordedTiming;
+   timing->replayed    = replayCount;
+   timing->divergences = divergences;
+}
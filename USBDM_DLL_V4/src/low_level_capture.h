@@ -0,0 +1,82 @@
+/*! \file
+    \brief Capture & replay of BDM transactions at the bdm_usb_transaction() boundary.
+
+    Capture is enabled by setting the environment variable USBDM_CAPTURE
+    before USBDM_Init() is called e.g. USBDM_CAPTURE=usbdm.cap,4096
+     - The value is the capture file name optionally followed by the size limit of
+       the capture file in KB (default 1024).  When the limit is reached the file is
+       renamed to <name>.1 (replacing any earlier one) and a new file started.
+     - Each record is appended to the file as it is captured.  The file is flushed
+       every second and after a failed transaction so that a capture survives a crash
+       of the application.
+     - The record count in the header is written and a timing report added to the log
+       by USBDM_Exit().
+     - The timing breakdown is available from USBDM_GetCaptureTiming() (Tcl: capturetiming).
+
+    Replay is enabled by setting the environment variable USBDM_REPLAY
+    e.g. USBDM_REPLAY=usbdm.cap,1
+     - The value is the capture file name optionally followed by 1 to reproduce
+       the recorded round-trip time of each transaction.
+     - Responses are taken from the capture file in sequence in place of the BDM.
+       Differences between the commands issued and those recorded are logged and
+       counted (see USBDM_GetCaptureTiming()).
+     - Device enumeration is provided by the loopback BDM (see low_level_loopback.h).
+
+    Capture & replay may be used together to time the host side of a recorded session.
+
+    \verbatim
+    File format (all values little-endian)
+
+    Header
+      0   char[4]  "UDMC"
+      4   uint16   Version (1)
+      6   uint16   Header size (20)
+      8   uint32   Number of records (0 => not known, read records to end of file)
+     12   uint32   Number of records in earlier files (file size limit)
+     16   uint32   File size limit (bytes)
+
+    Record (oldest first)
+      0   uint32   Start time (us, modulo 2^32)
+      4   uint32   Round-trip time (us)
+      8   uint8    Type (see CaptureType_t)
+      9   uint8    Result (see USBDM_ErrorCode)
+     10   uint8    Size of command    (txSize)
+     11   uint8    Size of response   (rxSize)
+     12   uint8[]  Command  (data[0] is not meaningful, data[1] is the command byte)
+     ..   uint8[]  Response (data[0] is the response code)
+    \endverbatim
+*/
+#ifndef _LOW_LEVEL_CAPTURE_H_
+#define _LOW_LEVEL_CAPTURE_H_
+
+#include "Common.h"
+#include "USBDM_API.h"
+
+//! Type of captured transfer
+typedef enum {
+   CAPTURE_TRANSACTION = 0,   //!< bdm_usb_transaction()
+   CAPTURE_EP0         = 1,   //!< bdm_usb_recv_ep0() e.g. CMD_USBDM_GET_VER
+} CaptureType_t;
+
+USBDM_ErrorCode bdm_capture_open(const char *fileName, unsigned fileLimitKB);
+USBDM_ErrorCode bdm_capture_close(void);
+bool            bdm_capture_isActive(void);
+uint32_t        bdm_capture_getTime(void);
+void            bdm_capture_record(CaptureType_t        type,
+                                   uint32_t             startTime,
+                                   const unsigned char *txData,
+                                   unsigned int         txSize,
+                                   const unsigned char *rxData,
+                                   unsigned int         rxSize,
+                                   USBDM_ErrorCode      rc);
+void            bdm_capture_getTiming(USBDM_CaptureTiming_t *timing);
+
+USBDM_ErrorCode bdm_replay_open(const char *fileName, bool reproduceTiming);
+USBDM_ErrorCode bdm_replay_close(void);
+USBDM_ErrorCode bdm_replay_recv_ep0(unsigned char *data, unsigned *actualRxSize);
+USBDM_ErrorCode bdm_replay_transaction(unsigned int   txSize,
+                                       unsigned int   rxSize,
+                                       unsigned char *data,
+                                       unsigned int  *actualRxSize);
+
+#endif // _LOW_LEVEL_CAPTURE_H_
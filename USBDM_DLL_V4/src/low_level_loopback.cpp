@@ -0,0 +1,1468 @@
+/*! \file
+    \brief Loopback (simulated) BDM used in place of the USB interface.
+
+    \verbatim
+    USBDM - USB communication DLL
+    Copyright (C) 2026  agent
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    Change History
+   +=========================================================================
+   |  19 Oct 2026 | Flash driver emulation, ARM AP access opcodes
+   |  19 Oct 2026 | Created
+   +==========================================================================
+    \endverbatim
+*/
+#include <stdio.h>
+#include <string.h>
+#include <stddef.h>
+#include <map>
+#include <vector>
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#include <errno.h>
+#endif
+#include "Log.h"
+#include "Version.h"
+#include "Common.h"
+#include "USBDM_API.h"
+#include "USBDM_API_Private.h"
+#include "low_level_loopback.h"
+#include "Names.h"
+#include "ARM_Definitions.h"
+#include "ARM_FlashDriver.h"
+#include "JTAGSequence.h"
+
+//=============================================================================
+// Transport
+
+static unsigned             latency    = 0;     //!< Latency added to each transaction (us)
+static bool                 deviceOpen = false; //!< Loopback BDM has been opened
+static LoopbackStatistics_t statistics;
+
+//! Hardware version reported (USBDM-CF-SER-JMxx)
+#define LOOPBACK_HARDWARE_VERSION (0x40|18)
+
+//! Capabilities reported
+#define LOOPBACK_CAPABILITIES (BDM_CAP_HCS12|BDM_CAP_RS08|BDM_CAP_VDDCONTROL|BDM_CAP_VDDSENSE| \
+                               BDM_CAP_CFVx|BDM_CAP_HCS08|BDM_CAP_CFV1|BDM_CAP_JTAG|BDM_CAP_DSC| \
+                               BDM_CAP_ARM_JTAG|BDM_CAP_RST|BDM_CAP_ARM_SWD)
+
+//=============================================================================
+// Simulated BDM & target
+
+static TargetType_t targetType    = T_OFF;
+static uint16_t     targetVdd     = BDM_TARGET_VDD_OFF;
+static uint16_t     bdmSpeed      = 0;
+static bool         connected     = false;
+static bool         halted        = true;
+static bool         resetDetected = false;
+
+//! Target registers accessed by CMD_USBDM_READ/WRITE_REG, _CREG & _DREG
+static std::map<unsigned, uint32_t> registers[3];
+
+static uint32_t getBE32(const unsigned char *data) {
+   return (data[0]<<24)|(data[1]<<16)|(data[2]<<8)|data[3];
+}
+
+static void putBE32(unsigned char *data, uint32_t value) {
+   data[0] = (uint8_t)(value>>24);
+   data[1] = (uint8_t)(value>>16);
+   data[2] = (uint8_t)(value>>8);
+   data[3] = (uint8_t)value;
+}
+
+//=============================================================================
+// Target memory
+//
+// Memory is RAM everywhere except the Flash region.  Flash may only be changed
+// through the flash controller.
+//
+#define MEMORY_PAGE_SIZE (0x400)
+
+//! Memory pages for each memory space (MS_None/MS_Program, MS_Data)
+static std::map<uint32_t, std::vector<uint8_t> > memory[2];
+
+static uint32_t flashStart      = 0x00000000;
+static uint32_t flashSize       = 0x00040000;
+static uint32_t flashSectorSize = 0x00000800;
+static uint32_t flashController = 0x40020000;
+
+//! Converts memorySpace to index into memory[]
+static int memorySpaceIndex(uint8_t memorySpace) {
+   return ((memorySpace&MS_SPACE) == MS_Data)?1:0;
+}
+
+static bool isFlash(int space, uint32_t address) {
+   return (space == 0) && ((address-flashStart) < flashSize);
+}
+
+//! Returns reference to a byte of target memory
+//!
+static uint8_t &memoryByte(int space, uint32_t address) {
+   uint32_t pageAddress = address&~(MEMORY_PAGE_SIZE-1);
+   std::vector<uint8_t> &page = memory[space][pageAddress];
+   if (page.empty()) {
+      // New page - Flash is erased, RAM is cleared
+      page.resize(MEMORY_PAGE_SIZE);
+      for (unsigned offset=0; offset<MEMORY_PAGE_SIZE; offset++) {
+         page[offset] = isFlash(space, pageAddress+offset)?0xFF:0x00;
+      }
+   }
+   return page[address&(MEMORY_PAGE_SIZE-1)];
+}
+
+//=============================================================================
+// Flash controller (Kinetis FTFL subset)
+//
+#define FTFL_FSTAT_OFFSET  (0x00)
+#define FTFL_FSEC_OFFSET   (0x02)
+#define FTFL_FOPT_OFFSET   (0x03)
+#define FTFL_FCCOB_OFFSET  (0x04)
+#define FTFL_SIZE          (0x10)
+
+#define FTFL_FSTAT_CCIF    (0x80)
+#define FTFL_FSTAT_ACCERR  (0x20)
+#define FTFL_FSTAT_FPVIOL  (0x10)
+#define FTFL_FSTAT_MGSTAT0 (0x01)
+
+#define F_RD1BLK           (0x00)  // Verify block erased
+#define F_RD1SEC           (0x01)  // Verify section erased
+#define F_RDRSRC           (0x03)  // Read resource
+#define F_PGM4             (0x06)  // Program longword
+#define F_PGM8             (0x07)  // Program phrase
+#define F_ERSSCR           (0x09)  // Erase sector
+#define F_RD1ALL           (0x40)  // Verify all blocks erased
+#define F_ERSALL           (0x44)  // Erase all blocks
+
+static uint8_t flashRegisters[FTFL_SIZE];
+
+//! Access FCCOBn register (FCCOB0-3 are a big-endian longword at FTFL_FCCOB_OFFSET etc.)
+static uint8_t &fccob(int n) {
+   return flashRegisters[FTFL_FCCOB_OFFSET+(n&~3)+3-(n&3)];
+}
+
+static bool isFlashController(int space, uint32_t address) {
+   return (space == 0) && ((address-flashController) < FTFL_SIZE);
+}
+
+//! Checks if range is entirely within Flash
+static bool isFlashRange(uint32_t address, uint32_t size) {
+   return (address >= flashStart) && (size <= flashSize) && ((address-flashStart) <= (flashSize-size));
+}
+
+//! @return FTFL_FSTAT_MGSTAT0 if range is not erased
+static uint8_t flashBlankCheck(uint32_t address, uint32_t size) {
+   for (uint32_t offset=0; offset<size; offset++) {
+      if (memoryByte(0, address+offset) != 0xFF) {
+         print("flashBlankCheck() - Not blank @0x%08X\n", address+offset);
+         return FTFL_FSTAT_MGSTAT0;
+      }
+   }
+   return 0;
+}
+
+static void flashErase(uint32_t address, uint32_t size) {
+   for (uint32_t offset=0; offset<size; offset++) {
+      memoryByte(0, address+offset) = 0xFF;
+   }
+}
+
+//! Executes the command in FCCOB
+//!
+//! @return FSTAT error flags
+//!
+static uint8_t executeFlashCommand(void) {
+   uint8_t  command = fccob(0);
+   uint32_t address = (fccob(1)<<16)|(fccob(2)<<8)|fccob(3);
+   uint32_t size;
+
+   statistics.flashCommands++;
+   switch (command) {
+   case F_RD1BLK:
+   case F_RD1ALL:
+      return flashBlankCheck(flashStart, flashSize);
+   case F_RD1SEC:
+      size = 4*((fccob(4)<<8)|fccob(5));
+      if (((address&3) != 0) || (size == 0) || !isFlashRange(address, size)) {
+         return FTFL_FSTAT_ACCERR;
+      }
+      return flashBlankCheck(address, size);
+   case F_RDRSRC:
+      // Unpartitioned/unprogrammed
+      for (int index=4; index<8; index++) {
+         fccob(index) = 0xFF;
+      }
+      return 0;
+   case F_PGM4:
+   case F_PGM8:
+      size = (command == F_PGM4)?4:8;
+      if (((address&(size-1)) != 0) || !isFlashRange(address, size)) {
+         return FTFL_FSTAT_ACCERR;
+      }
+      // Byte 0 is in FCCOB7, byte 3 in FCCOB4, byte 4 in FCCOBB, byte 7 in FCCOB8
+      // Programming can only clear bits
+      for (uint32_t offset=0; offset<size; offset++) {
+         memoryByte(0, address+offset) &= fccob((offset<4)?(7-offset):(15-offset));
+      }
+      return 0;
+   case F_ERSSCR:
+      if (((address&(flashSectorSize-1)) != 0) || !isFlashRange(address, flashSectorSize)) {
+         return FTFL_FSTAT_ACCERR;
+      }
+      flashErase(address, flashSectorSize);
+      return 0;
+   case F_ERSALL:
+      flashErase(flashStart, flashSize);
+      return 0;
+   default:
+      print("executeFlashCommand() - Unsupported command 0x%02X\n", command);
+      return FTFL_FSTAT_ACCERR;
+   }
+}
+
+static void writeFlashController(uint32_t offset, uint8_t value) {
+   if (offset == FTFL_FSTAT_OFFSET) {
+      // Write 1 to clear error flags
+      flashRegisters[FTFL_FSTAT_OFFSET] &= ~(value&(FTFL_FSTAT_ACCERR|FTFL_FSTAT_FPVIOL));
+      if (((value&FTFL_FSTAT_CCIF) != 0) &&
+          ((flashRegisters[FTFL_FSTAT_OFFSET]&(FTFL_FSTAT_ACCERR|FTFL_FSTAT_FPVIOL)) == 0)) {
+         // Launch command - completes immediately
+         flashRegisters[FTFL_FSTAT_OFFSET] = FTFL_FSTAT_CCIF|executeFlashCommand();
+      }
+   }
+   else if (offset >= FTFL_FCCOB_OFFSET) {
+      flashRegisters[offset] = value;
+   }
+}
+
+static void resetFlashController(void) {
+   memset(flashRegisters, 0, sizeof(flashRegisters));
+   flashRegisters[FTFL_FSTAT_OFFSET] = FTFL_FSTAT_CCIF;
+   flashRegisters[FTFL_FSEC_OFFSET]  = 0xFE; // Unsecured
+   flashRegisters[FTFL_FOPT_OFFSET]  = 0xFF;
+}
+
+static uint8_t readTargetByte(int space, uint32_t address) {
+   if (isFlashController(space, address)) {
+      return flashRegisters[address-flashController];
+   }
+   return memoryByte(space, address);
+}
+
+static void writeTargetByte(int space, uint32_t address, uint8_t value) {
+   if (isFlashController(space, address)) {
+      writeFlashController(address-flashController, value);
+   }
+   else if (!isFlash(space, address)) {
+      memoryByte(space, address) = value;
+   }
+}
+
+//=============================================================================
+// Flash driver
+//
+// The target CPU is not modelled.  Instead, when an ARM target is started with the
+// PC at the entry point of a flash driver loaded by the flash programmer the
+// operations requested by its LargeTargetFlashDataHeader are done using the flash
+// controller above.  The header is then updated and the target halts as it would
+// for the real driver.
+//
+#define ARM_REG_PC                 (15)
+#define FLASH_DRIVER_SEARCH_RANGE  (0x1000) // How far before the entry point to search for the image header
+
+static bool isArmTarget(void) {
+   return (targetType == T_ARM_JTAG) || (targetType == T_ARM_SWD);
+}
+
+//! Read little-endian value from target memory
+static uint32_t readTarget32(uint32_t address) {
+   return readTargetByte(0, address)|(readTargetByte(0, address+1)<<8)|
+          (readTargetByte(0, address+2)<<16)|(readTargetByte(0, address+3)<<24);
+}
+
+//! Read little-endian value from target memory
+static uint16_t readTarget16(uint32_t address) {
+   return readTargetByte(0, address)|(readTargetByte(0, address+1)<<8);
+}
+
+//! Write little-endian value to target memory
+static void writeTarget16(uint32_t address, uint16_t value) {
+   writeTargetByte(0, address,   (uint8_t)value);
+   writeTargetByte(0, address+1, (uint8_t)(value>>8));
+}
+
+//! Write little-endian value to target memory
+static void writeTarget32(uint32_t address, uint32_t value) {
+   for (int index=0; index<4; index++) {
+      writeTargetByte(0, address+index, (uint8_t)(value>>(8*index)));
+   }
+}
+
+//! Executes a command through the flash controller registers as the flash driver does
+//!
+//! @param command - FCCOB0
+//! @param address - FCCOB1-3
+//! @param data    - FCCOB4-7 (FCCOB4 is the MSB)
+//!
+//! @return FSTAT error flags
+//!
+static uint8_t flashDriverCommand(uint8_t command, uint32_t address, uint32_t data) {
+   fccob(0) = command;
+   fccob(1) = (uint8_t)(address>>16);
+   fccob(2) = (uint8_t)(address>>8);
+   fccob(3) = (uint8_t)address;
+   fccob(4) = (uint8_t)(data>>24);
+   fccob(5) = (uint8_t)(data>>16);
+   fccob(6) = (uint8_t)(data>>8);
+   fccob(7) = (uint8_t)data;
+   writeFlashController(FTFL_FSTAT_OFFSET, FTFL_FSTAT_ACCERR|FTFL_FSTAT_FPVIOL);
+   writeFlashController(FTFL_FSTAT_OFFSET, FTFL_FSTAT_CCIF);
+   return flashRegisters[FTFL_FSTAT_OFFSET]&(FTFL_FSTAT_ACCERR|FTFL_FSTAT_FPVIOL|FTFL_FSTAT_MGSTAT0);
+}
+
+//! Converts FSTAT error flags to a flash driver error code
+//!
+//! @param fstat        - FSTAT error flags
+//! @param mgstat0Error - error code to use for FTFL_FSTAT_MGSTAT0
+//!
+static uint16_t flashDriverError(uint8_t fstat, uint16_t mgstat0Error) {
+   if ((fstat&FTFL_FSTAT_ACCERR) != 0) {
+      return FLASH_ERR_PROG_ACCERR;
+   }
+   if ((fstat&FTFL_FSTAT_FPVIOL) != 0) {
+      return FLASH_ERR_PROG_FPVIOL;
+   }
+   if ((fstat&FTFL_FSTAT_MGSTAT0) != 0) {
+      return mgstat0Error;
+   }
+   return FLASH_ERR_OK;
+}
+
+//! Locates the flash driver image containing the PC
+//!
+//! @param pc        - entry point
+//! @param flashData - address of LargeTargetFlashDataHeader
+//!
+//! @return true if found
+//!
+//! @note The driver may have been relocated so the image header is recognised by its
+//!       entry point being at the same offset from the image as from the load address
+//!
+static bool findFlashDriver(uint32_t pc, uint32_t *flashData) {
+   pc &= ~1;
+   for (uint32_t offset=sizeof(LargeTargetImageHeader); offset<=FLASH_DRIVER_SEARCH_RANGE; offset+=4) {
+      uint32_t imageAddress = (pc&~3)-offset;
+      uint32_t loadAddress  = readTarget32(imageAddress+offsetof(LargeTargetImageHeader, loadAddress));
+      uint32_t entry        = readTarget32(imageAddress+offsetof(LargeTargetImageHeader, entry))&~1;
+      if ((entry != 0) && ((entry-loadAddress) == (pc-imageAddress))) {
+         *flashData = readTarget32(imageAddress+offsetof(LargeTargetImageHeader, flashData));
+         return (*flashData != 0);
+      }
+   }
+   return false;
+}
+
+//! Carries out the operations requested by a LargeTargetFlashDataHeader
+//!
+//! @param flashData - address of header
+//!
+//! @note The flags are cleared as each operation completes and IS_COMPLETE is set if all succeed.
+//!       Operations other than those below are rejected with FLASH_ERR_ILLEGAL_PARAMS.
+//!
+static void executeFlashDriver(uint32_t flashData) {
+   uint32_t flags       = readTarget32(flashData+offsetof(LargeTargetFlashDataHeader, flags));
+   uint32_t controller  = readTarget32(flashData+offsetof(LargeTargetFlashDataHeader, controller));
+   uint32_t sectorSize  = readTarget16(flashData+offsetof(LargeTargetFlashDataHeader, sectorSize));
+   uint32_t address     = readTarget32(flashData+offsetof(LargeTargetFlashDataHeader, address));
+   uint32_t dataSize    = readTarget32(flashData+offsetof(LargeTargetFlashDataHeader, dataSize));
+   uint32_t dataAddress = readTarget32(flashData+offsetof(LargeTargetFlashDataHeader, dataAddress));
+   uint16_t errorCode   = FLASH_ERR_OK;
+
+   print("executeFlashDriver() - flags=0x%08X, address=0x%08X, dataSize=0x%X\n", flags, address, dataSize);
+   if ((flags&DO_INIT_FLASH) != 0) {
+      if (controller != flashController) {
+         errorCode = FLASH_ERR_ILLEGAL_PARAMS;
+      }
+      else {
+         flags &= ~DO_INIT_FLASH;
+      }
+   }
+   if ((errorCode == FLASH_ERR_OK) && ((flags&DO_ERASE_BLOCK) != 0)) {
+      errorCode = flashDriverError(flashDriverCommand(F_ERSALL, 0, 0), FLASH_ERR_ERASE_FAILED);
+      if (errorCode == FLASH_ERR_OK) {
+         flags &= ~DO_ERASE_BLOCK;
+      }
+   }
+   if ((errorCode == FLASH_ERR_OK) && ((flags&DO_ERASE_RANGE) != 0)) {
+      if (sectorSize == 0) {
+         errorCode = FLASH_ERR_ILLEGAL_PARAMS;
+      }
+      for (uint32_t offset=0; (errorCode == FLASH_ERR_OK) && (offset<dataSize); offset+=sectorSize) {
+         errorCode = flashDriverError(flashDriverCommand(F_ERSSCR, address+offset, 0), FLASH_ERR_ERASE_FAILED);
+      }
+      if (errorCode == FLASH_ERR_OK) {
+         flags &= ~DO_ERASE_RANGE;
+      }
+   }
+   if ((errorCode == FLASH_ERR_OK) && ((flags&DO_BLANK_CHECK_RANGE) != 0)) {
+      if (sectorSize == 0) {
+         errorCode = FLASH_ERR_ILLEGAL_PARAMS;
+      }
+      for (uint32_t offset=0; (errorCode == FLASH_ERR_OK) && (offset<dataSize); offset+=sectorSize) {
+         uint32_t size = dataSize-offset;
+         if (size > sectorSize) {
+            size = sectorSize;
+         }
+         errorCode = flashDriverError(flashDriverCommand(F_RD1SEC, address+offset, ((size+3)/4)<<16), FLASH_ERR_ERASE_FAILED);
+      }
+      if (errorCode == FLASH_ERR_OK) {
+         flags &= ~DO_BLANK_CHECK_RANGE;
+      }
+   }
+   if ((errorCode == FLASH_ERR_OK) && ((flags&DO_PROGRAM_RANGE) != 0)) {
+      if (((address&3) != 0) || ((dataSize&3) != 0)) {
+         errorCode = FLASH_ERR_ILLEGAL_PARAMS;
+      }
+      for (uint32_t offset=0; (errorCode == FLASH_ERR_OK) && (offset<dataSize); offset+=4) {
+         errorCode = flashDriverError(flashDriverCommand(F_PGM4, address+offset, readTarget32(dataAddress+offset)), FLASH_ERR_PROG_MGSTAT0);
+      }
+      if (errorCode == FLASH_ERR_OK) {
+         flags &= ~DO_PROGRAM_RANGE;
+      }
+   }
+   if ((errorCode == FLASH_ERR_OK) && ((flags&DO_VERIFY_RANGE) != 0)) {
+      for (uint32_t offset=0; (errorCode == FLASH_ERR_OK) && (offset<dataSize); offset++) {
+         if (readTargetByte(0, address+offset) != readTargetByte(0, dataAddress+offset)) {
+            print("executeFlashDriver() - Verify failed @0x%08X\n", address+offset);
+            errorCode = FLASH_ERR_VERIFY_FAILED;
+         }
+      }
+      if (errorCode == FLASH_ERR_OK) {
+         flags &= ~DO_VERIFY_RANGE;
+      }
+   }
+   if ((errorCode == FLASH_ERR_OK) && ((flags&~IS_COMPLETE) != 0)) {
+      print("executeFlashDriver() - Unsupported operation(s) 0x%08X\n", flags);
+      errorCode = FLASH_ERR_ILLEGAL_PARAMS;
+   }
+   if (errorCode == FLASH_ERR_OK) {
+      flags = IS_COMPLETE;
+   }
+   print("executeFlashDriver() - complete, flags=0x%08X, errorCode=%d\n", flags, errorCode);
+   writeTarget32(flashData+offsetof(LargeTargetFlashDataHeader, flags), flags);
+   writeTarget16(flashData+offsetof(LargeTargetFlashDataHeader, errorCode), errorCode);
+}
+
+//! Start target execution
+//!
+//! An ARM target started at the entry point of a flash driver runs the driver and halts.
+//!
+static void targetGo(void) {
+   uint32_t flashData;
+
+   halted = false;
+   if (isArmTarget() && findFlashDriver(registers[0][ARM_REG_PC], &flashData)) {
+      executeFlashDriver(flashData);
+      halted = true;
+   }
+}
+
+//=============================================================================
+// ARM Debug Access Port
+//
+// AP#0 is a MEM-AP accessing target memory & AP#1 is the Kinetis MDM-AP.
+// The core debug registers are modelled so that the core registers and run state
+// may be accessed through the MEM-AP.
+//
+static uint32_t dpCtrlStat;
+static uint32_t dpSelect;
+static uint32_t dpReadResult; //!< Result of last DPACC/APACC read (returned by the following scan)
+static uint32_t apCsw;
+static uint32_t apTar;
+static uint32_t mdmApControl;
+static uint32_t dcrdr;
+static uint32_t demcr;
+
+static bool isDebugRegister(int space, uint32_t address) {
+   return isArmTarget() && (space == 0) && ((address-DHCSR) < 16);
+}
+
+static uint32_t readDebugRegister(uint32_t address) {
+   switch (address&~3) {
+   case DHCSR:
+      return halted?(DHCSR_S_HALT|DHCSR_S_REGRDY|DHCSR_C_HALT|DHCSR_C_DEBUGEN):(DHCSR_S_REGRDY|DHCSR_C_DEBUGEN);
+   case DCDR:
+      return dcrdr;
+   case DEMCR:
+      return demcr;
+   }
+   return 0;
+}
+
+static void writeDebugRegister(uint32_t address, uint32_t value) {
+   switch (address&~3) {
+   case DHCSR:
+      if ((value&0xFFFF0000UL) != (uint32_t)DHCSR_DBGKEY) {
+         break;
+      }
+      if ((value&DHCSR_C_HALT) != 0) {
+         halted = true;
+      }
+      else if (halted && ((value&DHCSR_C_STEP) == 0)) {
+         targetGo();
+      }
+      break;
+   case DCSR:
+      if ((value&DCSR_WRITE) != 0) {
+         registers[0][value&DCSR_REGMASK] = dcrdr;
+      }
+      else {
+         dcrdr = registers[0][value&DCSR_REGMASK];
+      }
+      break;
+   case DCDR:
+      dcrdr = value;
+      break;
+   case DEMCR:
+      demcr = value;
+      break;
+   }
+}
+
+//! MEM-AP access through DRW
+//!
+//! @param readNotWrite - true => read
+//! @param value        - value to write/value read (byte lanes as for a little-endian bus)
+//!
+static void memApTransfer(bool readNotWrite, uint32_t *value) {
+   unsigned size = 1<<(apCsw&AHB_AP_CSW_SIZE_MASK);
+   if (size > 4) {
+      size = 4;
+   }
+   if (readNotWrite) {
+      *value = 0;
+   }
+   if (isDebugRegister(0, apTar) && (size == 4)) {
+      if (readNotWrite) {
+         *value = readDebugRegister(apTar);
+      }
+      else {
+         writeDebugRegister(apTar, *value);
+      }
+   }
+   else {
+      for (unsigned index=0; index<size; index++) {
+         unsigned lane = ((apTar&3)+index)&3;
+         if (readNotWrite) {
+            *value |= readTargetByte(0, apTar+index)<<(8*lane);
+         }
+         else {
+            writeTargetByte(0, apTar+index, (uint8_t)(*value>>(8*lane)));
+         }
+      }
+   }
+   if ((apCsw&AHB_AP_CSW_INC_MASK) == AHB_AP_CSW_INC_SINGLE) {
+      apTar += size;
+   }
+}
+
+//! Access AP register
+//!
+//! @param apAddress    - A[31:24]=AP#, A[7:4]=Bank#, A[3:2]=Reg#
+//! @param readNotWrite - true => read
+//! @param value        - value to write/value read
+//!
+static void apAccess(uint32_t apAddress, bool readNotWrite, uint32_t *value) {
+   switch (apAddress) {
+   case AHB_AP_DRW:
+      memApTransfer(readNotWrite, value);
+      return;
+   case AHB_AP_CSW:
+      if (!readNotWrite) {
+         apCsw = *value;
+      }
+      *value = apCsw;
+      return;
+   case AHB_AP_TAR:
+      if (!readNotWrite) {
+         apTar = *value;
+      }
+      *value = apTar;
+      return;
+   case MDM_AP_Control:
+      if (!readNotWrite) {
+         mdmApControl = *value;
+      }
+      *value = mdmApControl;
+      return;
+   }
+   if (!readNotWrite) {
+      return;
+   }
+   switch (apAddress) {
+   case AHB_AP_Id:     *value = 0x24770011UL; break;
+   case AHB_AP_Base:   *value = 0xE00FF003UL; break;
+   case MDM_AP_Id:     *value = 0x001C0000UL; break;
+   case MDM_AP_Status: *value = MDM_AP_Flash_Ready|(halted?MDM_AP_Status_Core_Halted:0); break;
+   case AHB_AP_CFG:    // Little-endian
+   default:            *value = 0; break;
+   }
+}
+
+static void resetAccessPort(void) {
+   // Debug & system are powered up
+   dpCtrlStat   = CSYSPWRUPREQ|CSYSPWRUPACK|CDBGPWRUPREQ|CDBGPWRUPACK;
+   dpSelect     = 0;
+   dpReadResult = 0;
+   apCsw        = 0;
+   apTar        = 0;
+   mdmApControl = 0;
+   dcrdr        = 0;
+   demcr        = 0;
+}
+
+//=============================================================================
+// JTAG
+//
+// A single ARM JTAG-DP TAP with a 4-bit IR.  DPACC & APACC scans access the DP
+// registers and the APs above.  Other instructions except IDCODE & BYPASS select
+// a 32-bit scratch data register.
+//
+#define TAP_IR_BYPASS  (0xF)
+#define TAP_IR_CAPTURE (0x1)
+
+#define DP_STICKY_MASK (STICKYERR|STICKYCMP|STICKYORUN)
+
+enum TapState {
+   tapIdle,
+   tapShiftDR,
+   tapShiftIR
+};
+
+static TapState tapState;
+static uint8_t  tapInstruction;
+static uint32_t tapScratch;
+static uint64_t shiftRegister;
+static unsigned shiftLength;
+
+static void tapReset(void) {
+   tapState       = tapIdle;
+   tapInstruction = JTAG_ARM_IDCODE_COMMAND;
+}
+
+//! DPACC/APACC update
+//!
+//! @note As for the JTAG-DP, read results are returned by the following access
+//!
+static void tapAccessPort(uint64_t value) {
+   bool     readNotWrite = (value&DP_READ) != 0;
+   uint32_t regSelect    = (uint32_t)value&DP_RDBUFF_REG;
+   uint32_t data         = (uint32_t)(value>>3);
+
+   if (tapInstruction == JTAG_DP_APACC_SEL_COMMAND) {
+      apAccess((dpSelect&(APSEL_MASK|APBANKSEL_MASK))|(regSelect<<1), readNotWrite, &data);
+   }
+   else {
+      switch (regSelect) {
+      case DP_CTRL_STAT_REG:
+         if (readNotWrite) {
+            data = dpCtrlStat;
+            break;
+         }
+         // Sticky flags are cleared by writing 1, power-up requests are acknowledged immediately
+         dpCtrlStat = (dpCtrlStat&DP_STICKY_MASK&~data)|(data&~(DP_STICKY_MASK|CSYSPWRUPACK|CDBGPWRUPACK));
+         if ((dpCtrlStat&CSYSPWRUPREQ) != 0) {
+            dpCtrlStat |= CSYSPWRUPACK;
+         }
+         if ((dpCtrlStat&CDBGPWRUPREQ) != 0) {
+            dpCtrlStat |= CDBGPWRUPACK;
+         }
+         break;
+      case DP_SELECT_REG:
+         if (!readNotWrite) {
+            dpSelect = data;
+         }
+         data = dpSelect;
+         break;
+      case DP_RDBUFF_REG:
+         // Returns result of previous read
+         return;
+      default:
+         data = 0;
+         break;
+      }
+   }
+   if (readNotWrite) {
+      dpReadResult = data;
+   }
+}
+
+//! Update-IR/DR
+static void tapUpdate(void) {
+   if (tapState == tapShiftIR) {
+      tapInstruction = shiftRegister&((1<<ARM_JTAG_MASTER_IR_LENGTH)-1);
+   }
+   else if (tapState == tapShiftDR) {
+      switch (tapInstruction) {
+      case JTAG_ARM_IDCODE_COMMAND:
+      case TAP_IR_BYPASS:
+      case JTAG_DP_ABORT_SEL_COMMAND:
+         break;
+      case JTAG_DP_DPACC_SEL_COMMAND:
+      case JTAG_DP_APACC_SEL_COMMAND:
+         tapAccessPort(shiftRegister);
+         break;
+      default:
+         tapScratch = (uint32_t)shiftRegister;
+         break;
+      }
+   }
+}
+
+//! Move to SHIFT-DR/IR (via UPDATE if already shifting)
+static void tapGotoShift(bool instruction) {
+   tapUpdate();
+   if (instruction) {
+      tapState      = tapShiftIR;
+      shiftRegister = TAP_IR_CAPTURE;
+      shiftLength   = ARM_JTAG_MASTER_IR_LENGTH;
+   }
+   else {
+      tapState = tapShiftDR;
+      switch (tapInstruction) {
+      case JTAG_ARM_IDCODE_COMMAND:
+         shiftRegister = ARM_Cortex_M4_IDCODE;
+         shiftLength   = 32;
+         break;
+      case TAP_IR_BYPASS:
+         shiftRegister = 0;
+         shiftLength   = 1;
+         break;
+      case JTAG_DP_ABORT_SEL_COMMAND:
+      case JTAG_DP_DPACC_SEL_COMMAND:
+      case JTAG_DP_APACC_SEL_COMMAND:
+         shiftRegister = ((uint64_t)dpReadResult<<3)|ACK_OK_FAULT;
+         shiftLength   = JTAG_DP_DPACC_SEL_LENGTH;
+         break;
+      default:
+         shiftRegister = tapScratch;
+         shiftLength   = 32;
+         break;
+      }
+   }
+}
+
+//! Shift bits through the TAP
+//!
+//! @param numBits - number of bits to shift
+//! @param exit    - exit action after shift (JTAG_STAY_SHIFT etc.)
+//! @param out     - data to shift out (NULL => use fill)
+//! @param fill    - JTAG_WRITE_0/JTAG_WRITE_1
+//! @param in      - buffer for data shifted in (may be NULL)
+//!
+//! @note Buffers are big-endian and right-justified i.e. the first bit is the LSB of the last byte
+//!
+static USBDM_ErrorCode tapShift(unsigned numBits, uint8_t exit, const uint8_t *out, uint8_t fill, uint8_t *in) {
+   unsigned numBytes = BITS_TO_BYTES(numBits);
+
+   if (tapState == tapIdle) {
+      print("tapShift() - TAP not in SHIFT-DR/IR\n");
+      return BDM_RC_ILLEGAL_COMMAND;
+   }
+   if (in != NULL) {
+      memset(in, 0, numBytes);
+   }
+   for (unsigned bit=0; bit<numBits; bit++) {
+      unsigned index = numBytes-1-(bit/8);
+      uint8_t  mask  = 1<<(bit%8);
+      uint32_t tdi;
+      if (out != NULL) {
+         tdi = (out[index]&mask)?1:0;
+      }
+      else {
+         tdi = (fill == JTAG_WRITE_1)?1:0;
+      }
+      if ((in != NULL) && ((shiftRegister&1) != 0)) {
+         in[index] |= mask;
+      }
+      shiftRegister = (shiftRegister>>1)|((uint64_t)tdi<<(shiftLength-1));
+   }
+   switch (exit&JTAG_EXIT_ACTION_MASK) {
+   case JTAG_STAY_SHIFT:
+      break;
+   case JTAG_EXIT_IDLE:
+      tapUpdate();
+      tapState = tapIdle;
+      break;
+   case JTAG_EXIT_SHIFT_DR:
+      tapGotoShift(false);
+      break;
+   case JTAG_EXIT_SHIFT_IR:
+      tapGotoShift(true);
+      break;
+   }
+   return BDM_RC_OK;
+}
+
+//=============================================================================
+// JTAG sequences (subset of the opcodes in JTAGSequence.h)
+//
+//! Size of sequence opcode including in-line data
+//!
+//! @return 0 => opcode not supported
+//!
+static unsigned sequenceOpcodeSize(uint8_t opcode) {
+   unsigned numBits = opcode&JTAG_NUM_BITS_MASK;
+   if (numBits == 0) {
+      numBits = 32;
+   }
+   switch (opcode&JTAG_COMMAND_MASK) {
+   case JTAG_SHIFT_IN_Q(0):
+      return 1;
+   case JTAG_SHIFT_OUT_Q(0):
+   case JTAG_SHIFT_IN_OUT_Q(0):
+      return 1+BITS_TO_BYTES(numBits);
+   }
+   switch (opcode) {
+   case JTAG_END:
+   case JTAG_NOP:
+   case JTAG_TEST_LOGIC_RESET:
+   case JTAG_MOVE_DR_SCAN:
+   case JTAG_MOVE_IR_SCAN:
+   case JTAG_SET_STAY_SHIFT:
+   case JTAG_SET_EXIT_SHIFT_DR:
+   case JTAG_SET_EXIT_SHIFT_IR:
+   case JTAG_SET_EXIT_IDLE:
+   case JTAG_SET_IN_FILL_0:
+   case JTAG_SET_IN_FILL_1:
+      return 1;
+   case JTAG_SHIFT_OUT_DP:
+   case JTAG_SHIFT_IN_DP:
+   case JTAG_SHIFT_IN_OUT_DP:
+      return 2;
+   case JTAG_ARM_READAP:
+   case JTAG_ARM_WRITEAP:
+      return 4;
+   case JTAG_ARM_WRITEAP_I:
+      return 7;
+   case JTAG_SET_PADDING:
+      return 9;
+   }
+   return 0;
+}
+
+//! Executes a JTAG sequence
+//!
+//! Data-out for the _DP opcodes and JTAG_ARM_WRITEAP follows the first JTAG_END.
+//! Opcodes other than the basic TAP movement, shift and ARM AP access opcodes are rejected.
+//!
+static USBDM_ErrorCode executeSequence(uint8_t        length,
+                                       const uint8_t *sequence,
+                                       uint8_t        inLength,
+                                       uint8_t       *dataIn) {
+   const uint8_t *sequenceEnd = sequence+length;
+   const uint8_t *dataOut     = sequence;
+   uint8_t       *dataInEnd   = dataIn+inLength;
+   uint8_t        exitAction  = JTAG_EXIT_IDLE;
+   uint8_t        inFill      = JTAG_WRITE_1;
+   USBDM_ErrorCode rc         = BDM_RC_OK;
+
+   // Locate data-out
+   for(;;) {
+      if (dataOut >= sequenceEnd) {
+         return BDM_RC_JTAG_ILLEGAL_SEQUENCE;
+      }
+      unsigned size = sequenceOpcodeSize(*dataOut);
+      if (size == 0) {
+         print("executeSequence() - Unsupported opcode %d\n", *dataOut);
+         return BDM_RC_JTAG_ILLEGAL_SEQUENCE;
+      }
+      if (*dataOut == JTAG_END) {
+         dataOut++;
+         break;
+      }
+      dataOut += size;
+   }
+   while (rc == BDM_RC_OK) {
+      uint8_t  opcode   = *sequence;
+      unsigned numBits  = opcode&JTAG_NUM_BITS_MASK;
+      unsigned numBytes;
+      if (numBits == 0) {
+         numBits = 32;
+      }
+      if ((opcode&JTAG_COMMAND_MASK) > JTAG_MISC2) {
+         // Quick shifts - count in opcode, data in-line
+         numBytes = BITS_TO_BYTES(numBits);
+         sequence++;
+         switch (opcode&JTAG_COMMAND_MASK) {
+         case JTAG_SHIFT_IN_Q(0):
+            if (dataIn+numBytes > dataInEnd) {
+               return BDM_RC_JTAG_ILLEGAL_SEQUENCE;
+            }
+            rc = tapShift(numBits, exitAction, NULL, inFill, dataIn);
+            dataIn += numBytes;
+            break;
+         case JTAG_SHIFT_OUT_Q(0):
+            rc = tapShift(numBits, exitAction, sequence, inFill, NULL);
+            sequence += numBytes;
+            break;
+         case JTAG_SHIFT_IN_OUT_Q(0):
+            if (dataIn+numBytes > dataInEnd) {
+               return BDM_RC_JTAG_ILLEGAL_SEQUENCE;
+            }
+            rc = tapShift(numBits, exitAction, sequence, inFill, dataIn);
+            sequence += numBytes;
+            dataIn   += numBytes;
+            break;
+         default:
+            return BDM_RC_JTAG_ILLEGAL_SEQUENCE;
+         }
+         continue;
+      }
+      sequence++;
+      switch (opcode) {
+      case JTAG_END:
+         return BDM_RC_OK;
+      case JTAG_NOP:
+         break;
+      case JTAG_TEST_LOGIC_RESET:
+         tapReset();
+         break;
+      case JTAG_MOVE_DR_SCAN:
+         tapGotoShift(false);
+         break;
+      case JTAG_MOVE_IR_SCAN:
+         tapGotoShift(true);
+         break;
+      case JTAG_SET_STAY_SHIFT:
+         exitAction = JTAG_STAY_SHIFT;
+         break;
+      case JTAG_SET_EXIT_SHIFT_DR:
+         exitAction = JTAG_EXIT_SHIFT_DR;
+         break;
+      case JTAG_SET_EXIT_SHIFT_IR:
+         exitAction = JTAG_EXIT_SHIFT_IR;
+         break;
+      case JTAG_SET_EXIT_IDLE:
+         exitAction = JTAG_EXIT_IDLE;
+         break;
+      case JTAG_SET_IN_FILL_0:
+         inFill = JTAG_WRITE_0;
+         break;
+      case JTAG_SET_IN_FILL_1:
+         inFill = JTAG_WRITE_1;
+         break;
+      case JTAG_SHIFT_OUT_DP:
+      case JTAG_SHIFT_IN_DP:
+      case JTAG_SHIFT_IN_OUT_DP:
+         numBits  = *sequence++;
+         numBytes = BITS_TO_BYTES(numBits);
+         if (numBits == 0) {
+            return BDM_RC_JTAG_ILLEGAL_SEQUENCE;
+         }
+         if ((opcode != JTAG_SHIFT_IN_DP) && (dataOut+numBytes > sequenceEnd)) {
+            return BDM_RC_JTAG_ILLEGAL_SEQUENCE;
+         }
+         if ((opcode != JTAG_SHIFT_OUT_DP) && (dataIn+numBytes > dataInEnd)) {
+            return BDM_RC_JTAG_ILLEGAL_SEQUENCE;
+         }
+         rc = tapShift(numBits, exitAction,
+                       (opcode != JTAG_SHIFT_IN_DP)?dataOut:NULL,
+                       inFill,
+                       (opcode != JTAG_SHIFT_OUT_DP)?dataIn:NULL);
+         if (opcode != JTAG_SHIFT_IN_DP) {
+            dataOut += numBytes;
+         }
+         if (opcode != JTAG_SHIFT_OUT_DP) {
+            dataIn += numBytes;
+         }
+         break;
+      case JTAG_ARM_READAP:
+      case JTAG_ARM_WRITEAP: {
+         // #N,#ADDR16 - A[15:8]=AP#, A[7:4]=Bank#, A[3:2]=Reg#
+         unsigned count     = sequence[0];
+         uint32_t apAddress = ((uint32_t)sequence[1]<<24)|sequence[2];
+         uint32_t value;
+         sequence += 3;
+         if (count == 0) {
+            return BDM_RC_JTAG_ILLEGAL_SEQUENCE;
+         }
+         if (opcode == JTAG_ARM_READAP) {
+            if (dataIn+4*count+4 > dataInEnd) {
+               return BDM_RC_JTAG_ILLEGAL_SEQUENCE;
+            }
+            while (count-- > 0) {
+               apAccess(apAddress, true, &value);
+               putBE32(dataIn, value);
+               dataIn += 4;
+            }
+         }
+         else {
+            if ((dataOut+4*count > sequenceEnd) || (dataIn+4 > dataInEnd)) {
+               return BDM_RC_JTAG_ILLEGAL_SEQUENCE;
+            }
+            while (count-- > 0) {
+               value = getBE32(dataOut);
+               apAccess(apAddress, false, &value);
+               dataOut += 4;
+            }
+         }
+         // Followed by DP CTRL/STAT
+         putBE32(dataIn, dpCtrlStat);
+         dataIn += 4;
+         break;
+         }
+      case JTAG_ARM_WRITEAP_I: {
+         // #ADDR16,#DATA32
+         uint32_t apAddress = ((uint32_t)sequence[0]<<24)|sequence[1];
+         uint32_t value     = getBE32(sequence+2);
+         apAccess(apAddress, false, &value);
+         sequence += 6;
+         break;
+         }
+      case JTAG_SET_PADDING:
+         // Only a single TAP is modelled
+         sequence += 8;
+         break;
+      default:
+         return BDM_RC_JTAG_ILLEGAL_SEQUENCE;
+      }
+   }
+   return rc;
+}
+
+//=============================================================================
+// Commands
+
+//! Value of target status register (CMD_USBDM_READ_STATUS_REG)
+//!
+static uint32_t statusRegister(void) {
+   switch (targetType) {
+   case T_ARM_JTAG:
+   case T_ARM_SWD:
+      // DHCSR - S_HALT, C_HALT, C_DEBUGEN
+      return halted?((1<<17)|(1<<1)|(1<<0)):(1<<0);
+   default:
+      // BDCSCR - ENBDM, BDMACT
+      return halted?0xC0:0x80;
+   }
+}
+
+//! Executes a command
+//!
+//! @param txSize       - size of command
+//! @param data         - command (data[1] = command), response (data[1..N])
+//! @param responseSize - size of response (including status byte)
+//!
+//! @return error code
+//!
+static USBDM_ErrorCode executeCommand(unsigned txSize, unsigned char *data, unsigned *responseSize) {
+   uint8_t  command = data[1]&0x7F;
+   uint8_t  memorySpace;
+   uint8_t  count;
+   uint32_t address;
+   unsigned regNo;
+   unsigned regSet;
+
+   // Commands not requiring a target
+   switch (command) {
+   case CMD_USBDM_GET_COMMAND_RESPONSE:
+   case CMD_USBDM_SET_OPTIONS:
+   case CMD_USBDM_SET_VPP:
+      *responseSize = 1;
+      return BDM_RC_OK;
+   case CMD_USBDM_DEBUG:
+      memset(data+1, 0, *responseSize-1);
+      return BDM_RC_OK;
+   case CMD_USBDM_GET_CAPABILITIES:
+      // BDM_CAP_HCS08 & BDM_CAP_CFV1 are inverted for backwards compatibility
+      data[1] = (uint8_t)((LOOPBACK_CAPABILITIES^(BDM_CAP_HCS08|BDM_CAP_CFV1))>>8);
+      data[2] = (uint8_t)(LOOPBACK_CAPABILITIES^(BDM_CAP_HCS08|BDM_CAP_CFV1));
+      data[3] = (uint8_t)(MAX_PACKET_SIZE>>8);
+      data[4] = (uint8_t)MAX_PACKET_SIZE;
+      data[5] = USBDM_VERSION_MAJOR;
+      data[6] = USBDM_VERSION_MINOR;
+      data[7] = USBDM_VERSION_MICRO;
+      *responseSize = 8;
+      return BDM_RC_OK;
+   case CMD_USBDM_SET_TARGET:
+      if ((data[2] > T_LAST) && (data[2] != T_OFF)) {
+         return BDM_RC_UNKNOWN_TARGET;
+      }
+      targetType = (TargetType_t)data[2];
+      connected  = false;
+      tapReset();
+      *responseSize = 1;
+      return BDM_RC_OK;
+   case CMD_USBDM_SET_VDD:
+      targetVdd = (data[2]<<8)|data[3];
+      *responseSize = 1;
+      return BDM_RC_OK;
+   case CMD_USBDM_GET_BDM_STATUS: {
+      unsigned status = S_RESET_STATE;
+      if (connected) {
+         status |= S_ACKN|S_SYNC_DONE;
+      }
+      if (resetDetected) {
+         status |= S_RESET_DETECT;
+      }
+      if (halted) {
+         status |= S_HALT;
+      }
+      status |= ((targetVdd == BDM_TARGET_VDD_OFF)||(targetVdd == BDM_TARGET_VDD_DISABLE))?S_POWER_EXT:S_POWER_INT;
+      resetDetected = false;
+      data[1] = (uint8_t)(status>>8);
+      data[2] = (uint8_t)status;
+      *responseSize = 3;
+      return BDM_RC_OK;
+      }
+   case CMD_USBDM_CONTROL_PINS:
+      data[1] = 0;
+      data[2] = 0;
+      *responseSize = 3;
+      return BDM_RC_OK;
+   }
+   if (targetType == T_OFF) {
+      return BDM_RC_ILLEGAL_COMMAND;
+   }
+   // Target commands
+   *responseSize = 1;
+   switch (command) {
+   case CMD_USBDM_CONNECT:
+      connected = true;
+      return BDM_RC_OK;
+   case CMD_USBDM_SET_SPEED:
+      bdmSpeed  = (data[2]<<8)|data[3];
+      connected = true;
+      return BDM_RC_OK;
+   case CMD_USBDM_GET_SPEED:
+      data[1] = (uint8_t)(bdmSpeed>>8);
+      data[2] = (uint8_t)bdmSpeed;
+      *responseSize = 3;
+      return BDM_RC_OK;
+   case CMD_USBDM_READ_STATUS_REG:
+      putBE32(data+1, statusRegister());
+      *responseSize = 5;
+      return BDM_RC_OK;
+   case CMD_USBDM_WRITE_CONTROL_REG:
+      return BDM_RC_OK;
+   case CMD_USBDM_TARGET_RESET:
+      halted        = ((data[2]&RESET_MODE_MASK) == RESET_SPECIAL);
+      resetDetected = true;
+      resetFlashController();
+      return BDM_RC_OK;
+   case CMD_USBDM_TARGET_STEP:
+   case CMD_USBDM_TARGET_HALT:
+      halted = true;
+      return BDM_RC_OK;
+   case CMD_USBDM_TARGET_GO:
+      targetGo();
+      return BDM_RC_OK;
+   case CMD_USBDM_WRITE_REG:
+   case CMD_USBDM_WRITE_CREG:
+   case CMD_USBDM_WRITE_DREG:
+   case CMD_USBDM_READ_REG:
+   case CMD_USBDM_READ_CREG:
+   case CMD_USBDM_READ_DREG:
+      regNo  = (data[2]<<8)|data[3];
+      regSet = ((command-CMD_USBDM_WRITE_REG)>>1);
+      if (!halted && (command != CMD_USBDM_WRITE_DREG) && (command != CMD_USBDM_READ_DREG)) {
+         return BDM_RC_TARGET_BUSY;
+      }
+      if (((command-CMD_USBDM_WRITE_REG)&1) == 0) {
+         registers[regSet][regNo] = getBE32(data+4);
+      }
+      else {
+         putBE32(data+1, registers[regSet][regNo]);
+         *responseSize = 5;
+      }
+      return BDM_RC_OK;
+   case CMD_USBDM_WRITE_MEM:
+   case CMD_USBDM_READ_MEM:
+      memorySpace = data[2];
+      count       = data[3];
+      address     = getBE32(data+4);
+      if ((command == CMD_USBDM_WRITE_MEM) && (txSize < 8U+count)) {
+         return BDM_RC_ILLEGAL_PARAMS;
+      }
+      if (count > MAX_PACKET_SIZE-1) {
+         return BDM_RC_ILLEGAL_PARAMS;
+      }
+      for (unsigned index=0; index<count; index++) {
+         int space = memorySpaceIndex(memorySpace);
+         if (isDebugRegister(space, address+index) && (((address+index)&3) == 0) && (index+4 <= count)) {
+            // Debug registers are accessed as little-endian words
+            if (command == CMD_USBDM_WRITE_MEM) {
+               writeDebugRegister(address+index, data[8+index]|(data[9+index]<<8)|(data[10+index]<<16)|(data[11+index]<<24));
+            }
+            else {
+               uint32_t value = readDebugRegister(address+index);
+               data[1+index] = (uint8_t)value;
+               data[2+index] = (uint8_t)(value>>8);
+               data[3+index] = (uint8_t)(value>>16);
+               data[4+index] = (uint8_t)(value>>24);
+            }
+            index += 3;
+         }
+         else if (command == CMD_USBDM_WRITE_MEM) {
+            writeTargetByte(space, address+index, data[8+index]);
+         }
+         else {
+            data[1+index] = readTargetByte(space, address+index);
+         }
+      }
+      if (command == CMD_USBDM_READ_MEM) {
+         *responseSize = 1+count;
+      }
+      return BDM_RC_OK;
+   case CMD_USBDM_JTAG_GOTORESET:
+      tapReset();
+      return BDM_RC_OK;
+   case CMD_USBDM_JTAG_GOTOSHIFT:
+      tapGotoShift(data[2] == JTAG_SHIFT_IR);
+      return BDM_RC_OK;
+   case CMD_USBDM_JTAG_WRITE: {
+      uint8_t exit    = data[2];
+      uint8_t numBits = data[3];
+      return tapShift(numBits, exit, data+4, JTAG_WRITE_1, NULL);
+      }
+   case CMD_USBDM_JTAG_READ:
+   case CMD_USBDM_JTAG_READ_WRITE: {
+      uint8_t exit    = data[2];
+      uint8_t numBits = data[3];
+      uint8_t buffer[MAX_PACKET_SIZE];
+      USBDM_ErrorCode rc = tapShift(numBits, exit,
+                                    (command == CMD_USBDM_JTAG_READ_WRITE)?data+4:NULL,
+                                    exit&JTAG_WRITE_1, buffer);
+      memcpy(data+1, buffer, BITS_TO_BYTES(numBits));
+      *responseSize = 1+BITS_TO_BYTES(numBits);
+      return rc;
+      }
+   case CMD_USBDM_JTAG_EXECUTE_SEQUENCE: {
+      uint8_t inLength = data[2];
+      uint8_t length   = data[3];
+      uint8_t sequence[MAX_PACKET_SIZE];
+      if (txSize < 4U+length) {
+         return BDM_RC_ILLEGAL_PARAMS;
+      }
+      memcpy(sequence, data+4, length);
+      memset(data+1, 0, inLength);
+      *responseSize = 1+inLength;
+      return executeSequence(length, sequence, inLength, data+1);
+      }
+   }
+   print("executeCommand() - Unsupported command %s\n", getCommandName(command));
+   return BDM_RC_ILLEGAL_COMMAND;
+}
+
+//! Adds the configured latency to a transaction
+//!
+static void transactionDelay(void) {
+   statistics.transactions++;
+   if (latency == 0) {
+      return;
+   }
+   statistics.latencyTotal += latency;
+#ifdef __unix__
+   struct timespec sleepStruct = { latency/1000000, 1000L*(latency%1000000) };
+   while ((nanosleep(&sleepStruct, &sleepStruct) < 0) && (errno == EINTR)) {
+   }
+#else
+   Sleep((latency+999)/1000);
+#endif
+}
+
+//=============================================================================
+// Configuration
+
+//! Set latency added to each transaction
+//!
+//! @param transactionLatency - latency in microseconds
+//!
+void bdm_loopback_setLatency(unsigned transactionLatency) {
+   latency = transactionLatency;
+}
+
+//! Set location of the simulated Flash & flash controller
+//!
+//! @param start      - start address of Flash
+//! @param size       - size of Flash in bytes
+//! @param sectorSize - size of erase sector (power of 2)
+//! @param controller - address of flash controller registers
+//!
+//! @note Flash contents are not changed - use before bdm_loopback_init()
+//!
+void bdm_loopback_setFlash(uint32_t start, uint32_t size, uint32_t sectorSize, uint32_t controller) {
+   flashStart      = start;
+   flashSize       = size;
+   flashSectorSize = sectorSize;
+   flashController = controller;
+}
+
+//! Obtain statistics for the loopback BDM
+//!
+//! @param stats - updated with statistics since bdm_loopback_init()
+//!
+void bdm_loopback_getStatistics(LoopbackStatistics_t *stats) {
+   *stats = statistics;
+}
+
+//=============================================================================
+// Equivalents of the bdm_usb_xxx() functions
+
+//! Initialise loopback BDM
+//!
+//! The simulated target is reset to erased Flash & cleared RAM
+//!
+//! @return BDM_RC_OK
+//!
+USBDM_ErrorCode bdm_loopback_init(void) {
+   print("bdm_loopback_init() - latency = %d us\n", latency);
+   deviceOpen    = false;
+   targetType    = T_OFF;
+   targetVdd     = BDM_TARGET_VDD_OFF;
+   bdmSpeed      = 0;
+   connected     = false;
+   halted        = true;
+   resetDetected = false;
+   for (int index=0; index<3; index++) {
+      registers[index].clear();
+   }
+   memory[0].clear();
+   memory[1].clear();
+   tapReset();
+   tapScratch = 0;
+   resetFlashController();
+   resetAccessPort();
+   memset(&statistics, 0, sizeof(statistics));
+   return BDM_RC_OK;
+}
+
+USBDM_ErrorCode bdm_loopback_exit(void) {
+   deviceOpen = false;
+   return BDM_RC_OK;
+}
+
+//! Find loopback BDM - there is always exactly one
+//!
+USBDM_ErrorCode bdm_loopback_findDevices(unsigned *numDevices) {
+   *numDevices = 1;
+   return BDM_RC_OK;
+}
+
+//! Obtain string descriptor of loopback BDM
+//!
+//! @param index            - 2 => description, 3 => serial number
+//! @param descriptorBuffer - buffer for UTF-16-LE descriptor (preceded by length and type bytes)
+//! @param maxLength        - size of buffer
+//!
+USBDM_ErrorCode bdm_loopback_getStringDescriptor(int index, char *descriptorBuffer, unsigned maxLength) {
+   const int DT_STRING = 3;
+   const char *string;
+
+   memset(descriptorBuffer, '\0', maxLength);
+   if (!deviceOpen) {
+      return BDM_RC_DEVICE_NOT_OPEN;
+   }
+   switch (index) {
+   case 2:  string = "USBDM Loopback BDM"; break;
+   case 3:  string = "LOOPBACK-0001";      break;
+   default: return BDM_RC_USB_ERROR;
+   }
+   unsigned length = 0;
+   while ((string[length] != '\0') && (2*length+4 <= maxLength)) {
+      descriptorBuffer[2+2*length] = string[length];
+      length++;
+   }
+   descriptorBuffer[0] = 2+2*length;
+   descriptorBuffer[1] = DT_STRING;
+   return BDM_RC_OK;
+}
+
+USBDM_ErrorCode bdm_loopback_open(unsigned int device_no) {
+   if (device_no != 0) {
+      return BDM_RC_ILLEGAL_PARAMS;
+   }
+   deviceOpen = true;
+   return BDM_RC_OK;
+}
+
+USBDM_ErrorCode bdm_loopback_close(void) {
+   deviceOpen = false;
+   return BDM_RC_OK;
+}
+
+//! Equivalent of bdm_usb_recv_ep0() - only CMD_USBDM_GET_VER is supported
+//!
+USBDM_ErrorCode bdm_loopback_recv_ep0(unsigned char *data, unsigned *actualRxSize) {
+   *actualRxSize = 0;
+   if (!deviceOpen) {
+      data[0] = BDM_RC_DEVICE_NOT_OPEN;
+      return BDM_RC_DEVICE_NOT_OPEN;
+   }
+   transactionDelay();
+   if (data[1] != CMD_USBDM_GET_VER) {
+      data[0] = BDM_RC_ILLEGAL_COMMAND;
+      return BDM_RC_ILLEGAL_COMMAND;
+   }
+   data[0] = BDM_RC_OK;
+   data[1] = USBDM_VERSION;             // BDM S/W version
+   data[2] = LOOPBACK_HARDWARE_VERSION; // BDM H/W version
+   data[3] = 0x10;                      // ICP S/W version
+   data[4] = LOOPBACK_HARDWARE_VERSION; // ICP H/W version
+   *actualRxSize = 5;
+   return BDM_RC_OK;
+}
+
+//! Equivalent of bdm_usb_transaction()
+//!
+//! @param txSize       = size of command
+//! @param rxSize       = maximum size of response
+//! @param data         = command (data[1..N]), response (data[0] = status, data[1..N])
+//! @param actualRxSize = size of response
+//!
+//! @return error code from simulated BDM
+//!
+USBDM_ErrorCode bdm_loopback_transaction(unsigned int   txSize,
+                                         unsigned int   rxSize,
+                                         unsigned char *data,
+                                         unsigned int  *actualRxSize) {
+   *actualRxSize = 0;
+   if (!deviceOpen) {
+      return BDM_RC_DEVICE_NOT_OPEN;
+   }
+   transactionDelay();
+   statistics.bytesOut += txSize;
+
+   unsigned responseSize = rxSize;
+   USBDM_ErrorCode rc = executeCommand(txSize, data, &responseSize);
+   if (rc != BDM_RC_OK) {
+      data[0] = rc;
+      memset(&data[1], 0x00, rxSize-1);
+      return rc;
+   }
+   if (responseSize > rxSize) {
+      // Truncated as for a USB IN transfer
+      responseSize = rxSize;
+   }
+   data[0]       = BDM_RC_OK;
+   *actualRxSize = responseSize;
+   statistics.bytesIn += responseSize;
+   return BDM_RC_OK;
+}
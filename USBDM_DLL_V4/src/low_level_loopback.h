@@ -0,0 +1,50 @@
+/*! \file
+    \brief Loopback (simulated) BDM used in place of the USB interface.
+
+    The loopback BDM is selected by setting the environment variable USBDM_LOOPBACK
+    before USBDM_Init() is called.  The value is the latency added to each
+    transaction in microseconds e.g. USBDM_LOOPBACK=250
+
+    The USBDM command set is emulated against a simulated target:
+     - Target memory is RAM except for a single Flash region
+     - Flash is changed through a memory-mapped Kinetis FTFL-style controller
+     - JTAG targets consist of a single ARM JTAG-DP TAP (IR=4 bits, IDCODE=1110, BYPASS=1111).
+       DPACC/APACC scans access the DP CTRL/STAT, SELECT & RDBUFF registers and the APs below.
+     - JTAG_ARM_READAP/WRITEAP sequences access a MEM-AP (AP#0) and the Kinetis MDM-AP (AP#1).
+       The core debug registers (DHCSR, DCRSR, DCRDR, DEMCR) are modelled.
+     - The target CPU is not modelled.  An ARM target started at the entry point of a
+       flash driver carries out the operations in its LargeTargetFlashDataHeader using
+       the flash controller and halts.  Otherwise GO/HALT/STEP only change the run state.
+*/
+#ifndef _LOW_LEVEL_LOOPBACK_H_
+#define _LOW_LEVEL_LOOPBACK_H_
+
+#include "Common.h"
+#include "USBDM_API.h"
+
+//! Statistics for the loopback BDM
+typedef struct {
+   unsigned long transactions;   //!< Number of transactions (USB round-trips)
+   unsigned long bytesOut;       //!< Bytes sent to the BDM
+   unsigned long bytesIn;        //!< Bytes returned by the BDM
+   unsigned long latencyTotal;   //!< Total latency added to transactions (us)
+   unsigned long flashCommands;  //!< Number of flash controller commands executed
+} LoopbackStatistics_t;
+
+void            bdm_loopback_setLatency(unsigned latency);
+void            bdm_loopback_setFlash(uint32_t start, uint32_t size, uint32_t sectorSize, uint32_t controller);
+void            bdm_loopback_getStatistics(LoopbackStatistics_t *stats);
+
+USBDM_ErrorCode bdm_loopback_init(void);
+USBDM_ErrorCode bdm_loopback_exit(void);
+USBDM_ErrorCode bdm_loopback_findDevices(unsigned *numDevices);
+USBDM_ErrorCode bdm_loopback_getStringDescriptor(int index, char *descriptorBuffer, unsigned maxLength);
+USBDM_ErrorCode bdm_loopback_open(unsigned int device_no);
+USBDM_ErrorCode bdm_loopback_close(void);
+USBDM_ErrorCode bdm_loopback_recv_ep0(unsigned char *data, unsigned *actualRxSize);
+USBDM_ErrorCode bdm_loopback_transaction(unsigned int   txSize,
+                                         unsigned int   rxSize,
+                                         unsigned char *data,
+                                         unsigned int  *actualRxSize);
+
+#endif // _LOW_LEVEL_LOOPBACK_H_
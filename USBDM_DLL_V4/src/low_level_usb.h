@@ -8,6 +8,8 @@ USBDM_ErrorCode bdm_usb_findDevices(unsigned *numDevices);
 USBDM_ErrorCode bdm_usb_getStringDescriptor(int index, char *deviceDescription, unsigned maxLength);
 USBDM_ErrorCode bdm_usb_releaseDevices(void);
 USBDM_ErrorCode bdm_usb_getDeviceCount(unsigned int *deviceCount);
+USBDM_ErrorCode bdm_usb_getStatistics(USBDM_Statistics_t *stats);
+USBDM_ErrorCode bdm_usb_resetStatistics(void);
 USBDM_ErrorCode bdm_usb_open(unsigned int device_no);
 USBDM_ErrorCode bdm_usb_close(void);
 USBDM_ErrorCode bdm_usb_send_ep0(const unsigned char * data);
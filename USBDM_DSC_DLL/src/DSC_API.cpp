@@ -44,6 +44,7 @@
 #include "USBDM_DSC_API.h"
 #include "USBDM_DSC_API_Private.h"
 #include "JTAGSequence.h"
+#include "JTAGSequenceBuilder.h"
 
 struct EonceRegisterDetails_t {
    uint8_t      address;
@@ -1157,29 +1158,36 @@ static uint8_t copyReadRegInfo(DSC_Registers_t regNo, uint8_t *&copyPtr) {
    return registerSize;
 }
 
+//! Execute target instruction to transfer register to memory-mapped EONCE reg OTX/OTX1
+//! and read OTX/OTX1
+//!
+//! @tparam Next - following sequence element
+//!
+template<class Next>
+struct ReadOTXSequence :
+   JTAGBuilder::Op<JTAG_CALL_EXECUTE,                    // Execute target instruction: move Reg -> OTX/OTX1
+   // Read EONCE reg OTX/OTX1
+   JTAGBuilder::Op<JTAG_MOVE_DR_SCAN,                    // Move to SCAN-DR (EONCE)
+   JTAGBuilder::Op<JTAG_SET_EXIT_SHIFT_DR,
+   JTAGBuilder::Op8<JTAG_SHIFT_OUT_DP, ONCE_CMD_LENGTH,  // Command for Read Register - either OTX/OTX1
+   JTAGBuilder::Op<JTAG_SET_EXIT_IDLE,
+   JTAGBuilder::Op8<JTAG_SHIFT_IN_DP, 0,                 // Data size to read
+   Next> > > > > > {};
+
 //! Read Multiple Core register via ONCE & target execution
 //!
 //! @note Assumes Core TAP is active & in RUN-TEST/IDLE
 //! @note Leaves Core TAP in RUN-TEST/IDLE, EONCE register selected
 //!
 static USBDM_ErrorCode saveVolatileTargetRegs(void) {
-   // Execute target instruction to transfer registers to memory-mapped EONCE reg OTX
-   // Read OTX/OTX1
-   static const uint8_t readCoreRegSequence[] = {
-
-         // For each register
-         JTAG_REPEAT_DP,
-            // Process a register
-   /*41*/   JTAG_CALL_EXECUTE,         // Execute target instruction: move Reg -> OTX/OTX1
-
-            // Read EONCE reg OTX/OTX1
-   /*42*/   JTAG_MOVE_DR_SCAN,         // Move to SCAN-DR (EONCE)
-   /*43*/   JTAG_SET_EXIT_SHIFT_DR,
-   /*44*/   JTAG_SHIFT_OUT_DP, ONCE_CMD_LENGTH,      // Command for Read Register - either OTX/OTX1
-   /*46*/   JTAG_SET_EXIT_IDLE,
-   /*47*/   JTAG_SHIFT_IN_DP, 0,       // Data size to read
-         JTAG_END_REPEAT,
-   /*49*/JTAG_END
+   // For each register
+   //    Execute target instruction to transfer register to memory-mapped EONCE reg OTX
+   //    Read OTX/OTX1
+   typedef JTAGBuilder::Program<
+      JTAGBuilder::RepeatDP<
+         ReadOTXSequence<
+      JTAGBuilder::EndRepeat<
+      JTAGBuilder::End> > > > ReadCoreRegsSequence;
 
 // /*50*/   5, // # of registers
 // /*50*/   2, // # of instructions for 1st reg
@@ -1189,7 +1197,6 @@ static USBDM_ErrorCode saveVolatileTargetRegs(void) {
 //          // Read result from OTX/OTX1
 // /*63*/   OTX1_ADDRESS|ONCE_CMD_READ,  16,
      // etc...
-};
 USBDM_ErrorCode rc;
 uint16_t registerSize = 0;
 uint8_t outBuffer[100];
@@ -1201,8 +1208,7 @@ uint8_t outBuffer[100];
 
    uint8_t* copyPtr = JTAGSequence;
 
-   memcpy(copyPtr, readCoreRegSequence, sizeof(readCoreRegSequence));
-   copyPtr += sizeof(readCoreRegSequence);
+   copyPtr = ReadCoreRegsSequence::copyTo(copyPtr);
 
    *copyPtr++ = 6; // The number of registers to save
 //   registerSize  = copyReadRegInfo(DSC_RegPC, copyPtr);
@@ -1243,16 +1249,9 @@ uint8_t outBuffer[100];
 USBDM_ErrorCode readCoreReg(DSC_Registers_t regNo, unsigned long *regValue) {
    // Execute target instruction to transfer register to memory-mapped EONCE reg OTX
    // Read OTX/OTX1
-   static const uint8_t readCoreRegSequence[] = {
-         // Main
-   /*41*/JTAG_CALL_EXECUTE,                  // Execute target instruction: move Reg -> OTX/OTX1
-         // Read EONCE reg OTX/OTX1
-   /*42*/JTAG_MOVE_DR_SCAN,                  // Move to SCAN-DR (EONCE)
-   /*43*/JTAG_SET_EXIT_SHIFT_DR,
-   /*44*/JTAG_SHIFT_OUT_DP, ONCE_CMD_LENGTH, // Command for Read Register - either OTX/OTX1
-   /*46*/JTAG_SET_EXIT_IDLE,
-   /*47*/JTAG_SHIFT_IN_DP, 0,                // Data size to read
-   /*49*/JTAG_END
+   typedef JTAGBuilder::Program<
+      ReadOTXSequence<
+      JTAGBuilder::End> > ReadCoreRegSequence;
 
 // /*50*/   2, // # of instructions
 //          // Length  Instruction data...
@@ -1260,7 +1259,6 @@ USBDM_ErrorCode readCoreReg(DSC_Registers_t regNo, unsigned long *regValue) {
 // /*56*/        3,    0xE7,0x7F, 0xD4,0x7C, 0xFF,0xFF,
 //          // Read result from OTX/OTX1
 // /*63*/   OTX1_ADDRESS|ONCE_CMD_READ,  16,
-};
 USBDM_ErrorCode rc;
 uint8_t registerSize;
 
@@ -1269,8 +1267,7 @@ uint8_t registerSize;
 
    uint8_t* copyPtr = JTAGSequence;
 
-   memcpy(copyPtr, readCoreRegSequence, sizeof(readCoreRegSequence));
-   copyPtr += sizeof(readCoreRegSequence);
+   copyPtr = ReadCoreRegSequence::copyTo(copyPtr);
 
    registerSize = copyReadRegInfo(regNo, copyPtr);
 
@@ -10,10 +10,8 @@
 #include <stdio.h>
 #include "JTAGSequence.h"
 #include "Log.h"
-#if defined(LOG) && defined(LOG_JTAG)
 #include "USBDM_DSC_API.h"
 #include "USBDM_DSC_API_Private.h"
-#endif
 //#include "USBDM_DSC_API.h"
 //#include "USBDM_DSC_API_Private.h"
 
@@ -111,10 +109,71 @@ const char *JTAG32::toString() {
    return buff;
 }
 
-USBDM_ErrorCode debugExecuteJTAGSequence(uint8_t       sequenceLength,
-                                         const uint8_t *sequenceStart,
-                                         uint8_t       dataInLength,
-                                         uint8_t       *dataInStart);
+static USBDM_ErrorCode interpretJTAGSequence(uint8_t       sequenceLength,
+                                             const uint8_t *sequenceStart,
+                                             uint8_t       dataInLength,
+                                             uint8_t       *dataInStart);
+
+//! Transport using the BDM JTAG operations
+class BdmJTAGTransport : public JTAGTransport {
+public:
+   USBDM_ErrorCode reset(void) {
+      return USBDM_JTAG_Reset();
+   }
+   USBDM_ErrorCode selectShift(uint8_t mode) {
+      return USBDM_JTAG_SelectShift(mode);
+   }
+   USBDM_ErrorCode write(uint8_t bitCount, uint8_t exit, const uint8_t *buffer) {
+      return USBDM_JTAG_Write(bitCount, exit, buffer);
+   }
+   USBDM_ErrorCode read(uint8_t bitCount, uint8_t exit, uint8_t *buffer) {
+      return USBDM_JTAG_Read(bitCount, exit, buffer);
+   }
+   USBDM_ErrorCode readWrite(uint8_t bitCount, uint8_t exit, const uint8_t *outBuffer, uint8_t *inBuffer) {
+      return USBDM_JTAG_ReadWrite(bitCount, exit, outBuffer, inBuffer);
+   }
+   USBDM_ErrorCode executeSequence(uint8_t sequenceLength, const uint8_t *sequence, uint8_t dataInLength, uint8_t *dataIn) {
+      return USBDM_JTAG_ExecuteSequence(sequenceLength, sequence, dataInLength, dataIn);
+   }
+};
+
+#ifdef LOG_JTAG
+static BdmJTAGTransport bdmTransport;
+//! Transport used to execute sequences on the PC (NULL => executed by BDM)
+static JTAGTransport *transport = &bdmTransport;
+#else
+//! Transport used to execute sequences on the PC (NULL => executed by BDM)
+static JTAGTransport *transport = NULL;
+#endif
+
+static JTAGSequenceStatistics statistics;
+
+//! Get statistics for the JTAG sequences executed since the last reset
+//!
+const JTAGSequenceStatistics &getJTAGSequenceStatistics(void) {
+   return statistics;
+}
+
+//! Clear JTAG sequence statistics
+//!
+void resetJTAGSequenceStatistics(void) {
+   memset(&statistics, 0, sizeof(statistics));
+}
+
+//! Execute JTAG sequence using the BDM or the current transport
+//!
+static USBDM_ErrorCode executeSequence(uint8_t       sequenceLength,
+                                       const uint8_t *sequenceStart,
+                                       uint8_t       dataInLength,
+                                       uint8_t       *dataInStart) {
+   statistics.transactions++;
+   statistics.bytesOut += sequenceLength;
+   statistics.bytesIn  += dataInLength;
+   if (transport != NULL) {
+      return interpretJTAGSequence(sequenceLength, sequenceStart, dataInLength, dataInStart);
+   }
+   return USBDM_JTAG_ExecuteSequence(sequenceLength, sequenceStart, dataInLength, dataInStart);
+}
 
 
 USBDM_ErrorCode executeJTAGSequence(uint8_t       sequenceLength,
@@ -123,19 +182,28 @@ USBDM_ErrorCode executeJTAGSequence(uint8_t       sequenceLength,
                                     uint8_t       *dataInStart,
                                     bool     log) {
    USBDM_ErrorCode rc;
+   uint8_t  optimisedSequence[256];
+   unsigned clocksSaved;
+   unsigned optimisedLength = 0;
+
+   if (getJTAGSequenceOptimisation()) {
+      optimisedLength = optimiseJTAGSequence(sequenceLength, sequenceStart, optimisedSequence, &clocksSaved);
+   }
+   if (optimisedLength > 0) {
+      statistics.optimisedBytes  += sequenceLength-optimisedLength;
+      statistics.optimisedClocks += clocksSaved;
+      sequenceLength = (uint8_t)optimisedLength;
+      sequenceStart  = optimisedSequence;
+   }
 #ifndef LOG
-   rc = USBDM_JTAG_ExecuteSequence(sequenceLength, sequenceStart, dataInLength, dataInStart);
+   rc = executeSequence(sequenceLength, sequenceStart, dataInLength, dataInStart);
 #else
    if (log) {
       print("executeJTAGSequence()=>\n");
       print("==============================================================\n");
       listJTAGSequence(sequenceLength, sequenceStart);
    }
-#ifdef LOG_JTAG
-   rc = debugExecuteJTAGSequence(sequenceLength, sequenceStart, dataInLength, dataInStart);
-#else
-   rc = USBDM_JTAG_ExecuteSequence(sequenceLength, sequenceStart, dataInLength, dataInStart);
-#endif
+   rc = executeSequence(sequenceLength, sequenceStart, dataInLength, dataInStart);
    if (log) {
       if (rc == BDM_RC_OK) {
          print("Returned data =>    ----------------------------------------\n");
@@ -150,8 +218,6 @@ USBDM_ErrorCode executeJTAGSequence(uint8_t       sequenceLength,
    return rc;
 }
 
-#if defined(LOG) && defined(LOG_JTAG)
-
 // 000 00000   move TEST-LOGIC-RESET
 // 000 00001   move RUN-TEST-IDLE
 // 000 00010   move DR-SCAN
@@ -169,7 +235,11 @@ USBDM_ErrorCode executeJTAGSequence(uint8_t       sequenceLength,
 // 011 NNNNN   shift in/out N bits of sequence
 // 1xx xxxxx   reserved
 
+#ifdef LOG
 static void printBits(uint8_t numBits, const uint8_t *data);
+#else
+static void printBits(uint8_t, const uint8_t *) {}
+#endif
 
 static uint8_t getValueByte(uint8_t value);
 
@@ -232,6 +302,8 @@ static const uint8_t *skipSequence(const uint8_t *sequence, uint8_t sentinel, in
 //               case JTAG_SHIFT_IN_VARB:
                case JTAG_SHIFT_OUT_VARA:
                case JTAG_SHIFT_OUT_VARB:
+               case JTAG_SHIFT_OUT_VARC:
+               case JTAG_SHIFT_OUT_VARD:
                case JTAG_SET_ERROR:
                case JTAG_PUSH8:
                case JTAG_REPEAT8:
@@ -323,11 +395,30 @@ static const uint8_t *skipSequence(const uint8_t *sequence, uint8_t sentinel, in
 
                case JTAG_SHIFT_IN_OUT_VARA:
                case JTAG_SHIFT_IN_OUT_VARB:
+               case JTAG_SHIFT_IN_OUT_VARC:
+               case JTAG_SHIFT_IN_OUT_VARD:
                   temp = (uint8_t)BITS_TO_BYTES(*++sequence);
                   sequence += temp; // Skip over inline data
                   break;
+            }
+            break;
+         case JTAG_MISC2:
+            switch (opcode) {
+               case JTAG_ARM_READAP:   // #N,#ADDR16
+               case JTAG_ARM_WRITEAP:
+                  sequence += 3;
+                  break;
+               case JTAG_ARM_WRITEAP_I: // #ADDR16,#DATA32
+                  sequence += 6;
+                  break;
                case JTAG_SET_PADDING:  // #HDR,#HIR,#TDR,#TIR
-                  sequence += 5; // Skip numBits
+                  sequence += 8;
+                  break;
+               case JTAG_READ_MEM:   // Operands are in data out
+               case JTAG_WRITE_MEM:
+                  break;
+               default:
+                  print("Unhandled opcode in skipSequence = %d, SP=%d\n", opcode, sequence-sequenceStart);
                   break;
             }
             break;
@@ -370,78 +461,249 @@ typedef struct {
    RepeatInformation  *repeatTOS;
 } SubroutineInformation;
 
-uint8_t                   complete          = false;
-uint8_t                   inFill            = JTAG_WRITE_1;
-JTAG_ExitActions_t   exitAction        = JTAG_EXIT_IDLE;
-USBDM_ErrorCode      rc                = BDM_RC_OK;
-uint32_t                  variables[4]      = {0,0,0,0};
-uint16_t                  iterator          = 0;
-const uint8_t             *startOfIteration = NULL;
-uint32_t                  tempValue = 0;
-uint8_t                   *dataInPtr;
-
-RepeatInformation       repeatStack[6] = {{NULL,0}};
-RepeatInformation       *repeatTOS = repeatStack;
-
-SubroutineInformation   subroutineStack[4] = {{NULL, NULL}};
-SubroutineInformation   *subroutineTOS = subroutineStack;
-uint8_t opcode;
-uint8_t numBits;
-uint8_t regNo;
-int adjustment;
-
-USBDM_ErrorCode executeTargetInstructionSequence(const uint8_t **dataOutPtr) {
-USBDM_ErrorCode rc = BDM_RC_OK;
-static const uint8_t enableONCECommand[] = {CORE_ENABLE_ONCE_COMMAND};
-static const uint8_t writeOpcode[]       = {OPDBR_ADDRESS|ONCE_CMD_WRITE};
-static const uint8_t writeOpcodeAndGo[]  = {OPDBR_ADDRESS|ONCE_CMD_WRITE|ONCE_CMD_GO};
-uint8_t onceStatus;
-uint8_t numberOfInstructions;
-uint8_t retry;
-
-//   print("executeTargetInstructionSequence()\n");
-   rc = USBDM_JTAG_SelectShift(JTAG_SHIFT_IR);
-   numberOfInstructions = *(*dataOutPtr)++;
-   print("executeTargetInstructionSequence(#=%d)\n", numberOfInstructions);
-   do {
-      uint8_t numWords = *(*dataOutPtr)++;
-      rc = USBDM_JTAG_Write(JTAG_CORE_COMMAND_LENGTH, JTAG_EXIT_SHIFT_DR, enableONCECommand);
-      print("executeTargetInstructionSequence(#%d) : ", numberOfInstructions);
-      do {
-         uint16_t opcode = ((**dataOutPtr)<<8) + (*(*dataOutPtr+1));
-         if (numWords>1) {
-            print("0x%4.4X, ", opcode);
-            rc = USBDM_JTAG_Write(ONCE_CMD_LENGTH, JTAG_EXIT_SHIFT_DR, writeOpcode);
-            rc = USBDM_JTAG_Write(16, JTAG_EXIT_SHIFT_DR, (*dataOutPtr));
-         }
-         else {
-            print("0x%4.4X\n", opcode);
-            rc = USBDM_JTAG_Write(ONCE_CMD_LENGTH, JTAG_EXIT_SHIFT_DR, writeOpcodeAndGo);
-            rc = USBDM_JTAG_Write(16, JTAG_EXIT_SHIFT_IR, (*dataOutPtr));
+static uint8_t                   complete          = false;
+static uint8_t                   inFill            = JTAG_WRITE_1;
+static JTAG_ExitActions_t   exitAction        = JTAG_EXIT_IDLE;
+static USBDM_ErrorCode      rc                = BDM_RC_OK;
+static uint32_t                  variables[4]      = {0,0,0,0};
+static uint16_t                  iterator          = 0;
+static const uint8_t             *startOfIteration = NULL;
+static uint32_t                  tempValue = 0;
+static uint8_t                   *dataInPtr;
+
+static RepeatInformation       repeatStack[6] = {{NULL,0}};
+static RepeatInformation       *repeatTOS = repeatStack;
+
+static SubroutineInformation   subroutineStack[4] = {{NULL, NULL}};
+static SubroutineInformation   *subroutineTOS = subroutineStack;
+static uint8_t opcode;
+static uint8_t numBits;
+static uint8_t regNo;
+static int adjustment;
+
+//! Routine used for JTAG_CALL_SUBA - Execute a series of DSC target instructions
+//!
+//! Data out: [L = # of instructions], L * ([M = # of words], M * 16-bit words)
+//!
+//! The instructions are written to OPDBR (GO on the last word) and the core status
+//! is polled until the target returns to debug mode.
+//!
+//! Error: BDM_RC_TARGET_BUSY    - Target still executing/stopped
+//!        BDM_RC_NO_CONNECTION  - Unexpected status
+//!
+static const uint8_t targetExecuteRoutine[] = {
+   JTAG_MOVE_IR_SCAN,
+   JTAG_REPEAT_DP,                                                                  // For each instruction
+      JTAG_SET_EXIT_SHIFT_DR,
+      JTAG_SHIFT_OUT_Q(JTAG_CORE_COMMAND_LENGTH), CORE_ENABLE_ONCE_COMMAND,
+      JTAG_PUSH_DP_8, JTAG_REPEAT,                                                  // For each word
+         JTAG_IF_ITER_NEQ_Q(1),
+            JTAG_SHIFT_OUT_Q(ONCE_CMD_LENGTH), OPDBR_ADDRESS|ONCE_CMD_WRITE,
+            JTAG_SHIFT_OUT_DP, 16,
+         JTAG_ELSE,                                                                 // Last word - execute
+            JTAG_SHIFT_OUT_Q(ONCE_CMD_LENGTH), OPDBR_ADDRESS|ONCE_CMD_WRITE|ONCE_CMD_GO,
+            JTAG_SET_EXIT_SHIFT_IR,
+            JTAG_SHIFT_OUT_DP, 16,
+         JTAG_END_IF,
+      JTAG_END_REPEAT,
+   JTAG_END_REPEAT,
+   JTAG_SET_EXIT_SHIFT_IR,
+   JTAG_SHIFT_OUT_Q(JTAG_CORE_COMMAND_LENGTH), CORE_ENABLE_ONCE_COMMAND,
+   JTAG_SHIFT_OUT_Q(JTAG_CORE_COMMAND_LENGTH), CORE_ENABLE_ONCE_COMMAND,
+   JTAG_REPEAT_8(100),                                                              // Wait for debug mode
+      JTAG_SHIFT_IN_OUT_VARA, JTAG_CORE_COMMAND_LENGTH, CORE_ENABLE_ONCE_COMMAND,
+      JTAG_IF_VARA_EQ_Q(TARGET_STATUS_DEBUG),
+         JTAG_BREAK,
+      JTAG_END_IF,
+   JTAG_END_REPEAT,
+   JTAG_SET_EXIT_IDLE,                                                              // Move to IDLE
+   JTAG_SHIFT_OUT_Q(JTAG_CORE_COMMAND_LENGTH), CORE_ENABLE_ONCE_COMMAND,
+   JTAG_IF_VARA_NEQ_Q(TARGET_STATUS_DEBUG),
+      JTAG_IF_VARA_EQ_Q(TARGET_STATUS_STOP),
+         JTAG_SET_ERROR, BDM_RC_TARGET_BUSY,
+      JTAG_END_IF,
+      JTAG_IF_VARA_EQ_Q(TARGET_STATUS_EXECUTE),
+         JTAG_SET_ERROR, BDM_RC_TARGET_BUSY,
+      JTAG_END_IF,
+      JTAG_IF_VARA_EQ_Q(TARGET_STATUS_EX_ACCESS),
+         JTAG_SET_ERROR, BDM_RC_TARGET_BUSY,
+      JTAG_END_IF,
+      JTAG_SET_ERROR, BDM_RC_NO_CONNECTION,
+   JTAG_END_IF,
+   JTAG_END_SUB,
+};
+
+//! Execute a series of target instructions as a single sequence using the transport
+//!
+//! @param dataOutPtr - Ptr to instruction data (see targetExecuteRoutine), advanced on success
+//!
+//! @return BDM_RC_ILLEGAL_COMMAND => transport can't execute sequences (or too large)
+//!                                   targetExecuteRoutine should be interpreted instead
+//!
+static USBDM_ErrorCode executeTargetInstructionSequence(const uint8_t **dataOutPtr) {
+   uint8_t        buffer[255];
+   const uint8_t *dataPtr              = *dataOutPtr;
+   unsigned       numberOfInstructions = *dataPtr++;
+   unsigned       routineLength        = sizeof(targetExecuteRoutine)-1;
+   unsigned       dataLength;
+
+   while (numberOfInstructions-- > 0) {
+      dataPtr += 1+2*(*dataPtr);
+   }
+   dataLength = dataPtr-*dataOutPtr;
+   if ((routineLength+1+dataLength) > sizeof(buffer)) {
+      return BDM_RC_ILLEGAL_COMMAND;
+   }
+   // Stand-alone copy of routine followed by the instruction data
+   memcpy(buffer, targetExecuteRoutine, routineLength);
+   buffer[routineLength++] = JTAG_END;
+   memcpy(buffer+routineLength, *dataOutPtr, dataLength);
+
+   USBDM_ErrorCode rc = transport->executeSequence((uint8_t)(routineLength+dataLength), buffer, 0, NULL);
+   if (rc != BDM_RC_ILLEGAL_COMMAND) {
+      print("executeTargetInstructionSequence(#=%d) => %s\n", **dataOutPtr, USBDM_GetErrorString(rc));
+      statistics.transactions++;
+      statistics.bytesOut += routineLength+dataLength;
+      *dataOutPtr = dataPtr;
+   }
+   return rc;
+}
+
+// ARM JTAG-DP access used by JTAG_ARM_... opcodes
+#define ARM_JTAG_IR_LENGTH    (4)
+#define ARM_JTAG_DPACC        (0x0A)
+#define ARM_JTAG_APACC        (0x0B)
+#define ARM_JTAG_DR_LENGTH    (35)
+#define ARM_DP_CTRL_STAT      (0x04)
+#define ARM_DP_SELECT         (0x08)
+#define ARM_DP_RDBUFF         (0x0C)
+#define ARM_ACK_OK_FAULT      (0x02)
+#define ARM_ACK_WAIT          (0x01)
+#define ARM_WAIT_RETRIES      (100)
+#define ARM_DP_SELECT_INVALID (0xFFFFFFFFUL)
+
+//! Current value of DP-SELECT (cleared at start of each sequence)
+static uint32_t armSelect = ARM_DP_SELECT_INVALID;
+
+//! Access a DP or AP register using DPACC/APACC
+//!
+//! @param instruction - ARM_JTAG_DPACC or ARM_JTAG_APACC
+//! @param regAddress  - Register address A[3:2]
+//! @param readNotWrite- true for read
+//! @param dataOut     - Value to write
+//! @param dataIn      - Result of previous read (may be NULL)
+//!
+//! @return error code
+//!
+static USBDM_ErrorCode armAccess(uint8_t instruction, uint8_t regAddress, bool readNotWrite, uint32_t dataOut, uint32_t *dataIn) {
+   uint8_t outBuffer[5];
+   uint8_t inBuffer[5];
+   uint64_t value = ((uint64_t)dataOut<<3)|((regAddress&0x0C)>>1)|(readNotWrite?1:0);
+   for (int index=4; index>=0; index--) {
+      outBuffer[index] = (uint8_t)value;
+      value >>= 8;
+   }
+   USBDM_ErrorCode rc = transport->selectShift(JTAG_SHIFT_IR);
+   if (rc == BDM_RC_OK) {
+      rc = transport->write(ARM_JTAG_IR_LENGTH, JTAG_EXIT_SHIFT_DR, &instruction);
+   }
+   int retry = ARM_WAIT_RETRIES;
+   while (rc == BDM_RC_OK) {
+      rc = transport->readWrite(ARM_JTAG_DR_LENGTH, JTAG_EXIT_IDLE, outBuffer, inBuffer);
+      if (rc != BDM_RC_OK) {
+         break;
+      }
+      value = 0;
+      for (int index=0; index<5; index++) {
+         value = (value<<8)|inBuffer[index];
+      }
+      uint8_t ack = (uint8_t)(value&0x07);
+      if (ack == ARM_ACK_OK_FAULT) {
+         if (dataIn != NULL) {
+            *dataIn = (uint32_t)(value>>3);
          }
-         (*dataOutPtr) += 2;
-      } while (--numWords>0);
-   } while (--numberOfInstructions>0);
-   rc = USBDM_JTAG_Write(JTAG_CORE_COMMAND_LENGTH, JTAG_EXIT_SHIFT_IR, enableONCECommand);
-   rc = USBDM_JTAG_Write(JTAG_CORE_COMMAND_LENGTH, JTAG_EXIT_SHIFT_IR, enableONCECommand);
-   retry = 100;
-   do {
-      rc = USBDM_JTAG_ReadWrite(JTAG_CORE_COMMAND_LENGTH, JTAG_EXIT_SHIFT_IR, enableONCECommand, &onceStatus);
-   }  while ((onceStatus != TARGET_STATUS_DEBUG) && (retry-->0));
-   // Move to IDLE
-   rc = USBDM_JTAG_Write(JTAG_CORE_COMMAND_LENGTH, JTAG_EXIT_IDLE, enableONCECommand);
+         break;
+      }
+      if ((ack != ARM_ACK_WAIT) || (retry-- <= 0)) {
+         print("armAccess() - Failed, ack = %d\n", ack);
+         rc = BDM_RC_ARM_ACCESS_ERROR;
+         break;
+      }
+      rc = transport->selectShift(JTAG_SHIFT_DR);
+   }
+   return rc;
+}
 
-   if (onceStatus == TARGET_STATUS_DEBUG)
+//! Select AP and bank for an AP access
+//!
+//! @param apAddress - 32-bit AP address A[31:24]=AP#, A[7:4]=Bank#, A[3:2]=Reg#
+//!
+static USBDM_ErrorCode armSelectAP(uint32_t apAddress) {
+   uint32_t select = apAddress&0xFF0000F0UL;
+   if (select == armSelect) {
       return BDM_RC_OK;
-   if (onceStatus == TARGET_STATUS_STOP)
-      return BDM_RC_TARGET_BUSY;
-   if (onceStatus == TARGET_STATUS_EXECUTE)
-      return BDM_RC_TARGET_BUSY;
-   if (onceStatus == TARGET_STATUS_EX_ACCESS)
-      return BDM_RC_TARGET_BUSY;
-   if (onceStatus == TARGET_STATUS_STOP)
-      return BDM_RC_TARGET_BUSY;
-   return BDM_RC_NO_CONNECTION;
+   }
+   armSelect = select;
+   return armAccess(ARM_JTAG_DPACC, ARM_DP_SELECT, false, select, NULL);
+}
+
+//! Read DP CTRL/STAT as 4 bytes (big-endian)
+//!
+static USBDM_ErrorCode armReadStatus(uint8_t *dataIn) {
+   uint32_t value;
+   USBDM_ErrorCode rc = armAccess(ARM_JTAG_DPACC, ARM_DP_CTRL_STAT, true, 0, NULL);
+   if (rc == BDM_RC_OK) {
+      rc = armAccess(ARM_JTAG_DPACC, ARM_DP_RDBUFF, true, 0, &value);
+   }
+   JTAG32(value, 32).copyToArray(dataIn);
+   return rc;
+}
+
+//! Read AP register(s) followed by DP CTRL/STAT (JTAG_ARM_READAP)
+//!
+//! @param apAddress - 32-bit AP address A[31:24]=AP#, A[7:4]=Bank#, A[3:2]=Reg#
+//! @param count     - Number of reads
+//! @param dataIn    - Buffer for 4*count+4 bytes (big-endian values)
+//!
+static USBDM_ErrorCode armReadAP(uint32_t apAddress, uint8_t count, uint8_t *dataIn) {
+   uint32_t value;
+   USBDM_ErrorCode rc = armSelectAP(apAddress);
+   if (rc == BDM_RC_OK) {
+      // Reads are posted - value is returned by following access
+      rc = armAccess(ARM_JTAG_APACC, (uint8_t)apAddress, true, 0, NULL);
+   }
+   while ((rc == BDM_RC_OK) && (count-- > 0)) {
+      if (count > 0) {
+         rc = armAccess(ARM_JTAG_APACC, (uint8_t)apAddress, true, 0, &value);
+      }
+      else {
+         rc = armAccess(ARM_JTAG_DPACC, ARM_DP_RDBUFF, true, 0, &value);
+      }
+      JTAG32(value, 32).copyToArray(dataIn);
+      dataIn += 4;
+   }
+   if (rc == BDM_RC_OK) {
+      rc = armReadStatus(dataIn);
+   }
+   return rc;
+}
+
+//! Write AP register(s) optionally followed by read of DP CTRL/STAT (JTAG_ARM_WRITEAP/WRITEAP_I)
+//!
+//! @param apAddress - 32-bit AP address A[31:24]=AP#, A[7:4]=Bank#, A[3:2]=Reg#
+//! @param count     - Number of writes
+//! @param dataOut   - 4*count bytes (big-endian values)
+//! @param dataIn    - Buffer for DP CTRL/STAT (NULL if not required)
+//!
+static USBDM_ErrorCode armWriteAP(uint32_t apAddress, uint8_t count, const uint8_t *dataOut, uint8_t *dataIn) {
+   USBDM_ErrorCode rc = armSelectAP(apAddress);
+   while ((rc == BDM_RC_OK) && (count-- > 0)) {
+      rc = armAccess(ARM_JTAG_APACC, (uint8_t)apAddress, false, JTAG32(dataOut, 32), NULL);
+   }
+   if ((rc == BDM_RC_OK) && (dataIn != NULL)) {
+      rc = armReadStatus(dataIn);
+   }
+   return rc;
 }
 
 //! Obtains an 8-bit data value from the instruction stream or
@@ -460,10 +722,10 @@ static uint8_t getValueByte(uint8_t value) {
 //! @param dataInLength   - expected length of input data
 //! @param dataInStart    - buffer for dataIn
 //!
-USBDM_ErrorCode debugExecuteJTAGSequence(uint8_t        sequenceLength,
-                                         const uint8_t *sequenceStart,
-                                         uint8_t        dataInLength,
-                                         uint8_t       *dataInStart) {
+static USBDM_ErrorCode interpretJTAGSequence(uint8_t        sequenceLength,
+                                             const uint8_t *sequenceStart,
+                                             uint8_t        dataInLength,
+                                             uint8_t       *dataInStart) {
 
    complete          = false;
    inFill            = JTAG_WRITE_1;
@@ -472,6 +734,9 @@ USBDM_ErrorCode debugExecuteJTAGSequence(uint8_t        sequenceLength,
    iterator          = 0;
    startOfIteration  = NULL;
    tempValue         = 0;
+   repeatTOS         = repeatStack;
+   subroutineTOS     = subroutineStack;
+   armSelect         = ARM_DP_SELECT_INVALID;
 int                  indent            = 6;
 
    dataInPtr         = dataInStart;                         // Save start of dataIn
@@ -483,8 +748,10 @@ int                  indent            = 6;
       dataOutPtr++;
    print("executeJTAGSequence()- DP=%d\n =>", dataOutPtr-sequenceStart);
 
+#if defined(LOG) && defined(LOG_JTAG)
    print("\nexecuteJTAGSequence() =>\n");
    listJTAGSequence(sequenceLength, sequenceStart);
+#endif
 
    print("executeJTAGSequence(seqLength = %d, sequence=%d, dataOutPtr=%d, dataInPtr=%d) \n",
          sequenceLength,
@@ -499,6 +766,8 @@ int                  indent            = 6;
          lineNumber = sequence-sequenceStart;
       else if ((sequence>=subroutineCache) && (sequence<(subroutineCache+sizeof(subroutineCache))))
          lineNumber = -(sequence-subroutineCache);
+      else if ((sequence>=targetExecuteRoutine) && (sequence<(targetExecuteRoutine+sizeof(targetExecuteRoutine))))
+         lineNumber = -(sequence-targetExecuteRoutine);
       else {
          print("%-*d: Illegal sequence ptr = %d\n", indent, lineNumber, sequence-sequenceStart);
          rc = BDM_RC_JTAG_ILLEGAL_SEQUENCE;
@@ -515,13 +784,88 @@ int                  indent            = 6;
       opcode      = *sequence++;
       numBits     = (opcode&JTAG_NUM_BITS_MASK);   // In case needed
       regNo       = numBits & 0x03;                // In case needed
+      statistics.opcodeCounts[opcode]++;
       if (numBits == 0)
          numBits = 32;
 
       switch (opcode&JTAG_COMMAND_MASK) {
          case JTAG_MISC0: // Misc commands
          case JTAG_MISC1: // Misc commands
+         case JTAG_MISC2: // Misc commands
             switch (opcode) {
+               case JTAG_ARM_READAP:
+                  numBits    = *sequence++;
+                  tempValue  = *sequence++<<24;
+                  tempValue += *sequence++;
+                  print("%-*d: JTAG_ARM_READAP(N=%d, A=0x%08X)\n", indent, lineNumber, numBits, tempValue);
+                  if ((numBits == 0) || (dataInPtr == NULL)) {
+                     rc = BDM_RC_JTAG_ILLEGAL_SEQUENCE;
+                  }
+                  else {
+                     rc = armReadAP(tempValue, numBits, dataInPtr);
+                     dataInPtr += 4*numBits+4;
+                  }
+                  break;
+               case JTAG_ARM_WRITEAP:
+                  numBits    = *sequence++;
+                  tempValue  = *sequence++<<24;
+                  tempValue += *sequence++;
+                  print("%-*d: JTAG_ARM_WRITEAP(N=%d, A=0x%08X)\n", indent, lineNumber, numBits, tempValue);
+                  if ((numBits == 0) || (dataInPtr == NULL) || (dataOutPtr == NULL)) {
+                     rc = BDM_RC_JTAG_ILLEGAL_SEQUENCE;
+                  }
+                  else {
+                     rc = armWriteAP(tempValue, numBits, dataOutPtr, dataInPtr);
+                     dataOutPtr += 4*numBits;
+                     dataInPtr  += 4;
+                  }
+                  break;
+               case JTAG_ARM_WRITEAP_I:
+                  tempValue   = *sequence++<<24;
+                  tempValue  += *sequence++;
+                  print("%-*d: JTAG_ARM_WRITEAP_I(A=0x%08X, V=0x%02X%02X%02X%02X)\n", indent, lineNumber,
+                        tempValue, sequence[0], sequence[1], sequence[2], sequence[3]);
+                  rc = armWriteAP(tempValue, 1, sequence, NULL);
+                  sequence   += 4;
+                  break;
+               case JTAG_SET_PADDING:  // #Set HDR, HIR, TDR, TIR
+                  // Only a single device is supported when executing on the PC
+                  print("%-*d: JTAG_SET_PADDING - ignored\n", indent, lineNumber);
+                  sequence += 8;
+                  break;
+               case JTAG_READ_MEM:   // Address, # elements & memory space are in data out
+               case JTAG_WRITE_MEM:
+                  if (dataOutPtr == NULL) {
+                     rc = BDM_RC_JTAG_ILLEGAL_SEQUENCE;
+                     break;
+                  }
+                  tempValue  = JTAG32(dataOutPtr, 32);
+                  numBits    = *dataOutPtr++;   // # of elements
+                  regNo      = *dataOutPtr++;   // Memory space
+                  print("%-*d: %s(A=0x%08X, N=%d, MS=0x%02X)\n", indent, lineNumber,
+                        (opcode==JTAG_READ_MEM)?"JTAG_READ_MEM":"JTAG_WRITE_MEM", tempValue, numBits, regNo);
+                  {
+                  // The memory routines are implemented by the BDM firmware - execute them as a sequence
+                  unsigned dataSize = numBits*(regNo&MS_SIZE);
+                  uint8_t  memorySequence[256];
+                  unsigned memorySequenceLength = 2+6+((opcode == JTAG_WRITE_MEM)?dataSize:0);
+                  if (memorySequenceLength > sizeof(memorySequence)) {
+                     rc = BDM_RC_JTAG_ILLEGAL_SEQUENCE;
+                     break;
+                  }
+                  memorySequence[0] = opcode;
+                  memorySequence[1] = JTAG_END;
+                  memcpy(memorySequence+2, dataOutPtr-6, memorySequenceLength-2);
+                  if (opcode == JTAG_READ_MEM) {
+                     rc = transport->executeSequence((uint8_t)memorySequenceLength, memorySequence, (uint8_t)dataSize, dataInPtr);
+                     dataInPtr  += dataSize;
+                  }
+                  else {
+                     rc = transport->executeSequence((uint8_t)memorySequenceLength, memorySequence, 0, NULL);
+                     dataOutPtr += dataSize;
+                  }
+                  }
+                  break;
                case JTAG_DEBUG_ON:
                   print("%-*d: JTAG_DEBUG_ON\n", indent, lineNumber);
                   enableLogging(true);
@@ -532,15 +876,15 @@ int                  indent            = 6;
                   break;
                case JTAG_TEST_LOGIC_RESET:
                   print("%-*d: JTAG_TEST_LOGIC_RESET\n", indent, lineNumber);
-                  rc = USBDM_JTAG_Reset();
+                  rc = transport->reset();
                   break;
                case JTAG_MOVE_DR_SCAN:
                   print("%-*d: JTAG_MOVE_DR_SCAN\n", indent, lineNumber);
-                  rc = USBDM_JTAG_SelectShift(JTAG_SHIFT_DR);
+                  rc = transport->selectShift(JTAG_SHIFT_DR);
                   break;
                case JTAG_MOVE_IR_SCAN:
                   print("%-*d: JTAG_MOVE_IR_SCAN\n", indent, lineNumber);
-                  rc = USBDM_JTAG_SelectShift(JTAG_SHIFT_IR);
+                  rc = transport->selectShift(JTAG_SHIFT_IR);
                   break;
                case JTAG_SET_STAY_SHIFT:
                   print("%-*d: JTAG_SET_STAY_SHIFT\n", indent, lineNumber);
@@ -594,9 +938,16 @@ int                  indent            = 6;
                   sequence = skipSequence(sequence, STOP_ON_SUB, &indent);
                   break;
                case JTAG_CALL_SUBA:
+                  // Target instruction execution - firmware implemented on the BDM
                   print("%-*d: JTAG_CALL_SUBA*\n", indent, lineNumber);
-                  executeTargetInstructionSequence(&dataOutPtr);
-                  break;
+                  rc = executeTargetInstructionSequence(&dataOutPtr);
+                  if (rc != BDM_RC_ILLEGAL_COMMAND) {
+                     break;
+                  }
+                  // Interpret routine on PC
+                  rc = BDM_RC_OK;
+                  subPtrs[regNo] = targetExecuteRoutine;
+                  // Fall through
                case JTAG_CALL_SUBB:
                case JTAG_CALL_SUBC:
                case JTAG_CALL_SUBD:
@@ -718,7 +1069,7 @@ int                  indent            = 6;
                   else {
                      print("%-*d: JTAG_SHIFT_OUT_DP_VARA (=%d) => ", indent, lineNumber, numBits);
                      printBits(numBits, dataOutPtr);
-                     rc = USBDM_JTAG_Write(numBits, exitAction, dataOutPtr);
+                     rc = transport->write(numBits, exitAction, dataOutPtr);
                      dataOutPtr += BITS_TO_BYTES(numBits);
                   }
                   break;
@@ -736,7 +1087,7 @@ int                  indent            = 6;
                   else {
                      print("%-*d: JTAG_SHIFT_OUT_DP (%d) => ", indent, lineNumber, numBits);
                      printBits(numBits, dataOutPtr);
-                     rc = USBDM_JTAG_Write(numBits, exitAction, dataOutPtr);
+                     rc = transport->write(numBits, exitAction, dataOutPtr);
                      dataOutPtr += BITS_TO_BYTES(numBits);
                   }
                   break;
@@ -751,7 +1102,7 @@ int                  indent            = 6;
                      print("%-*d: JTAG_SHIFT_IN_TL(0) - Illegal repeat count!\n", indent, lineNumber);
                   }
                   else {
-                     rc = USBDM_JTAG_Read(numBits, exitAction|inFill, dataInPtr);
+                     rc = transport->read(numBits, exitAction|inFill, dataInPtr);
                      print("%-*d: JTAG_SHIFT_IN_TL (%d) <= ", indent, lineNumber, numBits);
                      printBits(numBits, dataInPtr);
                      dataInPtr += BITS_TO_BYTES(numBits);
@@ -775,7 +1126,7 @@ int                  indent            = 6;
                   else {
                      print("%-*d: JTAG_SHIFT_IN_OUT_TL (%d) => ", indent, lineNumber, numBits);
                      printBits(numBits, dataOutPtr);
-                     rc = USBDM_JTAG_ReadWrite(numBits, exitAction, dataOutPtr, dataInPtr);
+                     rc = transport->readWrite(numBits, exitAction, dataOutPtr, dataInPtr);
                      print("%-*d:                      (%d) <= ", indent, lineNumber, numBits);
                      printBits(numBits, dataInPtr);
                      dataOutPtr     += BITS_TO_BYTES(numBits);
@@ -847,7 +1198,7 @@ int                  indent            = 6;
 //                  }
 //                  else {
 //                     JTAG32 temp(0,32);
-//                     rc = USBDM_JTAG_Read(numBits, exitAction|inFill, temp.getData(numBits));
+//                     rc = transport->read(numBits, exitAction|inFill, temp.getData(numBits));
 //                     print("%-*d: JTAG_SHIFT_IN_VAR%c (%d) varA <= %s", indent, lineNumber, 'A'+(opcode&0x3), numBits);
 //                     printBits(numBits, temp.getData(BITS_TO_BYTES(numBits)));
 //                     variables[opcode&0x3] = temp;
@@ -866,7 +1217,7 @@ int                  indent            = 6;
                      JTAG32 temp(variables[opcode&0x3],32);
                      print("%-*d: JTAG_SHIFT_OUT_VAR%c(%d) => ", indent, lineNumber, 'A'+(opcode&0x3), numBits);
                      printBits(numBits, sequence);
-                     rc = USBDM_JTAG_Write(numBits, exitAction, temp.getData(numBits));
+                     rc = transport->write(numBits, exitAction, temp.getData(numBits));
                   }
                   break;
                case JTAG_SHIFT_IN_OUT_VARA: // Set variable from TDO with TDI values from sequence
@@ -882,7 +1233,7 @@ int                  indent            = 6;
                      JTAG32 temp(0,32);
                      print("%-*d: JTAG_SHIFT_IN_OUT_VAR%c(%d) => ", indent, lineNumber, 'A'+(opcode&0x3), numBits);
                      printBits(numBits, sequence);
-                     rc = USBDM_JTAG_ReadWrite(numBits, exitAction, sequence, temp.getData(numBits));
+                     rc = transport->readWrite(numBits, exitAction, sequence, temp.getData(numBits));
                      print("%-*d:                        (%d) <= ", indent, lineNumber, numBits);
                      printBits(numBits, temp.getData(BITS_TO_BYTES(numBits)));
                      variables[opcode&0x3] = temp;
@@ -988,7 +1339,7 @@ int                  indent            = 6;
                print("%-*d: JTAG_SHIFT_IN_Q(%d) - no input buffer!\n", indent, lineNumber, numBits);
             }
             else {
-               rc = USBDM_JTAG_Read(numBits, exitAction|inFill, dataInPtr);
+               rc = transport->read(numBits, exitAction|inFill, dataInPtr);
                print("%-*d: JTAG_SHIFT_IN_Q(%d) <= ", indent, lineNumber, numBits);
                printBits(numBits, dataInPtr);
                dataInPtr   += BITS_TO_BYTES(numBits);
@@ -997,7 +1348,7 @@ int                  indent            = 6;
          case JTAG_SHIFT_OUT_Q(0) : // Shift sequence out (5-bit count) - sequence taken inline
             print("%-*d: JTAG_SHIFT_OUT_Q(%d) => ", indent, lineNumber, numBits);
             printBits(numBits, sequence);
-            rc = USBDM_JTAG_Write(numBits, exitAction, sequence);
+            rc = transport->write(numBits, exitAction, sequence);
             sequence += BITS_TO_BYTES(numBits);
             break;
          case JTAG_SHIFT_IN_OUT_Q(0) : // Shift sequence in & out at same time - sequence taken inline
@@ -1008,7 +1359,7 @@ int                  indent            = 6;
             else {
                print("%-*d: JTAG_SHIFT_IN_OUT_Q(%d) => ", indent, lineNumber, numBits);
                printBits(numBits, sequence);
-               rc = USBDM_JTAG_ReadWrite(numBits, exitAction, sequence, dataInPtr);
+               rc = transport->readWrite(numBits, exitAction, sequence, dataInPtr);
                print("%-*d:                    (%d) <= ", indent, lineNumber, numBits);
                printBits(numBits, dataInPtr);
                sequence   += BITS_TO_BYTES(numBits);
@@ -1046,8 +1397,6 @@ int                  indent            = 6;
    return rc;
 }
 
-#endif
-
 #ifdef LOG
 void printBits(uint8_t numBits, const uint8_t *data) {
 uint8_t bitCount  = 0;
@@ -0,0 +1,477 @@
+/*
+ * JTAGSequenceBuilder.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: agent
+ */
+
+#ifndef JTAGSEQUENCEBUILDER_H_
+#define JTAGSEQUENCEBUILDER_H_
+
+#include <string.h>
+#include "JTAGSequence.h"
+
+//! Compile-time construction of JTAG sequences
+//!
+//! A sequence is described as a type - a list of elements each naming the element that follows
+//! and terminated by End (JTAG_END) or NoEnd (a fragment copied in front of other sequence bytes) e.g.
+//! @code
+//!   using namespace JTAGBuilder;
+//!   struct Address;
+//!   typedef Program<
+//!      RepeatDP<
+//!         Op<JTAG_MOVE_DR_SCAN,
+//!         Op8<JTAG_SHIFT_OUT_DP, 8,
+//!      EndRepeat<
+//!      Var32<Address,
+//!      End> > > > > > ExampleProgram;
+//! @endcode
+//!
+//! The following are checked when the sequence is compiled:
+//!   - Each opcode is used with the correct number and range of operands
+//!   - REPEAT/IF/ELSE/SUB blocks are balanced and correctly nested
+//!   - Values consumed by IF/REPEAT/LOAD_VAR/SKIP_DP have been pushed
+//!   - BREAK/CONTINUE/RETURN appear within a suitable block
+//!   - Variable fields named in set<>() exist in the sequence
+//!
+//! The size of the sequence and the offsets of variable fields are compile-time constants.
+//! The sequence image is created once on first use; callers copy the image and patch
+//! only the variable fields.
+//!
+//! @note Errors mentioning an incomplete type Check<false>, EndRepeatOf<>, ElseOf<>, EndIfOf<>,
+//!       SubOf<>, EndSubOf<> or a missing VarId in Nil indicate a malformed sequence.
+//!
+namespace JTAGBuilder {
+
+//! Compile-time check - only Check<true> is complete
+template<bool condition> struct Check;
+template<>               struct Check<true> { enum {ok = 1}; };
+
+template<class A, class B> struct IsSame       { enum {value = false}; };
+template<class A>          struct IsSame<A, A> { enum {value = true}; };
+
+//=======================================================================
+// Block nesting - a type-level stack of open blocks
+//
+struct NoBlock {};
+template<class Outer> struct RepeatBlock { typedef Outer outer; };
+template<class Outer> struct IfBlock     { typedef Outer outer; };
+template<class Outer> struct ElseBlock   { typedef Outer outer; };
+template<class Outer> struct SubBlock    { typedef Outer outer; };
+
+//! END_REPEAT must close a REPEAT
+template<class Blocks> struct EndRepeatOf;
+template<class Outer>  struct EndRepeatOf<RepeatBlock<Outer> > { typedef Outer type; };
+
+//! ELSE must follow an IF (without ELSE)
+template<class Blocks> struct ElseOf;
+template<class Outer>  struct ElseOf<IfBlock<Outer> > { typedef ElseBlock<Outer> type; };
+
+//! END_IF must close an IF or ELSE
+template<class Blocks> struct EndIfOf;
+template<class Outer>  struct EndIfOf<IfBlock<Outer> >   { typedef Outer type; };
+template<class Outer>  struct EndIfOf<ElseBlock<Outer> > { typedef Outer type; };
+
+//! SUB may only be opened at the outer level
+template<class Blocks> struct SubOf;
+template<>             struct SubOf<NoBlock> { typedef SubBlock<NoBlock> type; };
+
+//! END_SUB must close a SUB
+template<class Blocks> struct EndSubOf;
+template<>             struct EndSubOf<SubBlock<NoBlock> > { typedef NoBlock type; };
+
+//! Indicates if within a REPEAT block
+template<class Blocks> struct InRepeat                      { enum {value = InRepeat<typename Blocks::outer>::value}; };
+template<>             struct InRepeat<NoBlock>             { enum {value = false}; };
+template<class Outer>  struct InRepeat<RepeatBlock<Outer> > { enum {value = true}; };
+
+//! Indicates if within a SUB block
+template<class Blocks> struct InSub                         { enum {value = InSub<typename Blocks::outer>::value}; };
+template<>             struct InSub<NoBlock>                { enum {value = false}; };
+template<class Outer>  struct InSub<SubBlock<Outer> >       { enum {value = true}; };
+
+//=======================================================================
+// Rules - effect of an element on the open blocks and pushed value
+//
+//! Element neither uses nor leaves a pushed value
+struct Plain {
+   template<class Blocks, bool pushed> struct Apply {
+      typedef Blocks blocks;
+      enum {leavesPush = false, check = 1};
+   };
+};
+//! Element pushes a value for the following element
+struct Pushes {
+   template<class Blocks, bool pushed> struct Apply {
+      typedef Blocks blocks;
+      enum {leavesPush = true, check = 1};
+   };
+};
+//! Element uses a pushed value
+struct UsesPush {
+   template<class Blocks, bool pushed> struct Apply {
+      typedef Blocks blocks;
+      enum {leavesPush = false, check = sizeof(Check<pushed>)};
+   };
+};
+//! Element opens a REPEAT (count in-line or from a pushed value)
+template<bool needsPush> struct OpensRepeat {
+   template<class Blocks, bool pushed> struct Apply {
+      typedef RepeatBlock<Blocks> blocks;
+      enum {leavesPush = false, check = sizeof(Check<pushed || !needsPush>)};
+   };
+};
+struct ClosesRepeat {
+   template<class Blocks, bool pushed> struct Apply {
+      typedef typename EndRepeatOf<Blocks>::type blocks;
+      enum {leavesPush = false, check = 1};
+   };
+};
+//! Element must be within a REPEAT
+struct WithinRepeat {
+   template<class Blocks, bool pushed> struct Apply {
+      typedef Blocks blocks;
+      enum {leavesPush = false, check = sizeof(Check<InRepeat<Blocks>::value>)};
+   };
+};
+//! Element opens an IF using a pushed value
+struct OpensIf {
+   template<class Blocks, bool pushed> struct Apply {
+      typedef IfBlock<Blocks> blocks;
+      enum {leavesPush = false, check = sizeof(Check<pushed>)};
+   };
+};
+struct StartsElse {
+   template<class Blocks, bool pushed> struct Apply {
+      typedef typename ElseOf<Blocks>::type blocks;
+      enum {leavesPush = false, check = 1};
+   };
+};
+struct ClosesIf {
+   template<class Blocks, bool pushed> struct Apply {
+      typedef typename EndIfOf<Blocks>::type blocks;
+      enum {leavesPush = false, check = 1};
+   };
+};
+struct OpensSub {
+   template<class Blocks, bool pushed> struct Apply {
+      typedef typename SubOf<Blocks>::type blocks;
+      enum {leavesPush = false, check = 1};
+   };
+};
+struct ClosesSub {
+   template<class Blocks, bool pushed> struct Apply {
+      typedef typename EndSubOf<Blocks>::type blocks;
+      enum {leavesPush = false, check = 1};
+   };
+};
+//! Element must be within a SUB
+struct WithinSub {
+   template<class Blocks, bool pushed> struct Apply {
+      typedef Blocks blocks;
+      enum {leavesPush = false, check = sizeof(Check<InSub<Blocks>::value>)};
+   };
+};
+//! Element terminates the sequence - all blocks must be closed
+struct Terminates {
+   template<class Blocks, bool pushed> struct Apply {
+      typedef Blocks blocks;
+      enum {leavesPush = false, check = sizeof(Check<IsSame<Blocks, NoBlock>::value && !pushed>)};
+   };
+};
+
+//=======================================================================
+// Opcode classification (matches the sequence interpreter)
+//
+//! Opcodes that take no operands and do not affect block structure
+template<uint8_t op> struct IsSimpleOp {
+   enum {value = (op == JTAG_NOP) ||
+                 ((op >= JTAG_TEST_LOGIC_RESET) && (op <= JTAG_SET_IN_FILL_1)) ||
+                 ((op >= JTAG_CALL_SUBA) && (op <= JTAG_CALL_SUBD)) ||
+                 (op == JTAG_SAVE_OUT_DP_VARC) || (op == JTAG_SAVE_OUT_DP_VARD) ||
+                 (op == JTAG_RESTORE_DP_VARC)  || (op == JTAG_RESTORE_DP_VARD)  ||
+                 (op == JTAG_SAVE_SUB) || (op == JTAG_SHIFT_OUT_DP_VARA) || (op == JTAG_SET_BUSY) ||
+                 (op == JTAG_DEBUG_ON) || (op == JTAG_DEBUG_OFF) };
+};
+//! Opcodes that take a single 8-bit in-line operand
+template<uint8_t op> struct IsOp8 {
+   enum {value = (op == JTAG_SET_ERROR) ||
+                 ((op >= JTAG_SHIFT_OUT_VARA) && (op <= JTAG_SHIFT_OUT_VARD)) ||
+                 ((op >= JTAG_SHIFT_OUT_DP) && (op <= JTAG_SHIFT_IN_OUT_DP)) };
+};
+//! Opcodes without operands that use a value from a preceding JTAG_PUSH...
+template<uint8_t op> struct IsPushConsumer {
+   enum {value = (op == JTAG_LOAD_VARA) || (op == JTAG_LOAD_VARB) || (op == JTAG_SKIP_DP) };
+};
+//! Opcodes that open an IF block using a value from a preceding JTAG_PUSH...
+template<uint8_t op> struct IsIfOp {
+   enum {value = ((op >= JTAG_IF_VARA_EQ) && (op <= JTAG_IF_ITER_EQ)) ||
+                 (op == JTAG_IF_VARA_NEQ) || (op == JTAG_IF_VARB_NEQ) };
+};
+
+//! Operand of a quick opcode (1-31, 32 => 0)
+template<unsigned numBits> struct QuickBits {
+   enum {check = sizeof(Check<(numBits >= 1) && (numBits <= 32)>),
+         code  = numBits&JTAG_NUM_BITS_MASK,
+         bytes = BITS_TO_BYTES(numBits) };
+};
+
+//=======================================================================
+// Element bodies - the bytes emitted
+//
+//! Marks a body without a variable field
+struct NoVar;
+
+//! Write value big-endian
+inline void putValue(uint8_t *buffer, unsigned size, uint32_t value) {
+   while (size-- > 0) {
+      buffer[size] = (uint8_t)value;
+      value >>= 8;
+   }
+}
+
+//! No bytes
+struct Empty {
+   typedef NoVar VarId;
+   enum {size = 0, varOffset = 0, varSize = 0};
+   static void emit(uint8_t *) {}
+};
+
+//! Opcode followed by N bytes of constant operand (big-endian)
+template<unsigned N, uint8_t op, uint32_t value=0>
+struct Bytes {
+   typedef NoVar VarId;
+   enum {size = 1+N, varOffset = 0, varSize = 0};
+   static void emit(uint8_t *buffer) {
+      buffer[0] = op;
+      putValue(buffer+1, N, value);
+   }
+};
+
+//! Prefix bytes followed by N byte variable field (initially zero)
+template<class Prefix, unsigned N, class Id>
+struct VarBytes {
+   typedef Id VarId;
+   enum {size = Prefix::size+N, varOffset = Prefix::size, varSize = N};
+   static void emit(uint8_t *buffer) {
+      Prefix::emit(buffer);
+      memset(buffer+Prefix::size, 0, N);
+   }
+};
+
+//! ARM AP block access - opcode, variable count, compressed AP address
+template<uint8_t op, class CountId, uint32_t apAddress>
+struct ArmAPBytes {
+   typedef CountId VarId;
+   enum {size = 4, varOffset = 1, varSize = 1};
+   static void emit(uint8_t *buffer) {
+      buffer[0] = op;
+      buffer[1] = 0;
+      buffer[2] = (uint8_t)(apAddress>>24);
+      buffer[3] = (uint8_t)apAddress;
+   }
+};
+
+//=======================================================================
+// Sequence elements
+//
+//! Terminates the element list
+struct Nil {};
+
+//! Common element structure
+//!
+//! @tparam Body - bytes emitted
+//! @tparam Next - following element
+//! @tparam Rule - effect on block structure
+//!
+template<class Body, class Next, class Rule>
+struct Element : Body {
+   typedef Next next;
+   typedef Rule rule;
+   enum {check = 1};
+};
+
+//! Opcode without operands e.g. JTAG_MOVE_DR_SCAN
+template<uint8_t op, class Next> struct Op : Element<Bytes<0, op>, Next, Plain> {
+   enum {check = sizeof(Check<IsSimpleOp<op>::value>)};
+};
+//! Opcode with 8-bit operand e.g. JTAG_SHIFT_OUT_DP, N
+template<uint8_t op, uint8_t value, class Next> struct Op8 : Element<Bytes<1, op, value>, Next, Plain> {
+   enum {check = sizeof(Check<IsOp8<op>::value>)};
+};
+//! Opcode with 8-bit operand set at run-time
+template<uint8_t op, class Id, class Next> struct Op8Var : Element<VarBytes<Bytes<0, op>, 1, Id>, Next, Plain> {
+   enum {check = sizeof(Check<IsOp8<op>::value>)};
+};
+//! Opcode using the pushed value e.g. JTAG_LOAD_VARA
+template<uint8_t op, class Next> struct OpPushed : Element<Bytes<0, op>, Next, UsesPush> {
+   enum {check = sizeof(Check<IsPushConsumer<op>::value>)};
+};
+
+//! Push a value for the following element
+template<uint8_t value, class Next> struct PushQ : Element<Bytes<0, JTAG_PUSH_Q(value)>, Next, Pushes> {
+   enum {check = sizeof(Check<(value < 32)>)};
+};
+template<uint8_t  value, class Next> struct Push8  : Element<Bytes<1, JTAG_PUSH8,  value>, Next, Pushes> {};
+template<uint16_t value, class Next> struct Push16 : Element<Bytes<2, JTAG_PUSH16, value>, Next, Pushes> {};
+template<uint32_t value, class Next> struct Push32 : Element<Bytes<4, JTAG_PUSH32, value>, Next, Pushes> {};
+template<class Id,       class Next> struct Push32Var : Element<VarBytes<Bytes<0, JTAG_PUSH32>, 4, Id>, Next, Pushes> {};
+//! Push a value taken from the data pointer - op is one of JTAG_PUSH_DP_...
+template<uint8_t op, class Next> struct PushDP : Element<Bytes<0, op>, Next, Pushes> {
+   enum {check = sizeof(Check<(op >= JTAG_PUSH_DP_8) && (op <= JTAG_PUSH_DP_32)>)};
+};
+
+//! Quick shifts - data in-line
+template<unsigned numBits, class Next> struct ShiftInQ
+   : Element<Bytes<0, JTAG_SHIFT_IN_Q(QuickBits<numBits>::code)>, Next, Plain> {
+   enum {check = QuickBits<numBits>::check};
+};
+template<unsigned numBits, uint32_t value, class Next> struct ShiftOutQ
+   : Element<Bytes<QuickBits<numBits>::bytes, JTAG_SHIFT_OUT_Q(QuickBits<numBits>::code), value>, Next, Plain> {
+   enum {check = QuickBits<numBits>::check};
+};
+template<unsigned numBits, uint32_t value, class Next> struct ShiftInOutQ
+   : Element<Bytes<QuickBits<numBits>::bytes, JTAG_SHIFT_IN_OUT_Q(QuickBits<numBits>::code), value>, Next, Plain> {
+   enum {check = QuickBits<numBits>::check};
+};
+template<unsigned numBits, class Id, class Next> struct ShiftOutQVar
+   : Element<VarBytes<Bytes<0, JTAG_SHIFT_OUT_Q(QuickBits<numBits>::code)>, QuickBits<numBits>::bytes, Id>, Next, Plain> {
+   enum {check = QuickBits<numBits>::check};
+};
+
+//! Data consumed through the data pointer e.g. by JTAG_SHIFT_OUT_DP
+template<class Id, class Next> struct Var8  : Element<VarBytes<Empty, 1, Id>, Next, Plain> {};
+template<class Id, class Next> struct Var16 : Element<VarBytes<Empty, 2, Id>, Next, Plain> {};
+template<class Id, class Next> struct Var32 : Element<VarBytes<Empty, 4, Id>, Next, Plain> {};
+
+//! REPEAT blocks
+template<unsigned count, class Next> struct RepeatQ : Element<Bytes<0, JTAG_REPEAT_Q(count)>, Next, OpensRepeat<false> > {
+   enum {check = sizeof(Check<(count >= 2) && (count <= 32)>)};
+};
+template<uint8_t count, class Next> struct Repeat8 : Element<Bytes<1, JTAG_REPEAT8, count>, Next, OpensRepeat<false> > {};
+template<class Next> struct RepeatDP  : Element<Bytes<0, JTAG_REPEAT_DP>,  Next, OpensRepeat<false> > {};
+template<class Next> struct Repeat    : Element<Bytes<0, JTAG_REPEAT>,     Next, OpensRepeat<true> > {};
+template<class Next> struct EndRepeat : Element<Bytes<0, JTAG_END_REPEAT>, Next, ClosesRepeat> {};
+template<class Next> struct Break     : Element<Bytes<0, JTAG_BREAK>,      Next, WithinRepeat> {};
+template<class Next> struct Continue  : Element<Bytes<0, JTAG_CONTINUE>,   Next, WithinRepeat> {};
+
+//! IF blocks - op is one of JTAG_IF_... using the pushed value
+template<uint8_t op, class Next> struct If : Element<Bytes<0, op>, Next, OpensIf> {
+   enum {check = sizeof(Check<IsIfOp<op>::value>)};
+};
+template<class Next> struct Else  : Element<Bytes<0, JTAG_ELSE>,   Next, StartsElse> {};
+template<class Next> struct EndIf : Element<Bytes<0, JTAG_END_IF>, Next, ClosesIf> {};
+
+//! Subroutines
+template<unsigned sub, class Next> struct Sub : Element<Bytes<0, JTAG_SUB(sub)>, Next, OpensSub> {
+   enum {check = sizeof(Check<(sub < 4)>)};
+};
+template<class Next> struct EndSub : Element<Bytes<0, JTAG_END_SUB>, Next, ClosesSub> {};
+template<class Next> struct Return : Element<Bytes<0, JTAG_RETURN>,  Next, WithinSub> {};
+
+//! ARM AP accesses - count (set at run-time) and 16-bit compressed AP address
+template<class CountId, uint32_t apAddress, class Next> struct ArmReadAP
+   : Element<ArmAPBytes<JTAG_ARM_READAP, CountId, apAddress>, Next, Plain> {};
+template<class CountId, uint32_t apAddress, class Next> struct ArmWriteAP
+   : Element<ArmAPBytes<JTAG_ARM_WRITEAP, CountId, apAddress>, Next, Plain> {};
+//! ARM AP write of 32-bit value set at run-time
+template<uint32_t apAddress, class ValueId, class Next> struct ArmWriteAPImmediate
+   : Element<VarBytes<Bytes<2, JTAG_ARM_WRITEAP_I, ((apAddress>>16)&0xFF00)|(apAddress&0xFF)>, 4, ValueId>, Next, Plain> {};
+
+//! End of sequence (JTAG_END)
+struct End   : Element<Bytes<0, JTAG_END>, Nil, Terminates> {};
+//! End of a fragment that is followed by other sequence bytes
+struct NoEnd : Element<Empty, Nil, Terminates> {};
+
+//=======================================================================
+// Operations on element lists
+//
+//! Validate a list against operand, block structure and push rules
+template<class List, class Blocks=NoBlock, bool pushed=false>
+struct Validate {
+   typedef typename List::rule::template Apply<Blocks, pushed> Step;
+   enum {ok = List::check && Step::check &&
+              Validate<typename List::next, typename Step::blocks, Step::leavesPush>::ok};
+};
+template<class Blocks, bool pushed>
+struct Validate<Nil, Blocks, pushed> {
+   enum {ok = 1};
+};
+
+//! Size of list in bytes
+template<class List> struct SizeOf      { enum {value = List::size+SizeOf<typename List::next>::value}; };
+template<>           struct SizeOf<Nil> { enum {value = 0}; };
+
+//! Emit bytes for list
+template<class List> struct Emit {
+   static void to(uint8_t *buffer) {
+      List::emit(buffer);
+      Emit<typename List::next>::to(buffer+List::size);
+   }
+};
+template<> struct Emit<Nil> {
+   static void to(uint8_t *) {}
+};
+
+//! Locate variable field in list
+template<class List, class Id, unsigned base=0> struct Locate;
+template<bool found, class List, class Id, unsigned base> struct LocateIf;
+template<class List, class Id, unsigned base> struct LocateIf<true, List, Id, base> {
+   enum {offset = base+List::varOffset, size = List::varSize};
+};
+template<class List, class Id, unsigned base> struct LocateIf<false, List, Id, base>
+   : Locate<typename List::next, Id, base+List::size> {};
+template<class List, class Id, unsigned base> struct Locate
+   : LocateIf<IsSame<typename List::VarId, Id>::value, List, Id, base> {};
+
+//=======================================================================
+//! A completed sequence (or sequence fragment) held as a byte image
+//!
+//! @tparam List - sequence elements
+//!
+template<class List>
+class Program {
+   enum {check = sizeof(Check<Validate<List>::ok>)};
+
+public:
+   //! Size of the sequence in bytes
+   enum {size = SizeOf<List>::value};
+
+   //! Offset of variable field Id within the sequence
+   template<class Id> struct offset {
+      enum {value = Locate<List, Id>::offset};
+   };
+
+   //! Get the sequence image (variable fields are zero)
+   static const uint8_t *data() {
+      static uint8_t image[size];
+      static bool    built = false;
+      if (!built) {
+         Emit<List>::to(image);
+         built = true;
+      }
+      return image;
+   }
+   //! Copy the sequence image to a buffer
+   //!
+   //! @param buffer - where to copy sequence
+   //!
+   //! @return pointer to byte following sequence in buffer
+   //!
+   static uint8_t *copyTo(uint8_t *buffer) {
+      memcpy(buffer, data(), size);
+      return buffer+size;
+   }
+   //! Set variable field Id in a copy of the sequence
+   //!
+   //! @param buffer - start of sequence copy
+   //! @param value  - value for field (written big-endian)
+   //!
+   template<class Id> static void set(uint8_t *buffer, uint32_t value) {
+      putValue(buffer+Locate<List, Id>::offset, Locate<List, Id>::size, value);
+   }
+};
+
+} // namespace JTAGBuilder
+
+#endif /* JTAGSEQUENCEBUILDER_H_ */
@@ -0,0 +1,498 @@
+/*
+ * JTAGSequenceOptimiser.cpp
+ *
+ *  Created on: 19/10/2026
+ *      Author: agent
+ */
+#include <string.h>
+#include "JTAGSequence.h"
+#include "Log.h"
+
+//! Peephole optimiser for JTAG sequences
+//!
+//! The sequence is processed in straight-line segments.  Any control-flow opcode
+//! (REPEAT, IF, SUB etc.) or opcode that executes code on the BDM ends a segment
+//! and all knowledge of the TAP is discarded.  Within a segment:
+//!  - JTAG_NOP is removed
+//!  - JTAG_SET_EXIT_... that do not change the exit action, or are overwritten
+//!    before a shift, are removed
+//!  - Adjacent JTAG_SHIFT_OUT_Q that stay in SHIFT-DR/IR are merged (up to 32 bits)
+//!  - An IR scan that writes the value already in the IR is replaced by a DR scan
+//!    or removed
+//!  - Repeated JTAG_TEST_LOGIC_RESET is removed
+//!  - JTAG_ARM_WRITEAP_I to AHB-AP.CSW with the value already written is removed
+//!
+//! The data-out area following the sequence is copied unchanged.
+//!
+
+// Clock cycles used for TAP movement around an IR scan (Idle->Shift-IR, Exit1-IR->Update-IR)
+#define IR_SCAN_OVERHEAD   (6)
+// Approximate clock cycles for an ARM DPACC/APACC write
+#define ARM_ACCESS_CLOCKS  (35+IR_SCAN_OVERHEAD)
+// AHB-AP.CSW as ADDR16
+#define ARM_AHB_AP_CSW     (0x0000)
+
+#define EXIT_UNKNOWN (0xFF)
+
+//! Off by default - the optimised sequence has not been shown to be equivalent
+//! to the original for every sequence the DLL builds.
+static bool optimisationEnabled = false;
+
+//! Enable/disable optimisation of sequences by executeJTAGSequence()
+//!
+//! @param enable - true to enable optimisation (default is disabled)
+//!
+void setJTAGSequenceOptimisation(bool enable) {
+   optimisationEnabled = enable;
+}
+
+bool getJTAGSequenceOptimisation(void) {
+   return optimisationEnabled;
+}
+
+class JTAGSequenceOptimiser {
+private:
+   enum TapState {tapUnknown, tapReset, tapIdle, tapShiftDR, tapShiftIR};
+
+   uint8_t       *out;
+   uint8_t        wantedExit;   //!< Exit action as set by input sequence
+   uint8_t        emittedExit;  //!< Exit action as set by output sequence
+   TapState       tapState;
+   bool           irKnown;
+   uint8_t        irLength;
+   uint32_t       irValue;
+   bool           cswKnown;
+   uint32_t       cswValue;
+   bool           scanStart;    //!< No bits shifted since entering SHIFT-DR/IR
+   bool           pending;      //!< A JTAG_SHIFT_OUT_Q is held for merging
+   bool           pendingWhole; //!< Held shift started at beginning of scan
+   uint8_t        pendingBits;
+   uint32_t       pendingValue;
+   uint8_t        pendingExit;
+   unsigned       clocksSaved;
+
+   static unsigned instructionLength(const uint8_t *sequence);
+   static bool     isExitOpcode(uint8_t opcode);
+   static uint8_t  exitOf(uint8_t opcode);
+   static uint8_t  quickBits(uint8_t opcode);
+   static uint32_t quickValue(const uint8_t *sequence);
+   static uint32_t value32(const uint8_t *sequence);
+
+   void forget(void);
+   void emitExit(uint8_t exit);
+   void flushShift(void);
+   void boundary(void);
+   void shiftDone(uint8_t exit);
+   bool elideIRScan(const uint8_t *&sequence);
+
+public:
+   unsigned optimise(uint8_t sequenceLength, const uint8_t *sequence, uint8_t *buffer);
+   unsigned getClocksSaved(void) { return clocksSaved; }
+};
+
+//! Length of instruction including in-line operands
+//!
+//! @return length, 0 => unknown opcode
+//!
+unsigned JTAGSequenceOptimiser::instructionLength(const uint8_t *sequence) {
+   uint8_t opcode = *sequence;
+   switch (opcode&JTAG_COMMAND_MASK) {
+      case JTAG_SHIFT_OUT_Q(0):
+      case JTAG_SHIFT_IN_OUT_Q(0):
+         return 1+BITS_TO_BYTES(quickBits(opcode));
+      case JTAG_SHIFT_IN_Q(0):
+      case JTAG_REPEAT_Q(0):
+      case JTAG_PUSH_Q(0):
+         return 1;
+   }
+   switch (opcode) {
+      case JTAG_SET_ERROR:
+      case JTAG_REPEAT8:
+      case JTAG_PUSH8:
+      case JTAG_SHIFT_OUT_VARA:
+      case JTAG_SHIFT_OUT_VARB:
+      case JTAG_SHIFT_OUT_VARC:
+      case JTAG_SHIFT_OUT_VARD:
+      case JTAG_SHIFT_OUT_DP:
+      case JTAG_SHIFT_IN_DP:
+      case JTAG_SHIFT_IN_OUT_DP:
+         return 2;
+      case JTAG_PUSH16:
+         return 3;
+      case JTAG_PUSH32:
+         return 5;
+      case JTAG_SHIFT_IN_OUT_VARA:
+      case JTAG_SHIFT_IN_OUT_VARB:
+      case JTAG_SHIFT_IN_OUT_VARC:
+      case JTAG_SHIFT_IN_OUT_VARD:
+         return 2+BITS_TO_BYTES(sequence[1]);
+      case JTAG_ARM_READAP:
+      case JTAG_ARM_WRITEAP:
+         return 4;
+      case JTAG_ARM_WRITEAP_I:
+         return 7;
+      case JTAG_SET_PADDING:
+         return 9;
+   }
+   if (opcode < JTAG_MISC2) {
+      // Remaining MISC0/MISC1 opcodes have no in-line operands
+      return 1;
+   }
+   if ((opcode == JTAG_READ_MEM) || (opcode == JTAG_WRITE_MEM)) {
+      return 1;
+   }
+   return 0;
+}
+
+bool JTAGSequenceOptimiser::isExitOpcode(uint8_t opcode) {
+   return (opcode >= JTAG_SET_STAY_SHIFT) && (opcode <= JTAG_SET_EXIT_IDLE);
+}
+
+uint8_t JTAGSequenceOptimiser::exitOf(uint8_t opcode) {
+   switch (opcode) {
+      case JTAG_SET_STAY_SHIFT:    return JTAG_STAY_SHIFT;
+      case JTAG_SET_EXIT_SHIFT_DR: return JTAG_EXIT_SHIFT_DR;
+      case JTAG_SET_EXIT_SHIFT_IR: return JTAG_EXIT_SHIFT_IR;
+      default:                     return JTAG_EXIT_IDLE;
+   }
+}
+
+//! Number of bits for quick shift (0 => 32)
+//!
+uint8_t JTAGSequenceOptimiser::quickBits(uint8_t opcode) {
+   uint8_t numBits = opcode&JTAG_NUM_BITS_MASK;
+   return (numBits == 0)?32:numBits;
+}
+
+//! Value for JTAG_SHIFT_OUT_Q (big-endian in-line data)
+//!
+uint32_t JTAGSequenceOptimiser::quickValue(const uint8_t *sequence) {
+   uint8_t  numBits = quickBits(*sequence++);
+   uint32_t value   = 0;
+   for (int index=BITS_TO_BYTES(numBits); index>0; index--) {
+      value = (value<<8)|*sequence++;
+   }
+   if (numBits < 32) {
+      value &= (1UL<<numBits)-1;
+   }
+   return value;
+}
+
+//! 32-bit big-endian value
+//!
+uint32_t JTAGSequenceOptimiser::value32(const uint8_t *sequence) {
+   return ((uint32_t)sequence[0]<<24)|((uint32_t)sequence[1]<<16)|((uint32_t)sequence[2]<<8)|sequence[3];
+}
+
+//! Discard all knowledge of the target state
+//!
+void JTAGSequenceOptimiser::forget(void) {
+   tapState  = tapUnknown;
+   irKnown   = false;
+   cswKnown  = false;
+}
+
+//! Make sure the exit action for the output sequence is as given
+//!
+void JTAGSequenceOptimiser::emitExit(uint8_t exit) {
+   static const uint8_t exitOpcodes[] = {
+      JTAG_SET_STAY_SHIFT, JTAG_SET_EXIT_IDLE, JTAG_SET_EXIT_SHIFT_DR, JTAG_SET_EXIT_SHIFT_IR,
+   };
+   if (exit != emittedExit) {
+      *out++      = exitOpcodes[exit&JTAG_EXIT_ACTION_MASK];
+      emittedExit = exit;
+   }
+}
+
+//! Emit held JTAG_SHIFT_OUT_Q
+//!
+void JTAGSequenceOptimiser::flushShift(void) {
+   if (!pending) {
+      return;
+   }
+   pending = false;
+   emitExit(pendingExit);
+   *out++ = JTAG_SHIFT_OUT_Q(pendingBits);
+   for (int index=BITS_TO_BYTES(pendingBits)-1; index>=0; index--) {
+      *out++ = (uint8_t)(pendingValue>>(8*index));
+   }
+}
+
+//! Start of a new straight-line segment
+//!
+void JTAGSequenceOptimiser::boundary(void) {
+   flushShift();
+   if (wantedExit != EXIT_UNKNOWN) {
+      emitExit(wantedExit);
+   }
+   wantedExit  = EXIT_UNKNOWN;
+   emittedExit = EXIT_UNKNOWN;
+   forget();
+}
+
+//! Update TAP state after a shift
+//!
+void JTAGSequenceOptimiser::shiftDone(uint8_t exit) {
+   scanStart = (exit != JTAG_STAY_SHIFT);
+   switch (exit) {
+      case JTAG_EXIT_IDLE:     tapState = tapIdle;    break;
+      case JTAG_EXIT_SHIFT_DR: tapState = tapShiftDR; break;
+      case JTAG_EXIT_SHIFT_IR: tapState = tapShiftIR; break;
+      case JTAG_STAY_SHIFT:                           break;
+      default:                 tapState = tapUnknown; break;
+   }
+}
+
+//! Check if IR scan at sequence writes the value already in IR
+//!
+//! @param sequence - Points at JTAG_MOVE_IR_SCAN, advanced past the IR scan if elided
+//!
+//! @return true => IR scan removed
+//!
+bool JTAGSequenceOptimiser::elideIRScan(const uint8_t *&sequence) {
+   if (!irKnown || (tapState != tapIdle)) {
+      return false;
+   }
+   const uint8_t *next = sequence+1;
+   uint8_t        exit = wantedExit;
+   while ((*next == JTAG_NOP) || isExitOpcode(*next)) {
+      if (*next != JTAG_NOP) {
+         exit = exitOf(*next);
+      }
+      next++;
+   }
+   if (((*next&JTAG_COMMAND_MASK) != JTAG_SHIFT_OUT_Q(0)) ||
+       (quickBits(*next) != irLength) || (quickValue(next) != irValue) ||
+       ((exit != JTAG_EXIT_IDLE) && (exit != JTAG_EXIT_SHIFT_DR))) {
+      return false;
+   }
+   // IR scan is redundant
+   wantedExit = exit;
+   sequence   = next+instructionLength(next);
+   if (exit == JTAG_EXIT_SHIFT_DR) {
+      flushShift();
+      *out++    = JTAG_MOVE_DR_SCAN;
+      tapState  = tapShiftDR;
+      scanStart = true;
+   }
+   clocksSaved += irLength+IR_SCAN_OVERHEAD;
+   return true;
+}
+
+//! Optimise sequence
+//!
+//! @param sequenceLength - Length of sequence including data-out area
+//! @param sequence       - Sequence to optimise
+//! @param buffer         - Buffer for optimised sequence (at least sequenceLength bytes)
+//!
+//! @return Length of optimised sequence, 0 => sequence could not be optimised
+//!
+unsigned JTAGSequenceOptimiser::optimise(uint8_t sequenceLength, const uint8_t *sequence, uint8_t *buffer) {
+   const uint8_t *sequenceEnd = sequence+sequenceLength;
+
+   out          = buffer;
+   wantedExit   = JTAG_EXIT_IDLE;  // Default on entry
+   emittedExit  = JTAG_EXIT_IDLE;
+   pending      = false;
+   scanStart    = false;
+   clocksSaved  = 0;
+   forget();
+
+   while (sequence < sequenceEnd) {
+      uint8_t  opcode = *sequence;
+      unsigned length = instructionLength(sequence);
+      if ((length == 0) || (sequence+length > sequenceEnd)) {
+         return 0;
+      }
+      if ((opcode == JTAG_END) || (opcode == JTAG_SAVE_SUB)) {
+         // Remainder is data-out area
+         boundary();
+         if ((unsigned)(out-buffer)+(sequenceEnd-sequence) > sequenceLength) {
+            return 0;
+         }
+         memcpy(out, sequence, sequenceEnd-sequence);
+         out += sequenceEnd-sequence;
+         return out-buffer;
+      }
+      if (opcode == JTAG_NOP) {
+         sequence++;
+         continue;
+      }
+      if (isExitOpcode(opcode)) {
+         // Applied when needed
+         wantedExit = exitOf(opcode);
+         sequence++;
+         continue;
+      }
+      if (opcode == JTAG_MOVE_IR_SCAN) {
+         if (elideIRScan(sequence)) {
+            continue;
+         }
+      }
+      if ((opcode == JTAG_TEST_LOGIC_RESET) && (tapState == tapReset)) {
+         clocksSaved += 5;
+         sequence++;
+         continue;
+      }
+      if ((opcode == JTAG_ARM_WRITEAP_I) &&
+          (((sequence[1]<<8)|sequence[2]) == ARM_AHB_AP_CSW) &&
+          cswKnown && (cswValue == value32(sequence+3))) {
+         clocksSaved += ARM_ACCESS_CLOCKS;
+         sequence += length;
+         continue;
+      }
+      if ((opcode&JTAG_COMMAND_MASK) == JTAG_SHIFT_OUT_Q(0)) {
+         uint8_t  numBits = quickBits(opcode);
+         uint32_t value   = quickValue(sequence);
+         if (pending && (pendingExit == JTAG_STAY_SHIFT) && (pendingBits+numBits <= 32)) {
+            // Merge with previous shift
+            pendingValue |= value<<pendingBits;
+            pendingBits  += numBits;
+         }
+         else {
+            flushShift();
+            pending       = true;
+            pendingWhole  = scanStart;
+            pendingBits   = numBits;
+            pendingValue  = value;
+         }
+         pendingExit = wantedExit;
+         if (tapState == tapShiftIR) {
+            // IR value is known if the complete scan is held
+            irKnown  = pendingWhole && (wantedExit != JTAG_STAY_SHIFT);
+            irLength = pendingBits;
+            irValue  = pendingValue;
+         }
+         else if (tapState != tapShiftDR) {
+            irKnown  = false;
+         }
+         shiftDone(wantedExit);
+         sequence += length;
+         continue;
+      }
+      flushShift();
+      switch (opcode&JTAG_COMMAND_MASK) {
+         case JTAG_SHIFT_IN_Q(0):
+         case JTAG_SHIFT_IN_OUT_Q(0):
+            emitExit(wantedExit);
+            if (tapState != tapShiftDR) {
+               irKnown = false;
+            }
+            shiftDone(wantedExit);
+            break;
+         case JTAG_PUSH_Q(0):
+            break;
+         case JTAG_MISC0:
+         case JTAG_MISC1:
+            switch (opcode) {
+               case JTAG_TEST_LOGIC_RESET:
+                  irKnown  = false;
+                  tapState = tapReset;
+                  break;
+               case JTAG_MOVE_DR_SCAN:
+                  tapState  = tapShiftDR;
+                  scanStart = true;
+                  break;
+               case JTAG_MOVE_IR_SCAN:
+                  tapState  = tapShiftIR;
+                  scanStart = true;
+                  break;
+               case JTAG_SHIFT_OUT_VARA:
+               case JTAG_SHIFT_OUT_VARB:
+               case JTAG_SHIFT_OUT_VARC:
+               case JTAG_SHIFT_OUT_VARD:
+               case JTAG_SHIFT_IN_OUT_VARA:
+               case JTAG_SHIFT_IN_OUT_VARB:
+               case JTAG_SHIFT_IN_OUT_VARC:
+               case JTAG_SHIFT_IN_OUT_VARD:
+               case JTAG_SHIFT_OUT_DP_VARA:
+               case JTAG_SHIFT_OUT_DP:
+               case JTAG_SHIFT_IN_DP:
+               case JTAG_SHIFT_IN_OUT_DP:
+                  emitExit(wantedExit);
+                  if (tapState != tapShiftDR) {
+                     irKnown = false;
+                  }
+                  shiftDone(wantedExit);
+                  break;
+               case JTAG_SET_IN_FILL_0:
+               case JTAG_SET_IN_FILL_1:
+               case JTAG_DEBUG_ON:
+               case JTAG_DEBUG_OFF:
+               case JTAG_SET_BUSY:
+               case JTAG_PUSH8:
+               case JTAG_PUSH16:
+               case JTAG_PUSH32:
+               case JTAG_PUSH_DP_8:
+               case JTAG_PUSH_DP_16:
+               case JTAG_PUSH_DP_32:
+               case JTAG_LOAD_VARA:
+               case JTAG_LOAD_VARB:
+               case JTAG_SAVE_OUT_DP_VARC:
+               case JTAG_SAVE_OUT_DP_VARD:
+               case JTAG_RESTORE_DP_VARC:
+               case JTAG_RESTORE_DP_VARD:
+               case JTAG_SKIP_DP:
+                  // No effect on TAP
+                  break;
+               default:
+                  // Control flow etc.
+                  boundary();
+                  break;
+            }
+            break;
+         default:
+            switch (opcode) {
+               case JTAG_ARM_WRITEAP_I:
+                  if (((sequence[1]<<8)|sequence[2]) == ARM_AHB_AP_CSW) {
+                     cswKnown = true;
+                     cswValue = value32(sequence+3);
+                  }
+                  irKnown  = false;
+                  tapState = tapUnknown;
+                  break;
+               case JTAG_ARM_WRITEAP:
+                  if (((sequence[2]<<8)|sequence[3]) == ARM_AHB_AP_CSW) {
+                     cswKnown = false;
+                  }
+                  irKnown  = false;
+                  tapState = tapUnknown;
+                  break;
+               case JTAG_ARM_READAP:
+                  irKnown  = false;
+                  tapState = tapUnknown;
+                  break;
+               default:
+                  boundary();
+                  break;
+            }
+            break;
+      }
+      memcpy(out, sequence, length);
+      out      += length;
+      sequence += length;
+   }
+   // No JTAG_END
+   return 0;
+}
+
+//! Optimise JTAG sequence
+//!
+//! @param sequenceLength - Length of sequence including data-out area
+//! @param sequence       - Sequence to optimise
+//! @param buffer         - Buffer for optimised sequence (at least sequenceLength bytes)
+//! @param clocksSaved    - Approximate number of JTAG clocks saved
+//!
+//! @return Length of optimised sequence, 0 => sequence is unchanged
+//!
+unsigned optimiseJTAGSequence(uint8_t sequenceLength, const uint8_t *sequence, uint8_t *buffer, unsigned *clocksSaved) {
+   JTAGSequenceOptimiser optimiser;
+   unsigned length = optimiser.optimise(sequenceLength, sequence, buffer);
+   if ((length == 0) || (length >= sequenceLength)) {
+      *clocksSaved = 0;
+      return 0;
+   }
+   *clocksSaved = optimiser.getClocksSaved();
+   print("optimiseJTAGSequence() - Saved %d bytes, ~%d clocks\n", sequenceLength-length, *clocksSaved);
+   return length;
+}
@@ -89,6 +89,22 @@ JNIEXPORT jint JNICALL Java_net_sourceforge_usbdm_connections_usbdm_Usbdm_getBDM
 JNIEXPORT jstring JNICALL Java_net_sourceforge_usbdm_connections_usbdm_Usbdm_getErrorString
   (JNIEnv *, jclass, jint);
 
+/*
+ * Class:     net_sourceforge_usbdm_connections_usbdm_Usbdm
+ * Method:    getStatistics
+ * Signature: (Lnet/sourceforge/usbdm/connections/usbdm/Usbdm/Statistics;)I
+ */
+JNIEXPORT jint JNICALL Java_net_sourceforge_usbdm_connections_usbdm_Usbdm_getStatistics
+  (JNIEnv *, jclass, jobject);
+
+/*
+ * Class:     net_sourceforge_usbdm_connections_usbdm_Usbdm
+ * Method:    resetStatistics
+ * Signature: ()I
+ */
+JNIEXPORT jint JNICALL Java_net_sourceforge_usbdm_connections_usbdm_Usbdm_resetStatistics
+  (JNIEnv *, jclass);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,17 @@
+/* DO NOT EDIT THIS FILE - it is machine generated */
+#include <jni.h>
+/* Header for class net_sourceforge_usbdm_connections_usbdm_Usbdm_Statistics */
+
+#ifndef _Included_net_sourceforge_usbdm_connections_usbdm_Usbdm_Statistics
+#define _Included_net_sourceforge_usbdm_connections_usbdm_Usbdm_Statistics
+#ifdef __cplusplus
+extern "C" {
+#endif
+#undef net_sourceforge_usbdm_connections_usbdm_Usbdm_Statistics_COMMANDS
+#define net_sourceforge_usbdm_connections_usbdm_Usbdm_Statistics_COMMANDS 128L
+#undef net_sourceforge_usbdm_connections_usbdm_Usbdm_Statistics_LATENCY_BUCKETS
+#define net_sourceforge_usbdm_connections_usbdm_Usbdm_Statistics_LATENCY_BUCKETS 12L
+#ifdef __cplusplus
+}
+#endif
+#endif
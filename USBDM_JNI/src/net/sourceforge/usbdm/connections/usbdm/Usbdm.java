@@ -13,6 +13,8 @@ USBDM_API USBDM_ErrorCode  USBDM_GetBDMDescription(const char **deviceDescriptio
 USBDM_API USBDM_ErrorCode  USBDM_GetBDMSerialNumber(const char **deviceDescription);
 USBDM_API USBDM_ErrorCode  USBDM_Open(unsigned char deviceNo);
 USBDM_API USBDM_ErrorCode  USBDM_Close(void);
+USBDM_API USBDM_ErrorCode  USBDM_GetStatistics(USBDM_Statistics_t *statistics);
+USBDM_API USBDM_ErrorCode  USBDM_ResetStatistics(void);
 */
 
 public class Usbdm {
@@ -26,6 +28,8 @@ public class Usbdm {
    private static native int getBDMSerialNumber(char[] serialNumber);
    private static native int getBDMFirwareVersion(BdmInformation bdmInfo);
    private static native String getErrorString( int errorNum);
+   private static native int getStatistics(Statistics statistics);
+   private static native int resetStatistics();
 
    private static native int getUsbdmPath(char[] serialNumber);
 
@@ -66,6 +70,42 @@ public class Usbdm {
       }
    };
 
+   // Class holding statistics for communication with the BDM
+   // Per-command values are indexed by command number
+   //
+   public static class Statistics {
+      public static final int COMMANDS        = 128;
+      public static final int LATENCY_BUCKETS = 12;
+
+      long   toggleRetries;                    //!< Responses re-read due to a USB or toggle error
+      long   usbRetries;                       //!< Commands re-sent due to a USB error
+      long   busyResponses;                    //!< BDM_RC_BUSY responses
+      long   sleepCount;                       //!< Number of delays
+      long   sleepTime;                        //!< Total time in delays (us)
+      long[] count     = new long[COMMANDS];   //!< Number of transactions
+      long[] errors    = new long[COMMANDS];   //!< Number of transactions returning an error
+      long[] bytesOut  = new long[COMMANDS];   //!< Bytes sent to BDM
+      long[] bytesIn   = new long[COMMANDS];   //!< Bytes received from BDM
+      long[] totalTime = new long[COMMANDS];   //!< Total transaction time (us)
+      long[] maxTime   = new long[COMMANDS];   //!< Longest transaction (us)
+      long[] latency   = new long[COMMANDS*LATENCY_BUCKETS]; //!< Histogram of transaction time [command*LATENCY_BUCKETS+bucket]
+
+      public Statistics() {
+         super();
+      }
+      public String toString() {
+         long transactions = 0;
+         long time         = 0;
+         for (int command=0; command<COMMANDS; command++) {
+            transactions += count[command];
+            time         += totalTime[command];
+         }
+         return "(transactions="+transactions+",time="+time+"us,toggleRetries="+toggleRetries+
+                ",usbRetries="+usbRetries+",busy="+busyResponses+
+                ",sleeps="+sleepCount+",sleepTime="+sleepTime+"us)";
+      }
+   };
+
    // Class describing the bdm
    //
    public static class DeviceInfo {
@@ -146,6 +186,9 @@ public class Usbdm {
       }
       Usbdm.getBDMFirwareVersion(bdmInfo);
       System.err.println("info:"+bdmInfo.toString());
+      Statistics statistics = new Statistics();
+      Usbdm.getStatistics(statistics);
+      System.err.println("statistics:"+statistics.toString());
       Usbdm.exit();
     }
    
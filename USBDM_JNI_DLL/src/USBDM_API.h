@@ -588,6 +588,33 @@ typedef struct {
    unsigned                jtagBufferSize;       //!< Size of JTAG buffer (if supported)
 } USBDM_bdmInformation_t;
 
+//! Number of buckets in the latency histogram of \ref USBDM_CommandStatistics_t
+//! Bucket n counts transactions taking less than (64<<n) us that are not in a lower bucket.
+//! The last bucket counts all longer transactions.
+#define USBDM_LATENCY_BUCKETS (12)
+
+//! Statistics for a single BDM command
+typedef struct {
+   unsigned long           count;                //!< Number of transactions
+   unsigned long           errors;               //!< Number of transactions returning an error
+   uint64_t                bytesOut;             //!< Bytes sent to BDM
+   uint64_t                bytesIn;              //!< Bytes received from BDM
+   uint64_t                totalTime;            //!< Total transaction time (us)
+   unsigned long           maxTime;              //!< Longest transaction (us)
+   unsigned long           latency[USBDM_LATENCY_BUCKETS]; //!< Histogram of transaction time
+} USBDM_CommandStatistics_t;
+
+//! Statistics for BDM communication
+typedef struct {
+   unsigned                  size;               //!< Size of this structure
+   unsigned long             toggleRetries;      //!< Responses re-read due to a USB or toggle error
+   unsigned long             usbRetries;         //!< Commands re-sent due to a USB error
+   unsigned long             busyResponses;      //!< BDM_RC_BUSY responses
+   unsigned long             sleepCount;         //!< Number of delays (e.g. USB retries, target reset)
+   uint64_t                  sleepTime;          //!< Total time in delays (us)
+   USBDM_CommandStatistics_t commands[128];      //!< Statistics indexed by command (CMD_USBDM_xxx)
+} USBDM_Statistics_t;
+
 // The following functions are available when in BDM mode
 //====================================================================
 //
@@ -750,6 +777,29 @@ USBDM_ErrorCode  USBDM_GetCapabilities(HardwareCapabilities_t *capabilities);
 //!
 USBDM_API 
 USBDM_ErrorCode USBDM_GetBdmInformation(USBDM_bdmInformation_t *info);
+
+//! \brief Obtains statistics for communication with the BDM
+//!
+//! Statistics are accumulated from USBDM_Init() or USBDM_ResetStatistics()
+//!
+//! @param statistics ptr to structure to contain the statistics
+//!
+//! @return \n
+//!     BDM_RC_OK => OK \n
+//!     other     => Error code - see \ref USBDM_ErrorCode
+//!
+//! @note The size element of statistics should be initialised before call.
+//!
+USBDM_API
+USBDM_ErrorCode USBDM_GetStatistics(USBDM_Statistics_t *statistics);
+
+//! \brief Clears statistics for communication with the BDM
+//!
+//! @return \n
+//!     BDM_RC_OK => OK
+//!
+USBDM_API
+USBDM_ErrorCode USBDM_ResetStatistics(void);
 //! Set BDM interface options
 //!
 //! @param bdmOptions : Options to pass to BDM interface
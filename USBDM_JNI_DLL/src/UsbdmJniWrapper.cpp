@@ -17,6 +17,8 @@ USBDM_API USBDM_ErrorCode  USBDM_FindDevices(unsigned int *deviceCount);
 USBDM_API USBDM_ErrorCode  USBDM_ReleaseDevices(void);
 USBDM_API USBDM_ErrorCode  USBDM_GetBDMDescription(const char **deviceDescription);
 USBDM_API USBDM_ErrorCode  USBDM_GetBDMSerialNumber(const char **deviceDescription);
+USBDM_API USBDM_ErrorCode  USBDM_GetStatistics(USBDM_Statistics_t *statistics);
+USBDM_API USBDM_ErrorCode  USBDM_ResetStatistics(void);
 */
 
 /*
@@ -172,6 +174,94 @@ JNIEXPORT jint JNICALL Java_net_sourceforge_usbdm_connections_usbdm_Usbdm_getBDM
 	return rc;
 }
 
+const char *statisticsFieldNames[] = {
+   "toggleRetries",   //!< Responses re-read due to a USB or toggle error
+   "usbRetries",      //!< Commands re-sent due to a USB error
+   "busyResponses",   //!< BDM_RC_BUSY responses
+   "sleepCount",      //!< Number of delays
+   "sleepTime",       //!< Total time in delays (us)
+};
+
+const char *statisticsArrayNames[] = {
+   "count",           //!< Number of transactions
+   "errors",          //!< Number of transactions returning an error
+   "bytesOut",        //!< Bytes sent to BDM
+   "bytesIn",         //!< Bytes received from BDM
+   "totalTime",       //!< Total transaction time (us)
+   "maxTime",         //!< Longest transaction (us)
+};
+
+/*
+ * Sets a long[] field of a Java object
+ */
+static bool setLongArrayField(JNIEnv *env, jclass cls, jobject obj, const char *fieldName, const jlong *values, jsize size) {
+   jfieldID fieldID = env->GetFieldID(cls, fieldName, "[J");
+   if (fieldID == NULL)
+      return false;
+   jlongArray array = (jlongArray)env->GetObjectField(obj, fieldID);
+   if ((array == NULL) || (env->GetArrayLength(array) < size))
+      return false;
+   env->SetLongArrayRegion(array, 0, size, values);
+   return true;
+}
+
+/*
+ * Class:     edu_swin_mcu_debug_connections_usbdm_Usbdm
+ * Method:    getStatistics
+ * Signature: (Lnet/sourceforge/usbdm/connections/usbdm/Usbdm/Statistics;)I
+ */
+JNIEXPORT jint JNICALL Java_net_sourceforge_usbdm_connections_usbdm_Usbdm_getStatistics(JNIEnv *env, jclass, jobject jstatistics) {
+   static USBDM_Statistics_t statistics;
+   static jlong              perCommand[6][128];
+   static jlong              latency[128*USBDM_LATENCY_BUCKETS];
+   const unsigned            numCommands = sizeof(statistics.commands)/sizeof(statistics.commands[0]);
+
+   statistics.size = sizeof(USBDM_Statistics_t);
+   USBDM_ErrorCode rc = USBDM_GetStatistics(&statistics);
+   if (rc != BDM_RC_OK)
+      return rc;
+   jclass cls = env->GetObjectClass(jstatistics);
+   if (cls == NULL)
+      return BDM_RC_ILLEGAL_PARAMS;
+   jlong fieldValues[] = {statistics.toggleRetries, statistics.usbRetries,
+                          statistics.busyResponses, statistics.sleepCount,
+                          statistics.sleepTime};
+   for (unsigned indx=0; indx < sizeof(statisticsFieldNames)/sizeof(statisticsFieldNames[0]); indx++) {
+      jfieldID fieldID = env->GetFieldID(cls, statisticsFieldNames[indx], "J");
+      if (fieldID == NULL)
+         return BDM_RC_ILLEGAL_PARAMS;
+      env->SetLongField(jstatistics, fieldID, fieldValues[indx]);
+   }
+   for (unsigned command=0; command<numCommands; command++) {
+      const USBDM_CommandStatistics_t &entry = statistics.commands[command];
+      perCommand[0][command] = entry.count;
+      perCommand[1][command] = entry.errors;
+      perCommand[2][command] = entry.bytesOut;
+      perCommand[3][command] = entry.bytesIn;
+      perCommand[4][command] = entry.totalTime;
+      perCommand[5][command] = entry.maxTime;
+      for (unsigned bucket=0; bucket<USBDM_LATENCY_BUCKETS; bucket++) {
+         latency[command*USBDM_LATENCY_BUCKETS+bucket] = entry.latency[bucket];
+      }
+   }
+   for (unsigned indx=0; indx < sizeof(statisticsArrayNames)/sizeof(statisticsArrayNames[0]); indx++) {
+      if (!setLongArrayField(env, cls, jstatistics, statisticsArrayNames[indx], perCommand[indx], numCommands))
+         return BDM_RC_ILLEGAL_PARAMS;
+   }
+   if (!setLongArrayField(env, cls, jstatistics, "latency", latency, numCommands*USBDM_LATENCY_BUCKETS))
+      return BDM_RC_ILLEGAL_PARAMS;
+   return rc;
+}
+
+/*
+ * Class:     edu_swin_mcu_debug_connections_usbdm_Usbdm
+ * Method:    resetStatistics
+ * Signature: ()I
+ */
+JNIEXPORT jint JNICALL Java_net_sourceforge_usbdm_connections_usbdm_Usbdm_resetStatistics(JNIEnv *, jclass) {
+   return USBDM_ResetStatistics();
+}
+
 /*
  * Class:     edu_swin_mcu_debug_connections_usbdm_Usbdm
  * Method:    getErrorString
@@ -97,6 +97,22 @@ JNIEXPORT jstring JNICALL Java_net_sourceforge_usbdm_connections_usbdm_Usbdm_get
 JNIEXPORT jint JNICALL Java_net_sourceforge_usbdm_connections_usbdm_Usbdm_getUsbdmPath
   (JNIEnv *, jclass, jobject);
 
+/*
+ * Class:     net_sourceforge_usbdm_connections_usbdm_Usbdm
+ * Method:    getStatistics
+ * Signature: (Lnet/sourceforge/usbdm/connections/usbdm/Usbdm/Statistics;)I
+ */
+JNIEXPORT jint JNICALL Java_net_sourceforge_usbdm_connections_usbdm_Usbdm_getStatistics
+  (JNIEnv *, jclass, jobject);
+
+/*
+ * Class:     net_sourceforge_usbdm_connections_usbdm_Usbdm
+ * Method:    resetStatistics
+ * Signature: ()I
+ */
+JNIEXPORT jint JNICALL Java_net_sourceforge_usbdm_connections_usbdm_Usbdm_resetStatistics
+  (JNIEnv *, jclass);
+
 #ifdef __cplusplus
 }
 #endif
@@ -24,6 +24,7 @@
 
     Change History
 +==================================================================================
+| 19 Oct 2026 | Status, connect & debug information use batched transactions
 |  1 Aug 2012 | Created SWD version
 +==================================================================================
 \endverbatim
@@ -46,6 +47,7 @@
 #include "Utils.h"
 #include "ARM_Definitions.h"
 #include "Names.h"
+#include "SwdBatch.h"
 
 // Debug MCU configuration register STM32F100xx
 #define DBGMCU_CR  (0xE0042004)
@@ -54,16 +56,6 @@ void SWD_SetLogFile(FILE *fp) {
    setLogFileHandle(fp);
 }
 
-//! Obtain a 32-bit Little-Endian value from character array
-//!
-//! @param data - array of 4 bytes
-//!
-//! @return 32-bit value
-//!
-static inline uint32_t getData32Le(uint8_t *data) {
-   return (data[0])+(data[1]<<8)+(data[2]<<16)+(data[3]<<24);
-}
-
 //! Information describing the debug Interface
 static struct DebugInformation {
    // Details from AHB-AP
@@ -85,95 +77,56 @@ static struct DebugInformation {
       0x0,
 };
 
-//! Reads a word from target memory
-//!
-//! @note Breaks transfers on 2**10 boundary as TAR may not increment across this boundary
-//!
-//! @param address  - 32-bit starting address (aligned)
-//! @param data     - pointer to buffer for word
-//!
-//! @return error code
-//!
-static USBDM_ErrorCode armReadMemoryWord(uint32_t address, uint32_t *data) {
-   if (address != 0xE000EDF0) {
-      print("     readMemoryWord(a=0x%08X)\n", address);
-   }
-   uint8_t buff[4];
-   USBDM_ErrorCode rc = USBDM_ReadMemory(4,4,address, buff);
-   *data = getData32Le(buff);
-   return rc;
-}
-
-//! Writes a word to target memory
-//!
-//! @note Assumes aligned address
-//! @note Breaks transfers on 2**10 boundary as TAR may not increment across this boundary
-//!
-//! @param address - 32-bit address
-//! @param data    - ptr to buffer containing words
-//!
-//! @return error code
-//!
-static USBDM_ErrorCode armWriteMemoryWord(uint32_t address, const uint32_t *data) {
-   print("     writeMemoryWord(a=0x%08X)\n", address);
-   uint8_t buff[4] = {(*data)&0xFF, (*data>>8)&0xFF, (*data>>16)&0xFF, (*data>>24)&0xFF};
-   USBDM_ErrorCode rc = USBDM_WriteMemory(4, 4, address, buff);
-   return rc;
-}
-
 //! Read Information that describes the debug interface
 //!
 static USBDM_ErrorCode armReadDebugInformation(void) {
    USBDM_ErrorCode rc;
-   unsigned long dataIn;
 
    print("   readDebugInformation()\n");
 
-   // Check if Kinetis MDM-AP is present
-   rc = USBDM_ReadCReg(ARM_CRegMDM_AP_Ident, &dataIn);
+   // Identify APs and debug base address in a single batch
+   uint32_t mdmApIdent = 0;
+   uint32_t ahbApIdent;
+   uint32_t ahbApConfig;
+   uint32_t ahbApBase;
+   SwdBatch batch;
+   batch.apRead(ARM_CRegMDM_AP_Ident, &mdmApIdent);
+   batch.apRead(ARM_CRegAHB_AP_Id,    &ahbApIdent);
+   batch.apRead(AHB_AP_CFG,           &ahbApConfig);
+   batch.apRead(AHB_AP_Base,          &ahbApBase);
+   rc = batch.flush();
    if (rc != BDM_RC_OK) {
       return rc;
    }
-   debugInformation.MDM_AP_present = (dataIn == 0x001C0000);
+   // Check if Kinetis MDM-AP is present
+   debugInformation.MDM_AP_present = (mdmApIdent == 0x001C0000);
    if (debugInformation.MDM_AP_present) {
-      print("   readDebugInformation(): MDM-AP (Kinetis) found (Id=0x%08X)\n", dataIn);
+      print("   readDebugInformation(): MDM-AP (Kinetis) found (Id=0x%08X)\n", mdmApIdent);
    }
    // Check if ARM AMBA-AHB-AP present
-   rc = USBDM_ReadCReg(ARM_CRegAHB_AP_Id, &dataIn);
-   if (rc != BDM_RC_OK) {
-      return rc;
-   }
-   if ((dataIn&0x0FFF000F)!= 0x04770001) {
-      print("   readDebugInformation(): AMBA-AHB-AP not found (Id=0x%08X)!\n", dataIn);
+   if ((ahbApIdent&0x0FFF000F)!= 0x04770001) {
+      print("   readDebugInformation(): AMBA-AHB-AP not found (Id=0x%08X)!\n", ahbApIdent);
       return BDM_RC_ARM_ACCESS_ERROR;
    }
-   print("   readDebugInformation(): AMBA-AHB-AP found (Id=0x%08X)\n", dataIn);
+   print("   readDebugInformation(): AMBA-AHB-AP found (Id=0x%08X)\n", ahbApIdent);
    // Save the AHB_AP_CFG register
-   rc = USBDM_ReadCReg(AHB_AP_CFG, &dataIn);
-   if (rc != BDM_RC_OK) {
-      return rc;
-   }
-   debugInformation.memAPConfig = dataIn;
-   bool bigEndian = (dataIn&AHB_AP_CFG_BIGENDIAN)!=0;
+   debugInformation.memAPConfig = ahbApConfig;
+   bool bigEndian = (ahbApConfig&AHB_AP_CFG_BIGENDIAN)!=0;
    print("   readDebugInformation(): AHB_AP.CFG => 0x%08X, %s\n",
-         dataIn, bigEndian?"BigEndian":"LittleEndian");
+         ahbApConfig, bigEndian?"BigEndian":"LittleEndian");
 
    // Get Debug base address
-   rc = USBDM_ReadCReg(AHB_AP_Base, &dataIn);
+   print("   readDebugInformation(): AHB_AP.Base => 0x%08X\n", ahbApBase);
+   debugInformation.debugBaseaddr = ahbApBase & 0xFFFFF000;
+
+   // Read Peripheral ID0 & Component ID registers [0xFD0..0xFFF] as one block
+   uint32_t idRegs[12];
+   batch.memRead(debugInformation.debugBaseaddr+0xFD0, 12, idRegs);
+   rc = batch.flush();
    if (rc != BDM_RC_OK) {
       return rc;
    }
-   print("   readDebugInformation(): AHB_AP.Base => 0x%08X\n", dataIn);
-   debugInformation.debugBaseaddr = dataIn & 0xFFFFF000;
-
-   // Read ID registers
-   uint32_t buffer[4];
-   for (int index=0; index<4; index++) {
-      rc = armReadMemoryWord(debugInformation.debugBaseaddr+0xFF0+4*index, buffer+index);
-      if (rc != BDM_RC_OK) {
-         return rc;
-      }
-   }
+   const uint32_t *buffer = idRegs+8; // Component ID0..3 @0xFF0
    uint32_t id;
    id  = (buffer[0x0]&0xFF);
    id += (buffer[0x1]&0xFF)<<8;
@@ -187,12 +140,8 @@ static USBDM_ErrorCode armReadDebugInformation(void) {
    debugInformation.componentClass = (id>>12)&0xF;
    print("   armReadDebugInformation(): component class => 0x%X\n", debugInformation.componentClass);
 
-   // Read Peripheral ID0 register
-   rc = armReadMemoryWord(debugInformation.debugBaseaddr+0xFD0, buffer);
-   if (rc != BDM_RC_OK) {
-      return rc;
-   }
-   id  = (buffer[0x0]>>4)&0xFF;
+   // Peripheral ID0 register @0xFD0
+   id  = (idRegs[0x0]>>4)&0xFF;
    debugInformation.size4Kb = 1<<id;
    print("   armReadDebugInformation(): 4Kb size => %d\n", debugInformation.size4Kb);
 
@@ -238,13 +187,14 @@ USBDM_ErrorCode SWD_Initialise() {
    do {
       rc = USBDM_ReadDReg(SWD_DRegSTATUS, &dataIn);
       print("   SWD_Initialise() DP_ControlStatus= 0x%08X\n", dataIn);
-      milliSleep(100);
       if (rc != BDM_RC_OK) {
          return rc;
       }
       if ((dataIn & (CSYSPWRUPACK|CDBGPWRUPACK)) == (CSYSPWRUPACK|CDBGPWRUPACK)) {
          break;
       }
+      // Only delay if not already powered up
+      milliSleep(100);
    } while(retry-- > 0);
    if ((dataIn & (CSYSPWRUPACK|CDBGPWRUPACK)) != (CSYSPWRUPACK|CDBGPWRUPACK)) {
       return BDM_RC_ARM_PWR_UP_FAIL;
@@ -284,23 +234,17 @@ USBDM_ErrorCode SWD_Connect() {
    retry = 4;
 #if 1
    do {
-      uint32_t debugOnValue = DHCSR_DBGKEY|DHCSR_C_DEBUGEN|DHCSR_C_HALT;
-      rc = armWriteMemoryWord(DHCSR, &debugOnValue);
+      // Enable debug & read back result as one batch
+      uint32_t dataIn;
+      SwdBatch batch;
+      batch.memWrite(DHCSR, DHCSR_DBGKEY|DHCSR_C_DEBUGEN|DHCSR_C_HALT);
+      batch.memRead(DHCSR, &dataIn);
+      rc = batch.flush();
       if (rc != BDM_RC_OK) {
-         print("SWD_Connect() DHCSR write failed\n");
+         print("SWD_Connect() DHCSR write/read failed\n");
          continue;
       }
-      uint32_t dataIn;
-      if (rc == BDM_RC_OK) {
-         rc = armReadMemoryWord(DHCSR, &dataIn);
-         if (rc != BDM_RC_OK) {
-            print("   SWD_Connect() DHCSR read failed\n");
-            continue;
-         }
-         else {
-            print("SWD_Connect() DHCSR value = %s(0x%08X)\n", getDHCSRName(dataIn), dataIn);
-         }
-      }
+      print("SWD_Connect() DHCSR value = %s(0x%08X)\n", getDHCSRName(dataIn), dataIn);
       if ((dataIn&DHCSR_C_DEBUGEN) == 0) {
          print("SWD_Connect() Debug enable failed\n");
          // May indicate the device is secured
@@ -340,47 +284,35 @@ USBDM_ErrorCode SWD_GetStatus(ArmStatus *status) {
    //ToDo - Consider Kinetis specific MDM_AP_Status
    *status = defaultStatus;
 
+   // Read MDM-AP status and DHCSR as one batch
+   SwdBatch batch;
+   uint32_t mdmStatus = 0;
    if (debugInformation.MDM_AP_present) {
       // Freesale MDM-AP present
-      unsigned long mdmStatus;
-      rc = USBDM_ReadCReg(ARM_CRegMDM_AP_Status, &mdmStatus);
-      if (rc != BDM_RC_OK) {
-         print("   SWD_GetStatus() Can't read MDM_AP_Status!\n");
-         return BDM_RC_BDM_EN_FAILED;
-      }
-      status->mdmApStatus = mdmStatus;
-   }
-
-   //      *status = (dataIn&MDM_AP_Status_Core_Halted) != 0;
-   //      print("   SWD_GetStatus() => MDM_AP_Status=0x%08X (%s)\n",
-   //            dataIn,
-   //            (*status)?"Halted":"Running");
-   //      return BDM_RC_OK;
-   //   }
-   //   else {
-   rc = armReadMemoryWord(DEMCR, &dataIn);
-   if (rc != BDM_RC_OK) {
-      print("   SWD_GetStatus() Can't read DEMCR!\n");
-   }
-   else {
-      print("   SWD_GetStatus(): DEMCR status=%s(0x%08X)\n", getDEMCRName(dataIn), dataIn);
+      batch.apRead(ARM_CRegMDM_AP_Status, &mdmStatus);
    }
+#ifdef LOG
+   // DEMCR is only of interest for logging
+   uint32_t demcrValue = 0;
+   batch.memRead(DEMCR, &demcrValue);
+#endif
    // Generic Debug
-   rc = armReadMemoryWord(DHCSR, &dataIn);
+   batch.memRead(DHCSR, &dataIn);
+   rc = batch.flush();
    if (rc != BDM_RC_OK) {
-      print("   SWD_GetStatus() Can't read DHCSR!\n");
+      print("   SWD_GetStatus() Can't read MDM_AP_Status/DHCSR!\n");
       return BDM_RC_BDM_EN_FAILED;
    }
-   //      print("   SWD_GetStatus() DHCSR value = 0x%08X\n", dataIn);
-   //      if ((dataIn&DHCSR_C_DEBUGEN) == 0) {
-   //         print("   SWD_Initialise() Debug enable not set!\n");
-   //         return BDM_RC_BDM_EN_FAILED;
-   //      }
+   status->mdmApStatus = mdmStatus;
+#ifdef LOG
+   print("   SWD_GetStatus(): DEMCR status=%s(0x%08X)\n", getDEMCRName(demcrValue), demcrValue);
+#endif
    if ((dataIn&DHCSR_S_LOCKUP) != 0) {
       const uint32_t dataOut = DHCSR_DBGKEY|DHCSR_C_HALT|DHCSR_C_DEBUGEN;
       print("   SWD_GetStatus() Clearing Lockup, DHCSR status=%s(0x%08X)\n", getDHCSRName(dataIn), dataIn);
-      armWriteMemoryWord(DHCSR, &dataOut);
-      rc = armReadMemoryWord(DHCSR, &dataIn);
+      batch.memWrite(DHCSR, dataOut);
+      batch.memRead(DHCSR, &dataIn);
+      rc = batch.flush();
       if (rc != BDM_RC_OK) {
          print("   SWD_GetStatus() Can't read DHCSR!\n");
          return BDM_RC_BDM_EN_FAILED;
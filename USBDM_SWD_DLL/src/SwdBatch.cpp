@@ -0,0 +1,217 @@
+/*! \file
+    \brief Batched SWD transactions
+
+    \verbatim
+    Copyright (C) 2026  agent
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+    Change History
++==================================================================================
+| 19 Oct 2026 | Created
++==================================================================================
+\endverbatim
+*/
+#include "Common.h"
+#include "Utils.h"
+#include "Log.h"
+#ifdef DLL
+#undef DLL
+#endif
+#include "USBDM_API.h"
+#define DLL
+#include "ARM_Definitions.h"
+#include "SwdBatch.h"
+
+// DP ABORT register masks
+#define ABORT_DAPABORT     (1<<0)
+#define ABORT_STKCMPCLR    (1<<1)
+#define ABORT_STKERRCLR    (1<<2)
+#define ABORT_WDERRCLR     (1<<3)
+#define ABORT_ORUNERRCLR   (1<<4)
+
+//! Maximum number of words combined into a single memory transfer
+//! Transfers are also broken on ARM_PAGE_SIZE boundary as TAR may not increment across this boundary
+#define MAX_MEMORY_RUN     (ARM_PAGE_SIZE/4)
+
+SwdBatch::SwdBatch(unsigned waitRetries, bool checkSticky) :
+   waitRetries(waitRetries),
+   checkSticky(checkSticky),
+   usbTransactionCount(0) {
+   queue.reserve(16);
+}
+
+void SwdBatch::dpRead(unsigned regNo, uint32_t *value) {
+   Transaction t = {DP_READ, regNo, 0, value};
+   queue.push_back(t);
+}
+
+void SwdBatch::dpWrite(unsigned regNo, uint32_t value) {
+   Transaction t = {DP_WRITE, regNo, value, NULL};
+   queue.push_back(t);
+}
+
+void SwdBatch::apRead(uint32_t apRegAddress, uint32_t *value) {
+   Transaction t = {AP_READ, apRegAddress, 0, value};
+   queue.push_back(t);
+}
+
+void SwdBatch::apWrite(uint32_t apRegAddress, uint32_t value) {
+   Transaction t = {AP_WRITE, apRegAddress, value, NULL};
+   queue.push_back(t);
+}
+
+void SwdBatch::memRead(uint32_t address, uint32_t *value) {
+   Transaction t = {MEM_READ, address, 0, value};
+   queue.push_back(t);
+}
+
+void SwdBatch::memRead(uint32_t address, unsigned count, uint32_t values[]) {
+   for (unsigned index=0; index<count; index++) {
+      memRead(address+4*index, values+index);
+   }
+}
+
+void SwdBatch::memWrite(uint32_t address, uint32_t value) {
+   Transaction t = {MEM_WRITE, address, value, NULL};
+   queue.push_back(t);
+}
+
+//! Execute a single (possibly combined) transaction with WAIT retry
+//!
+//! @param transaction - First transaction of the run
+//! @param count       - Number of words in run (memory transactions only)
+//! @param buffer      - Buffer for memory data (LE-32 words)
+//!
+USBDM_ErrorCode SwdBatch::retry(const Transaction &transaction, unsigned count, uint8_t *buffer) {
+   USBDM_ErrorCode rc;
+   unsigned long   value;
+   unsigned        retriesLeft = waitRetries;
+   do {
+      usbTransactionCount++;
+      switch (transaction.op) {
+      case DP_READ:
+         rc = USBDM_ReadDReg(transaction.address, &value);
+         if ((rc == BDM_RC_OK) && (transaction.result != NULL)) {
+            *transaction.result = (uint32_t)value;
+         }
+         break;
+      case DP_WRITE:
+         rc = USBDM_WriteDReg(transaction.address, transaction.value);
+         break;
+      case AP_READ:
+         rc = USBDM_ReadCReg(transaction.address, &value);
+         if ((rc == BDM_RC_OK) && (transaction.result != NULL)) {
+            *transaction.result = (uint32_t)value;
+         }
+         break;
+      case AP_WRITE:
+         rc = USBDM_WriteCReg(transaction.address, transaction.value);
+         break;
+      case MEM_READ:
+         rc = USBDM_ReadMemory(4, 4*count, transaction.address, buffer);
+         break;
+      case MEM_WRITE:
+         rc = USBDM_WriteMemory(4, 4*count, transaction.address, buffer);
+         break;
+      default:
+         return BDM_RC_ILLEGAL_PARAMS;
+      }
+      // ACK_TIMEOUT/TARGET_BUSY indicate the BDM exhausted its own WAIT retries
+      if ((rc != BDM_RC_ACK_TIMEOUT) && (rc != BDM_RC_TARGET_BUSY)) {
+         break;
+      }
+      print("   SwdBatch::retry() - WAIT response, retrying (%d left)\n", retriesLeft);
+      milliSleep(1);
+   } while (retriesLeft-- > 0);
+   return rc;
+}
+
+//! Check DP sticky flags and clear them if set
+//!
+USBDM_ErrorCode SwdBatch::checkAndClearSticky(void) {
+   unsigned long status;
+   usbTransactionCount++;
+   USBDM_ErrorCode rc = USBDM_ReadDReg(SWD_DRegSTATUS, &status);
+   if (rc != BDM_RC_OK) {
+      return rc;
+   }
+   if ((status & (STICKYERR|STICKYCMP|STICKYORUN)) == 0) {
+      return BDM_RC_OK;
+   }
+   print("   SwdBatch::checkAndClearSticky() - Sticky error, DP_STAT => 0x%08X\n", status);
+   usbTransactionCount++;
+   USBDM_WriteDReg(SWD_DRegABORT, ABORT_STKERRCLR|ABORT_STKCMPCLR|ABORT_WDERRCLR|ABORT_ORUNERRCLR);
+   return BDM_RC_ARM_ACCESS_ERROR;
+}
+
+USBDM_ErrorCode SwdBatch::flush(void) {
+   USBDM_ErrorCode rc = BDM_RC_OK;
+   uint8_t         buffer[4*MAX_MEMORY_RUN];
+
+   usbTransactionCount = 0;
+   if (queue.empty()) {
+      return BDM_RC_OK;
+   }
+   std::vector<Transaction>::size_type index = 0;
+   while ((rc == BDM_RC_OK) && (index < queue.size())) {
+      const Transaction &first = queue[index];
+      unsigned count = 1;
+      if ((first.op == MEM_READ) || (first.op == MEM_WRITE)) {
+         // Combine consecutive accesses within the same page
+         while (((index+count) < queue.size()) &&
+                (count < MAX_MEMORY_RUN) &&
+                (queue[index+count].op == first.op) &&
+                (queue[index+count].address == first.address+4*count) &&
+                (((first.address+4*count)&(ARM_PAGE_SIZE-1)) != 0)) {
+            count++;
+         }
+      }
+      if (first.op == MEM_WRITE) {
+         for (unsigned sub=0; sub<count; sub++) {
+            uint32_t value = queue[index+sub].value;
+            buffer[4*sub+0] = (uint8_t)value;
+            buffer[4*sub+1] = (uint8_t)(value>>8);
+            buffer[4*sub+2] = (uint8_t)(value>>16);
+            buffer[4*sub+3] = (uint8_t)(value>>24);
+         }
+      }
+      rc = retry(first, count, buffer);
+      if ((rc == BDM_RC_OK) && (first.op == MEM_READ)) {
+         for (unsigned sub=0; sub<count; sub++) {
+            uint32_t *result = queue[index+sub].result;
+            if (result != NULL) {
+               *result = (buffer[4*sub+0])+(buffer[4*sub+1]<<8)+(buffer[4*sub+2]<<16)+(buffer[4*sub+3]<<24);
+            }
+         }
+      }
+      index += count;
+   }
+   unsigned numQueued = (unsigned)queue.size();
+   queue.clear();
+   if (rc == BDM_RC_ARM_FAULT_ERROR) {
+      // FAULT response => sticky flags are set and must be cleared before further accesses
+      checkAndClearSticky();
+   }
+   else if (checkSticky) {
+      USBDM_ErrorCode stickyRc = checkAndClearSticky();
+      if (rc == BDM_RC_OK) {
+         rc = stickyRc;
+      }
+   }
+   print("   SwdBatch::flush() - %d transactions => %d USB commands, rc = %s\n",
+         numQueued, usbTransactionCount, USBDM_GetErrorString(rc));
+   return rc;
+}
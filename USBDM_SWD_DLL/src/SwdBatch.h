@@ -0,0 +1,92 @@
+/*
+ * SwdBatch.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: agent
+ */
+
+#ifndef SWDBATCH_H_
+#define SWDBATCH_H_
+
+#include <vector>
+#include "Common.h"
+#include "USBDM_API.h"
+
+//! Batch of queued SWD DP/AP/memory transactions
+//!
+//! Accesses are queued by the caller and then executed together by flush().
+//! On flush:
+//!   - Runs of word accesses to consecutive memory addresses are combined into a
+//!     single USBDM_ReadMemory()/USBDM_WriteMemory() i.e. one USB command.
+//!   - Transactions that fail with a WAIT-type response are retried.
+//!   - If an access receives a FAULT response the DP sticky error flags are
+//!     cleared through the DP ABORT register and the flush is abandoned.
+//!   - Optionally, the DP sticky error flags are also checked once at the end of
+//!     the batch (this costs an additional USB command).
+//!
+//! Results of queued reads are only valid after a successful flush().
+//!
+class SwdBatch {
+public:
+   //! Transaction types that may be queued
+   enum OpType {
+      DP_READ,       //!< Read SWD-DP register      (USBDM_ReadDReg)
+      DP_WRITE,      //!< Write SWD-DP register     (USBDM_WriteDReg)
+      AP_READ,       //!< Read AP register          (USBDM_ReadCReg)
+      AP_WRITE,      //!< Write AP register         (USBDM_WriteCReg)
+      MEM_READ,      //!< Read memory word via AHB-AP
+      MEM_WRITE,     //!< Write memory word via AHB-AP
+   };
+
+private:
+   struct Transaction {
+      OpType     op;
+      uint32_t   address;  //!< DP register #, AP bus address or memory address
+      uint32_t   value;    //!< Value to write
+      uint32_t  *result;   //!< Where to place value read (may be NULL)
+   };
+   std::vector<Transaction> queue;
+   unsigned                 waitRetries;
+   bool                     checkSticky;
+   unsigned                 usbTransactionCount;
+
+   USBDM_ErrorCode retry(const Transaction &transaction, unsigned count, uint8_t *buffer);
+   USBDM_ErrorCode checkAndClearSticky(void);
+
+public:
+   //! Create empty batch
+   //!
+   //! @param waitRetries  - Number of times a transaction is re-tried on WAIT response
+   //! @param checkSticky  - Always check (and clear) DP sticky error flags at end of flush
+   //!                       Otherwise they are only checked after a FAULT response
+   //!
+   SwdBatch(unsigned waitRetries=5, bool checkSticky=false);
+
+   void dpRead(unsigned regNo, uint32_t *value);
+   void dpWrite(unsigned regNo, uint32_t value);
+   void apRead(uint32_t apRegAddress, uint32_t *value);
+   void apWrite(uint32_t apRegAddress, uint32_t value);
+   void memRead(uint32_t address, uint32_t *value);
+   void memRead(uint32_t address, unsigned count, uint32_t values[]);
+   void memWrite(uint32_t address, uint32_t value);
+
+   //! Execute all queued transactions
+   //!
+   //! @return error code \n
+   //!    BDM_RC_OK               => all transactions completed \n
+   //!    BDM_RC_ARM_ACCESS_ERROR => a sticky error was flagged by the DP (checkSticky only) \n
+   //!    other                   => error from failing transaction
+   //!
+   //! @note The queue is always empty on return
+   //!
+   USBDM_ErrorCode flush(void);
+
+   //! Discard queued transactions
+   void clear(void)                          { queue.clear(); }
+   //! Number of queued transactions
+   unsigned size(void) const                 { return (unsigned)queue.size(); }
+   //! Number of USB commands issued by last flush()
+   unsigned getUsbTransactionCount(void) const { return usbTransactionCount; }
+};
+
+#endif /* SWDBATCH_H_ */
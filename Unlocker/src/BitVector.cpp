@@ -35,6 +35,22 @@ const bitVector bitVector::zeroVector;
 
 const uint8_t bitVector::bitMasks[] = {0xFF, 0x01, 0x03, 0x07, 0x0F, 0x1F, 0x3F, 0x7F};
 
+//! Mask for the lower numBits of a word (numBits = 1..64)
+#define WORD_MASK(numBits) ((numBits)>=64?~(uint64_t)0:((((uint64_t)1)<<(numBits))-1))
+
+//! \brief Fills the storage
+//!
+//! @param wordValue => value for each word
+//! @param byteValue => value for each byte in the byte image
+//!
+void bitVector::fill(uint64_t wordValue, uint8_t byteValue) {
+   for (unsigned int index=0; index < maxWords; index++)
+      words[index] = wordValue;
+   for (unsigned int index=0; index < sizeof(data)/sizeof(data[0]); index++)
+      data[index] = byteValue;
+   dataInUse = false;
+}
+
 //! \brief Create a zero-filled vector
 //!
 //! @param width => width in bits of required vector
@@ -42,8 +58,7 @@ const uint8_t bitVector::bitMasks[] = {0xFF, 0x01, 0x03, 0x07, 0x0F, 0x1F, 0x3F,
 bitVector::bitVector(unsigned int width) {
    if (width>maxVectorLength)
       width = maxVectorLength;
-   for (unsigned int index=0; index < sizeof(data)/sizeof(data[0]); index++)
-      data[index] = 0;
+   fill(0, 0);
    this->length = width;
 }
 
@@ -57,11 +72,14 @@ bitVector::bitVector(unsigned int width, uint8_t initData[]) {
    unsigned int index;
    if (width>maxVectorLength)
       width = maxVectorLength;
+   fill(0, 0);
+   this->length = width;
+   if (width == 0)
+      return;
    for (index=0; index <= (width-1)/8; index++)
       data[index] = initData[index];
-   for (;index < sizeof(data)/sizeof(data[0]); index++)
-      data[index] = 0;
-   this->length = width;
+   dataInUse = true;
+   syncWords();
 }
 
 //! \brief Create a vector with all bits initialised to a value
@@ -70,48 +88,135 @@ bitVector::bitVector(unsigned int width, uint8_t initData[]) {
 //! @param initData => value to initialise vector bits (0 or 1)
 //!
 bitVector::bitVector(unsigned int width, int initData) {
-   unsigned int index;
-   uint8_t initValue = (initData?0xFF:0x00);
-
    if (width>maxVectorLength)
       width = maxVectorLength;
-
-   for (index=0; index < sizeof(data)/sizeof(data[0]); index++)
-      data[index] = initValue;
+   if (initData)
+      fill(~(uint64_t)0, 0xFF);
+   else
+      fill(0, 0);
    this->length = width;
 }
 
+//! \brief Updates the words from the byte image if it has been handed out by getArray()
+//!
+void bitVector::syncWords(void) {
+   if (!dataInUse)
+      return;
+   dataInUse = false;
+   if (length == 0)
+      return;
+   unsigned int numBytes = (length-1)/8+1;
+   for (unsigned int index=0; index < maxWords; index++)
+      words[index] = 0;
+   // Last byte holds bits 0-7
+   for (unsigned int byteNum=0; byteNum < numBytes; byteNum++)
+      words[byteNum/8] |= ((uint64_t)data[numBytes-1-byteNum])<<(8*(byteNum%8));
+   words[(length-1)/64] &= WORD_MASK((length-1)%64+1);
+}
+
+//! \brief Returns the internal char array used to transfer the vector
+//!
+//! @note - The vector is left-justified in the array but the bits are
+//!         right-justified in the bytes i.e. all but the first byte will
+//!         be 8-bits.  The 1st byte may have leading zeroes that are not
+//!         part of the vector.
+//! @note - The array may be modified (e.g. by USBDM_JTAG_Read()) until the
+//!         next operation on the vector.
+//!
+unsigned char *bitVector::getArray(void) {
+   if (!dataInUse && (length > 0)) {
+      unsigned int numBytes = (length-1)/8+1;
+      for (unsigned int byteNum=0; byteNum < numBytes; byteNum++)
+         data[numBytes-1-byteNum] = (unsigned char)(words[byteNum/8]>>(8*(byteNum%8)));
+   }
+   dataInUse = true;
+   return data;
+}
+
+//! \brief Returns a field of up to 64 bits from the vector
+//!
+//! @param start   => bit num for start of field
+//! @param numBits => length of field (1-64)
+//!
+//! @note - bits outside the vector are returned as 0
+//!
+uint64_t bitVector::getField(unsigned int start, unsigned int numBits) {
+   syncWords();
+   if ((numBits == 0) || (start >= length))
+      return 0;
+   if (numBits > 64)
+      numBits = 64;
+   if (numBits > length-start)
+      numBits = length-start;
+   unsigned int wordNum = start/64;
+   unsigned int shift   = start%64;
+   uint64_t value = words[wordNum]>>shift;
+   if ((shift != 0) && (shift+numBits > 64))
+      value |= words[wordNum+1]<<(64-shift);
+   return value & WORD_MASK(numBits);
+}
+
+//! \brief Sets a field of up to 64 bits in the vector
+//!
+//! @param start   => bit num for start of field
+//! @param numBits => length of field (1-64)
+//! @param value   => value for field
+//!
+//! @note - bits outside the vector are discarded
+//!
+void bitVector::setField(unsigned int start, unsigned int numBits, uint64_t value) {
+   syncWords();
+   if ((numBits == 0) || (start >= length))
+      return;
+   if (numBits > 64)
+      numBits = 64;
+   if (numBits > length-start)
+      numBits = length-start;
+   unsigned int wordNum = start/64;
+   unsigned int shift   = start%64;
+   uint64_t     mask    = WORD_MASK(numBits);
+   value &= mask;
+   words[wordNum] = (words[wordNum] & ~(mask<<shift)) | (value<<shift);
+   if ((shift != 0) && (shift+numBits > 64))
+      words[wordNum+1] = (words[wordNum+1] & ~(mask>>(64-shift))) | (value>>(64-shift));
+}
+
 //! \brief Extracts a field (vector) from a vector
 //!
 //! @param start   => bit num for start of field
 //! @param numBits => length of field
+//! @param dest    => vector to hold field
 //!
-bitVector bitVector::extractField(unsigned int start, unsigned int numBits) {
-
-   if (numBits == 0) {
-//      fprintf(stderr, "extractField(): empty field\n");
-      return zeroVector;
+void bitVector::extractField(unsigned int start, unsigned int numBits, bitVector &dest) {
+   if (&dest == this) {
+      bitVector temp;
+      extractField(start, numBits, temp);
+      dest = temp;
+      return;
    }
    if (numBits>maxVectorLength)
       numBits = maxVectorLength;
+   dest.fill(0, 0);
+   dest.length = numBits;
+   for (unsigned int bitNum = 0; bitNum < numBits; bitNum += 64) {
+      dest.words[bitNum/64] = getField(start+bitNum, numBits-bitNum);
+   }
+}
 
-   // create destination vector to return
-   bitVector *dest = new bitVector(numBits);
-   unsigned bitOffset = start%8; // offset to shift source bits right
-   unsigned int value;
-   unsigned int bitCount;
-   unsigned int index;
+//! \brief Extracts a field (vector) from a vector
+//!
+//! @param start   => bit num for start of field
+//! @param numBits => length of field
+//!
+bitVector bitVector::extractField(unsigned int start, unsigned int numBits) {
 
-   for (index = 0, bitCount = 0; bitCount < numBits; index++) {
-      unsigned int reverseIndex = (this->length-1)/8 -(start/8)-index;
-      value = data[reverseIndex];
-      if (reverseIndex>0)
-         value += 256*data[reverseIndex-1];
-      value = value>>bitOffset;
-      dest->data[(numBits-1)/8-index] = (unsigned char)value;
-      bitCount += 8;
+   if (numBits == 0) {
+//      fprintf(stderr, "extractField(): empty field\n");
+      return zeroVector;
    }
-   return *dest;
+   bitVector dest;
+   extractField(start, numBits, dest);
+   return dest;
 }
 
 //! \brief Inserts a field (vector) into a vector
@@ -122,32 +227,10 @@ bitVector bitVector::extractField(unsigned int start, unsigned int numBits) {
 //! @note - bits or overwritten rather than a true insertion
 //!
 void bitVector::insertField(bitVector &value, unsigned int start) {
-#if 0
-   unsigned int numBits = value.length;
-
-   if (numBits == 0) {
-      fprintf(stderr, "insertField(): empty field\n");
-      return;
+   value.syncWords();
+   for (unsigned int bitNum = 0; bitNum < value.length; bitNum += 64) {
+      setField(start+bitNum, value.length-bitNum, value.words[bitNum/64]);
    }
-
-   // create destination vector to return
-   bitVector *dest = new bitVector(numBits);
-
-   unsigned bitOffset = start%8; // offset to shift source bits right
-//   unsigned int value;
-   unsigned int bitCount;
-   unsigned int index;
-
-   for (index = 0, bitCount = 0; bitCount < numBits; index++) {
-      unsigned int reverseIndex = (this->length-1)/8 -(start/8)-index;
-      value = data[reverseIndex];
-      if (reverseIndex>0)
-         value += 256*data[reverseIndex-1];
-      value = value>>bitOffset;
-      dest->data[(numBits-1)/8-index] = (unsigned char)value;
-      bitCount += 8;
-   }
-#endif
 }
 
 //! \brief Provides a string representing the contents of the bitVector
@@ -158,12 +241,16 @@ void bitVector::insertField(bitVector &value, unsigned int start) {
 char *bitVector::toHexString(void) {
    static char s[4+maxVectorLength/4];
    unsigned int index;
-   unsigned char mask = bitMasks[length%8];
+   unsigned int numBytes = (length+7)/8;
 
-   sprintf(s, "%2X", data[0]&mask);
+   if (length == 0) {
+      sprintf(s, "%2X", 0);
+      return s;
+   }
+   sprintf(s, "%2X", (unsigned int)getField(8*(numBytes-1), 8) & bitMasks[length%8]);
 
-   for (index=1; index <= (length-1)/8; index++) {
-      sprintf(&s[2*index], "%2.2X", data[index]);
+   for (index=1; index < numBytes; index++) {
+      sprintf(&s[2*index], "%2.2X", (unsigned int)getField(8*(numBytes-1-index), 8));
    }
    return s;
 }
@@ -175,17 +262,11 @@ char *bitVector::toHexString(void) {
 //!
 char *bitVector::toBinString(void) {
    static char s[4+maxVectorLength];
-   unsigned int index;
-   unsigned char mask = 1<<((length-1)%8);
-
    char *sp = s;
 
-   for (index=0; 8*index+1 <= length; index++) {
-      while (mask != 0) {
-         *sp++ = (data[index]&mask)?'1':'0';
-         mask >>= 1;
-      }
-      mask = 0x80;
+   syncWords();
+   for (unsigned int bitNum = length; bitNum-- > 0; ) {
+      *sp++ = ((words[bitNum/64]>>(bitNum%64))&0x01)?'1':'0';
    }
    *sp++='\0';
 
@@ -199,13 +280,6 @@ char *bitVector::toBinString(void) {
 uint8_t bitVector::operator[](unsigned int bitNum) {
    if (bitNum>=length)
       return 0;
-   unsigned char mask = 1<<(bitNum%8);
-   unsigned int index = (length-1)/8 - bitNum/8;
-
-   //fprintf(stderr, "m=%x, indx=%d\n", mask, index);
-
-   if (bitNum >= length)
-      return 0;
-
-   return (data[index]&mask)?1:0;
+   syncWords();
+   return (uint8_t)((words[bitNum/64]>>(bitNum%64))&0x01);
 }
@@ -11,13 +11,22 @@
 //
 //! \brief A basic bit-vector class
 //!
+//! The vector is held as an array of 64-bit words (bit n => words[n/64], bit n%64).
+//! A byte image in the format used by USBDM_JTAG_Read() etc. is provided by getArray().
+//!
 class bitVector {
 private:
+   static const unsigned int maxVectorLength = 1000;  //!< Maximum length of a vector in bits
+   static const unsigned int maxWords = (maxVectorLength+63)/64;
    unsigned int length;                      //!< Length of the vector in bits
    static const bitVector zeroVector;        //!< A zero length vector
-   static const uint8_t bitMasks[];               //!< Bits masks for clipping odd bytes
-   static const unsigned int maxVectorLength = 1000;  //!< Maximum length of a vector in bits
-   unsigned char data[maxVectorLength/8];    //!< Storage for the vector
+   static const uint8_t bitMasks[];          //!< Bits masks for clipping odd bytes
+   uint64_t      words[maxWords];            //!< Storage for the vector
+   unsigned char data[maxVectorLength/8];    //!< Byte image of the vector (see getArray())
+   bool          dataInUse;                  //!< data[] has been handed out and may have been modified
+
+   void syncWords(void);
+   void fill(uint64_t wordValue, uint8_t byteValue);
 
 public:
    bitVector(unsigned int width=0);
@@ -25,22 +34,16 @@ public:
    bitVector(unsigned int width, int initValue);
    void insertField(bitVector &value, unsigned int start);
    bitVector extractField(unsigned int start, unsigned int numBits);
+   void extractField(unsigned int start, unsigned int numBits, bitVector &dest);
+   uint64_t getField(unsigned int start, unsigned int numBits);
+   void setField(unsigned int start, unsigned int numBits, uint64_t value);
 
    //! Returns the length of the vector in bits
    unsigned int  getLength(void) const {
       return length;
    }
 
-   //! Returns the internal char array used to store the vector
-   //!
-   //! @note - The vector is left-justified in the array but the bits are
-   //!         right-justified in the bytes i.e. all but the first byte will
-   //!         be 8-bits.  The 1st byte may have leading zeroes that are not
-   //!         part of the vector.
-   //!
-   unsigned char *getArray(void) {
-      return data;
-   }
+   unsigned char *getArray(void);
 
    char *toHexString(void);
    char *toBinString(void);
@@ -0,0 +1,763 @@
+/*
+ * BoundaryScan.cpp
+ *
+ *  Created on: 19/10/2026
+ *      Author: agent
+ */
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "Log.h"
+#include "Common.h"
+#include "USBDM_API.h"
+#include "BitVector.h"
+#include "KnownDevices.h"
+#include "JTAGSequence.h"
+#include "JTAG.h"
+#include "BoundaryScan.h"
+
+std::vector<BoundaryScanDevice> BoundaryScan::devices;  //!< Cell maps for devices in chain
+std::vector<BoundaryScanNet>    BoundaryScan::nets;     //!< Nets connecting device pins
+unsigned int                    BoundaryScan::drLength; //!< Length of chain DR in EXTEST/SAMPLE
+
+//! Maximum number of bits in a single JTAG_SHIFT_..._DP operation (multiple of 8)
+#define MAX_SHIFT_BITS (248)
+
+//! A JTAG sequence being assembled for USBDM_JTAG_ExecuteSequence()
+//!
+//! Commands and output data are accumulated separately and combined by flush().
+//! Scans are added until the BDM buffers are full and the sequence is then executed.
+//! Data read by a scan is unpacked into the bitVector given to scan() by flush().
+//!
+class ScanBatch {
+private:
+   struct ReadBack {
+      bitVector    *dest;    //!< Vector to receive data
+      unsigned int  start;   //!< Start bit in vector
+      unsigned int  numBits; //!< Number of bits
+   };
+   uint8_t      commands[256];
+   uint8_t      dataOut[256];
+   ReadBack     reads[256];
+   unsigned int commandLength;
+   unsigned int dataOutLength;
+   unsigned int dataInLength;
+   unsigned int numReads;
+   unsigned int maxSequenceLength;
+   unsigned int maxDataInLength;
+   unsigned int transactions;
+
+   bool fits(unsigned int numCommands, unsigned int numOut, unsigned int numIn) {
+      return (commandLength+numCommands+1+dataOutLength+numOut <= maxSequenceLength) &&
+             (dataInLength+numIn <= maxDataInLength);
+   }
+   bool add(uint8_t moveCommand, uint8_t shiftCommand, bitVector *out, bitVector *in);
+
+public:
+   ScanBatch() :
+      commandLength(0), dataOutLength(0), dataInLength(0), numReads(0),
+      maxSequenceLength(0), maxDataInLength(0), transactions(0) {
+   }
+   USBDM_ErrorCode open(void);
+   USBDM_ErrorCode scan(uint8_t moveCommand, uint8_t shiftCommand, bitVector *out, bitVector *in);
+   USBDM_ErrorCode command(uint8_t command);
+   USBDM_ErrorCode flush(void);
+
+   //! Returns the number of BDM transactions used
+   unsigned int getTransactions(void) {
+      return transactions;
+   }
+};
+
+//! Obtains the buffer sizes from the BDM
+//!
+USBDM_ErrorCode ScanBatch::open(void) {
+   USBDM_bdmInformation_t bdmInfo = {sizeof(USBDM_bdmInformation_t), 0};
+
+   USBDM_ErrorCode rc = USBDM_GetBdmInformation(&bdmInfo);
+   if (rc != BDM_RC_OK) {
+      return rc;
+   }
+   maxSequenceLength = (bdmInfo.jtagBufferSize>255)?255:bdmInfo.jtagBufferSize;
+   maxDataInLength   = (bdmInfo.commandBufferSize>256)?255:bdmInfo.commandBufferSize-1;
+   commandLength     = 0;
+   dataOutLength     = 0;
+   dataInLength      = 0;
+   numReads          = 0;
+   transactions      = 0;
+   return BDM_RC_OK;
+}
+
+//! Adds a scan to the sequence if there is room
+//!
+//! @param moveCommand  : JTAG_MOVE_DR_SCAN or JTAG_MOVE_IR_SCAN
+//! @param shiftCommand : JTAG_SHIFT_OUT_DP, JTAG_SHIFT_IN_DP or JTAG_SHIFT_IN_OUT_DP
+//! @param out          : Data to shift out (NULL for JTAG_SHIFT_IN_DP)
+//! @param in           : Vector to receive data shifted in (NULL for JTAG_SHIFT_OUT_DP)
+//!
+//! @return false => insufficient room
+//!
+bool ScanBatch::add(uint8_t moveCommand, uint8_t shiftCommand, bitVector *out, bitVector *in) {
+   unsigned int numBits   = (out != NULL)?out->getLength():in->getLength();
+   unsigned int numChunks = (numBits+MAX_SHIFT_BITS-1)/MAX_SHIFT_BITS;
+   unsigned int numBytes  = BITS_TO_BYTES(numBits%MAX_SHIFT_BITS)+(numBits/MAX_SHIFT_BITS)*(MAX_SHIFT_BITS/8);
+
+   if (!fits(1+2*numChunks+((numChunks>1)?2:1),
+             (out != NULL)?numBytes:0,
+             (in  != NULL)?numBytes:0) ||
+       (numReads+numChunks > sizeof(reads)/sizeof(reads[0]))) {
+      return false;
+   }
+   commands[commandLength++] = moveCommand;
+   if (numChunks > 1) {
+      commands[commandLength++] = JTAG_SET_STAY_SHIFT;
+   }
+   bitVector chunk;
+   for (unsigned int start=0; start<numBits; start += MAX_SHIFT_BITS) {
+      unsigned int chunkBits = numBits-start;
+      if (chunkBits > MAX_SHIFT_BITS) {
+         chunkBits = MAX_SHIFT_BITS;
+      }
+      else {
+         commands[commandLength++] = JTAG_SET_EXIT_IDLE;
+      }
+      commands[commandLength++] = shiftCommand;
+      commands[commandLength++] = (uint8_t)chunkBits;
+      if (out != NULL) {
+         out->extractField(start, chunkBits, chunk);
+         memcpy(dataOut+dataOutLength, chunk.getArray(), BITS_TO_BYTES(chunkBits));
+         dataOutLength += BITS_TO_BYTES(chunkBits);
+      }
+      if (in != NULL) {
+         reads[numReads].dest    = in;
+         reads[numReads].start   = start;
+         reads[numReads].numBits = chunkBits;
+         numReads++;
+         dataInLength += BITS_TO_BYTES(chunkBits);
+      }
+   }
+   return true;
+}
+
+//! Adds a scan to the sequence - the sequence is executed first if it is full
+//!
+//! @param moveCommand  : JTAG_MOVE_DR_SCAN or JTAG_MOVE_IR_SCAN
+//! @param shiftCommand : JTAG_SHIFT_OUT_DP, JTAG_SHIFT_IN_DP or JTAG_SHIFT_IN_OUT_DP
+//! @param out          : Data to shift out (NULL for JTAG_SHIFT_IN_DP)
+//! @param in           : Vector to receive data shifted in (NULL for JTAG_SHIFT_OUT_DP)
+//!
+//! @note in is not valid until flush() has been called
+//!
+USBDM_ErrorCode ScanBatch::scan(uint8_t moveCommand, uint8_t shiftCommand, bitVector *out, bitVector *in) {
+   if (add(moveCommand, shiftCommand, out, in)) {
+      return BDM_RC_OK;
+   }
+   USBDM_ErrorCode rc = flush();
+   if (rc != BDM_RC_OK) {
+      return rc;
+   }
+   if (!add(moveCommand, shiftCommand, out, in)) {
+      print("ScanBatch::scan(): Scan too large for BDM buffers\n");
+      return BDM_RC_ILLEGAL_PARAMS;
+   }
+   return BDM_RC_OK;
+}
+
+//! Adds a single byte command to the sequence - the sequence is executed first if it is full
+//!
+USBDM_ErrorCode ScanBatch::command(uint8_t command) {
+   if (!fits(1, 0, 0)) {
+      USBDM_ErrorCode rc = flush();
+      if (rc != BDM_RC_OK) {
+         return rc;
+      }
+   }
+   commands[commandLength++] = command;
+   return BDM_RC_OK;
+}
+
+//! Executes the accumulated sequence and unpacks any data read
+//!
+USBDM_ErrorCode ScanBatch::flush(void) {
+   uint8_t sequence[256];
+   uint8_t dataIn[256];
+
+   if (commandLength == 0) {
+      return BDM_RC_OK;
+   }
+   memcpy(sequence, commands, commandLength);
+   sequence[commandLength] = JTAG_END;
+   memcpy(sequence+commandLength+1, dataOut, dataOutLength);
+
+   USBDM_ErrorCode rc = USBDM_JTAG_ExecuteSequence(commandLength+1+dataOutLength, sequence, dataInLength, dataIn);
+   transactions++;
+   if (rc != BDM_RC_OK) {
+      print("ScanBatch::flush(): Failed, reason = %s\n", USBDM_GetErrorString(rc));
+   }
+   else {
+      const uint8_t *dp = dataIn;
+      for (unsigned int index=0; index<numReads; index++) {
+         bitVector chunk(reads[index].numBits, (uint8_t *)dp);
+         reads[index].dest->insertField(chunk, reads[index].start);
+         dp += BITS_TO_BYTES(reads[index].numBits);
+      }
+   }
+   commandLength = 0;
+   dataOutLength = 0;
+   dataInLength  = 0;
+   numReads      = 0;
+   return rc;
+}
+
+//! Locates the cell for a port
+//!
+//! @param port  : Port name
+//! @param input : true => cell observing the pin, false => cell driving the pin
+//!
+//! @return cell number or -1 if none
+//!
+int BoundaryScanDevice::findCell(const char *port, bool input) const {
+   for (unsigned int cellNum=0; cellNum<cells.size(); cellNum++) {
+      const BoundaryScanCell &cell = cells[cellNum];
+      if (strcmp(cell.port, port) != 0) {
+         continue;
+      }
+      if ((cell.function == cellBidir) ||
+          ( input && (cell.function == cellInput)) ||
+          (!input && ((cell.function == cellOutput2) || (cell.function == cellOutput3)))) {
+         return cellNum;
+      }
+   }
+   return -1;
+}
+
+//! Locates the cell map for a device in the JTAG chain
+//!
+//! @return index in devices or -1 if none
+//!
+int BoundaryScan::findDevice(unsigned int deviceNum) {
+   for (unsigned int index=0; index<devices.size(); index++) {
+      if (devices[index].deviceNum == deviceNum) {
+         return index;
+      }
+   }
+   return -1;
+}
+
+//! Decodes a net pin of the form <chain #>.<port>
+//!
+bool BoundaryScan::parsePin(const char *pinName, BoundaryScanPin &pin) {
+   unsigned int deviceNum;
+   char         port[20];
+
+   if (sscanf(pinName, "%u.%19s", &deviceNum, port) != 2) {
+      return false;
+   }
+   int deviceIndex = findDevice(deviceNum);
+   if (deviceIndex < 0) {
+      return false;
+   }
+   pin.deviceIndex = deviceIndex;
+   pin.outputCell  = devices[deviceIndex].findCell(port, false);
+   pin.inputCell   = devices[deviceIndex].findCell(port, true);
+   return (pin.outputCell >= 0) || (pin.inputCell >= 0);
+}
+
+//! Cell function names as used in BSDL
+//!
+static const struct {
+   const char           *name;
+   BoundaryCellFunction  function;
+} cellFunctions[] = {
+   {"INPUT",        cellInput},
+   {"CLOCK",        cellInput},
+   {"OBSERVE_ONLY", cellInput},
+   {"OUTPUT2",      cellOutput2},
+   {"OUTPUT3",      cellOutput3},
+   {"CONTROL",      cellControl},
+   {"CONTROLR",     cellControl},
+   {"BIDIR",        cellBidir},
+   {"INTERNAL",     cellInternal},
+};
+
+//! Loads a boundary-scan cell map
+//!
+//! @param fileName : Path to cell map (see \ref BoundaryScan for format)
+//!
+USBDM_ErrorCode BoundaryScan::loadCellMap(const char *fileName) {
+   FILE *fp;
+   char  lineBuff[1000];
+   char  type[20];
+   char *cp;
+   int   lineNo = 0;
+
+   devices.clear();
+   nets.clear();
+
+   fp = fopen(fileName, "rt");
+   if (fp == NULL) {
+      print("BoundaryScan::loadCellMap(): Failed to open %s\n", fileName);
+      return BDM_RC_FAIL;
+   }
+   while (fgets(lineBuff, sizeof(lineBuff), fp) != NULL) {
+      lineNo++;
+      // Remove comments
+      cp = strchr(lineBuff, '#');
+      if (cp != NULL) {
+         *cp = '\0';
+      }
+      if (sscanf(lineBuff, "%19s", type) != 1) {
+         continue;
+      }
+      bool success = false;
+      if (strcmp(type, "device") == 0) {
+         BoundaryScanDevice device;
+         device.drOffset = 0;
+         success = (sscanf(lineBuff, "%*s %u %u %x %x",
+                           &device.deviceNum, &device.boundaryLength,
+                           &device.extestInstruction, &device.sampleInstruction) == 4) &&
+                   (device.boundaryLength > 0) && (device.boundaryLength <= MAX_DR_LENGTH) &&
+                   (findDevice(device.deviceNum) < 0);
+         if (success) {
+            BoundaryScanCell internal = {cellInternal, "*", 0, -1, 0};
+            device.cells.assign(device.boundaryLength, internal);
+            devices.push_back(device);
+         }
+      }
+      else if ((strcmp(type, "cell") == 0) && !devices.empty()) {
+         BoundaryScanDevice &device = devices.back();
+         unsigned int     cellNum;
+         char             function[20];
+         char             safe;
+         BoundaryScanCell cell = {cellInternal, "", 0, -1, 0};
+         int numFields = sscanf(lineBuff, "%*s %u %19s %19s %c %d %d",
+                                &cellNum, function, cell.port, &safe, &cell.controlCell, &cell.disableValue);
+         success = ((numFields == 4) || (numFields == 6)) && (cellNum < device.boundaryLength) &&
+                   (cell.controlCell < (int)device.boundaryLength);
+         for (cp=function; *cp != '\0'; cp++) {
+            *cp = toupper(*cp);
+         }
+         unsigned int index;
+         for (index=0; index<sizeof(cellFunctions)/sizeof(cellFunctions[0]); index++) {
+            if (strcmp(function, cellFunctions[index].name) == 0) {
+               cell.function = cellFunctions[index].function;
+               break;
+            }
+         }
+         success = success && (index<sizeof(cellFunctions)/sizeof(cellFunctions[0]));
+         cell.safeValue = (safe == '1');
+         if (success) {
+            device.cells[cellNum] = cell;
+         }
+      }
+      else if (strcmp(type, "net") == 0) {
+         BoundaryScanNet net;
+         net.driver      = -1;
+         net.code        = 0;
+         net.status      = netUntested;
+         net.shortedWith = -1;
+         cp = strtok(lineBuff, " \t\r\n");
+         cp = strtok(NULL, " \t\r\n");
+         success = (cp != NULL);
+         if (success) {
+            strncpy(net.name, cp, sizeof(net.name)-1);
+            net.name[sizeof(net.name)-1] = '\0';
+         }
+         while (success && ((cp = strtok(NULL, " \t\r\n")) != NULL)) {
+            BoundaryScanPin pin;
+            success = parsePin(cp, pin);
+            net.pins.push_back(pin);
+         }
+         if (success) {
+            nets.push_back(net);
+         }
+      }
+      if (!success) {
+         print("BoundaryScan::loadCellMap(): Illegal line #%d in %s\n", lineNo, fileName);
+         fclose(fp);
+         devices.clear();
+         nets.clear();
+         return BDM_RC_ILLEGAL_PARAMS;
+      }
+   }
+   fclose(fp);
+   print("BoundaryScan::loadCellMap(): %d devices, %d nets\n", (int)devices.size(), (int)nets.size());
+   return BDM_RC_OK;
+}
+
+//! Checks the cell map against the JTAG chain and calculates the layout of the chain DR
+//!
+//! Devices without a cell map are in BYPASS (1 bit)
+//!
+USBDM_ErrorCode BoundaryScan::setupChain(void) {
+   if (devices.empty()) {
+      print("BoundaryScan::setupChain(): No cell map loaded\n");
+      return BDM_RC_ILLEGAL_PARAMS;
+   }
+   drLength = 0;
+   for (unsigned int deviceNum=0; deviceNum<JTAG_Chain::deviceCount; deviceNum++) {
+      int index = findDevice(deviceNum);
+      if (index < 0) {
+         drLength += 1;
+         continue;
+      }
+      unsigned int irLength = JTAG_Chain::devices[deviceNum].irLength;
+      if ((irLength < 32) &&
+          ((devices[index].extestInstruction >= (1UL<<irLength)) ||
+           (devices[index].sampleInstruction >= (1UL<<irLength)))) {
+         print("BoundaryScan::setupChain(): Illegal instruction for device #%d\n", deviceNum);
+         return BDM_RC_ILLEGAL_PARAMS;
+      }
+      devices[index].drOffset  = drLength;
+      drLength                += devices[index].boundaryLength;
+   }
+   for (unsigned int index=0; index<devices.size(); index++) {
+      if (devices[index].deviceNum >= JTAG_Chain::deviceCount) {
+         print("BoundaryScan::setupChain(): Device #%d is not in JTAG chain\n", devices[index].deviceNum);
+         return BDM_RC_ILLEGAL_PARAMS;
+      }
+   }
+   if (drLength > MAX_DR_LENGTH) {
+      print("BoundaryScan::setupChain(): Boundary-scan chain too long (%d bits)\n", drLength);
+      return BDM_RC_ILLEGAL_PARAMS;
+   }
+   return BDM_RC_OK;
+}
+
+//! Constructs the chain IR value for EXTEST or SAMPLE/PRELOAD
+//!
+//! @param ir     : Vector to hold IR value
+//! @param extest : true => EXTEST, false => SAMPLE/PRELOAD
+//!
+void BoundaryScan::getInstruction(bitVector &ir, bool extest) {
+   unsigned int irOffset = 0;
+
+   ir = bitVector(JTAG_Chain::irLength, 1);
+   for (unsigned int deviceNum=0; deviceNum<JTAG_Chain::deviceCount; deviceNum++) {
+      int index = findDevice(deviceNum);
+      if (index >= 0) {
+         ir.setField(irOffset, JTAG_Chain::devices[deviceNum].irLength,
+                     extest?devices[index].extestInstruction:devices[index].sampleInstruction);
+      }
+      irOffset += JTAG_Chain::devices[deviceNum].irLength;
+   }
+}
+
+//! Constructs a chain DR value with all cells at their safe values
+//!
+void BoundaryScan::getSafeVector(bitVector &dr) {
+   dr = bitVector(drLength, 0);
+   for (unsigned int index=0; index<devices.size(); index++) {
+      BoundaryScanDevice &device = devices[index];
+      for (unsigned int cellNum=0; cellNum<device.cells.size(); cellNum++) {
+         dr.setField(device.drOffset+cellNum, 1, device.cells[cellNum].safeValue);
+      }
+   }
+}
+
+//! Captures the device pins using SAMPLE/PRELOAD
+//!
+//! @param numSamples : Number of consecutive samples to take
+//! @param samples    : Chain DR captured for each sample
+//!
+//! @note All samples are taken in as few BDM transactions as possible
+//!
+USBDM_ErrorCode BoundaryScan::sample(unsigned int numSamples, std::vector<bitVector> &samples) {
+   ScanBatch       batch;
+   bitVector       ir;
+   USBDM_ErrorCode rc;
+
+   rc = setupChain();
+   if (rc != BDM_RC_OK) {
+      return rc;
+   }
+   rc = batch.open();
+   if (rc != BDM_RC_OK) {
+      return rc;
+   }
+   getInstruction(ir, false);
+   samples.assign(numSamples, bitVector(drLength, 0));
+
+   rc = batch.scan(JTAG_MOVE_IR_SCAN, JTAG_SHIFT_OUT_DP, &ir, NULL);
+   for (unsigned int sampleNum=0; (rc == BDM_RC_OK) && (sampleNum<numSamples); sampleNum++) {
+      rc = batch.scan(JTAG_MOVE_DR_SCAN, JTAG_SHIFT_IN_DP, NULL, &samples[sampleNum]);
+   }
+   if (rc == BDM_RC_OK) {
+      rc = batch.flush();
+   }
+   if (rc != BDM_RC_OK) {
+      // Sequence may have been partially executed
+      JTAG_Chain::reset();
+   }
+   print("BoundaryScan::sample(): %d samples, %d transactions\n", numSamples, batch.getTransactions());
+   return rc;
+}
+
+//! Applies a series of vectors to the device pins using EXTEST
+//!
+//! @param vectors   : Chain DR values to apply
+//! @param responses : Chain DR captured while each vector is applied
+//!
+//! The first vector is loaded using SAMPLE/PRELOAD before EXTEST is selected so that
+//! the pins are never driven with arbitrary values.  Each following scan applies the next
+//! vector and captures the response to the previous one.  The chain is returned to
+//! TEST-LOGIC-RESET (devices in normal operation) after the safe vector is applied.
+//! The chain is also reset if any scan fails.
+//!
+//! @note All vectors are applied in as few BDM transactions as possible
+//!
+USBDM_ErrorCode BoundaryScan::extest(std::vector<bitVector> &vectors, std::vector<bitVector> &responses) {
+   ScanBatch       batch;
+   bitVector       ir;
+   bitVector       safeVector;
+   USBDM_ErrorCode rc;
+
+   rc = setupChain();
+   if (rc != BDM_RC_OK) {
+      return rc;
+   }
+   rc = batch.open();
+   if (rc != BDM_RC_OK) {
+      return rc;
+   }
+   getSafeVector(safeVector);
+   responses.assign(vectors.size(), bitVector(drLength, 0));
+   if (vectors.empty()) {
+      return BDM_RC_OK;
+   }
+   for (unsigned int vectorNum=0; vectorNum<vectors.size(); vectorNum++) {
+      if (vectors[vectorNum].getLength() != drLength) {
+         print("BoundaryScan::extest(): Vector #%d has incorrect length\n", vectorNum);
+         return BDM_RC_ILLEGAL_PARAMS;
+      }
+   }
+   getInstruction(ir, false);
+   rc = batch.scan(JTAG_MOVE_IR_SCAN, JTAG_SHIFT_OUT_DP, &ir, NULL);
+   if (rc == BDM_RC_OK) {
+      rc = batch.scan(JTAG_MOVE_DR_SCAN, JTAG_SHIFT_OUT_DP, &vectors[0], NULL);
+   }
+   getInstruction(ir, true);
+   if (rc == BDM_RC_OK) {
+      rc = batch.scan(JTAG_MOVE_IR_SCAN, JTAG_SHIFT_OUT_DP, &ir, NULL);
+   }
+   for (unsigned int vectorNum=1; (rc == BDM_RC_OK) && (vectorNum<=vectors.size()); vectorNum++) {
+      bitVector *next = (vectorNum<vectors.size())?&vectors[vectorNum]:&safeVector;
+      rc = batch.scan(JTAG_MOVE_DR_SCAN, JTAG_SHIFT_IN_OUT_DP, next, &responses[vectorNum-1]);
+   }
+   if (rc == BDM_RC_OK) {
+      rc = batch.command(JTAG_TEST_LOGIC_RESET);
+   }
+   if (rc == BDM_RC_OK) {
+      rc = batch.flush();
+   }
+   if (rc != BDM_RC_OK) {
+      // EXTEST may have been selected with arbitrary values on the pins - return devices to normal operation
+      JTAG_Chain::reset();
+   }
+   print("BoundaryScan::extest(): %d vectors, %d transactions\n", (int)vectors.size(), batch.getTransactions());
+   return rc;
+}
+
+//! Selects a driver for each net and assigns a unique code to each testable net
+//!
+//! Codes are a counting sequence excluding all '0's and all '1's so that
+//! stuck pins are not mistaken for a good net.
+//!
+//! @return Number of bits in code (0 => no testable nets)
+//!
+unsigned int BoundaryScan::assignCodes(void) {
+   unsigned int numTestable = 0;
+
+   for (unsigned int netNum=0; netNum<nets.size(); netNum++) {
+      BoundaryScanNet &net = nets[netNum];
+      int numReceivers     = 0;
+      int numFixedDrivers  = 0;
+      net.driver      = -1;
+      net.shortedWith = -1;
+      // 2-state outputs can't be disabled so must be the driver
+      for (unsigned int pinNum=0; pinNum<net.pins.size(); pinNum++) {
+         BoundaryScanPin &pin = net.pins[pinNum];
+         if ((pin.outputCell >= 0) &&
+             (devices[pin.deviceIndex].cells[pin.outputCell].function == cellOutput2)) {
+            numFixedDrivers++;
+            net.driver = pinNum;
+         }
+      }
+      // Otherwise use the first 3-state output that leaves a receiver on the net
+      for (unsigned int pinNum=0; (net.driver < 0) && (pinNum<net.pins.size()); pinNum++) {
+         if (net.pins[pinNum].outputCell < 0) {
+            continue;
+         }
+         for (unsigned int otherPin=0; otherPin<net.pins.size(); otherPin++) {
+            if ((otherPin != pinNum) && (net.pins[otherPin].inputCell >= 0)) {
+               net.driver = pinNum;
+               break;
+            }
+         }
+      }
+      for (unsigned int pinNum=0; pinNum<net.pins.size(); pinNum++) {
+         if (((int)pinNum != net.driver) && (net.pins[pinNum].inputCell >= 0)) {
+            numReceivers++;
+         }
+      }
+      if ((net.driver < 0) || (numReceivers == 0) || (numFixedDrivers > 1)) {
+         net.status = netUntestable;
+         net.driver = -1;
+         continue;
+      }
+      net.status = netUntested;
+      net.code   = ++numTestable;
+   }
+   if (numTestable == 0) {
+      return 0;
+   }
+   unsigned int codeBits = 1;
+   while ((1UL<<codeBits) < numTestable+2) {
+      codeBits++;
+   }
+   return codeBits;
+}
+
+//! Diagnoses nets from the responses to the interconnect test vectors
+//!
+//! @param responses : Responses to true and complement code vectors
+//! @param codeBits  : Number of bits in net codes
+//!
+void BoundaryScan::diagnose(std::vector<bitVector> &responses, unsigned int codeBits) {
+   uint32_t mask = (uint32_t)((1UL<<codeBits)-1);
+
+   for (unsigned int netNum=0; netNum<nets.size(); netNum++) {
+      BoundaryScanNet &net = nets[netNum];
+      if (net.driver < 0) {
+         continue;
+      }
+      net.status = netOk;
+      for (unsigned int pinNum=0; pinNum<net.pins.size(); pinNum++) {
+         BoundaryScanPin &pin = net.pins[pinNum];
+         if (((int)pinNum == net.driver) || (pin.inputCell < 0)) {
+            continue;
+         }
+         unsigned int bitNum     = devices[pin.deviceIndex].drOffset+pin.inputCell;
+         uint32_t     received   = 0;
+         uint32_t     complement = 0;
+         for (unsigned int codeBit=0; codeBit<codeBits; codeBit++) {
+            received   |= (uint32_t)responses[codeBit].getField(bitNum, 1)<<codeBit;
+            complement |= (uint32_t)responses[codeBits+codeBit].getField(bitNum, 1)<<codeBit;
+         }
+         if ((received == net.code) && (complement == (~net.code&mask))) {
+            continue;
+         }
+         // A constant value indicates an open pin rather than a short
+         bool stuck = ((received == 0) && (complement == 0)) || ((received == mask) && (complement == mask));
+         // Look for another net that this pin follows (directly or wired-AND/OR)
+         for (unsigned int otherNum=0; !stuck && (otherNum<nets.size()); otherNum++) {
+            BoundaryScanNet &other = nets[otherNum];
+            if ((otherNum == netNum) || (other.driver < 0)) {
+               continue;
+            }
+            uint32_t wiredAnd = net.code&other.code;
+            uint32_t wiredOr  = net.code|other.code;
+            if (((received == other.code) && (complement == (~other.code&mask))) ||
+                ((received == wiredAnd)   && (complement == (~wiredOr&mask))) ||
+                ((received == wiredOr)    && (complement == (~wiredAnd&mask)))) {
+               net.status      = netShort;
+               net.shortedWith = otherNum;
+               break;
+            }
+         }
+         if (net.status != netShort) {
+            net.status = netOpen;
+         }
+         print("BoundaryScan::diagnose(): Net %s, pin #%d expected %X/%X, received %X/%X\n",
+               net.name, pinNum, net.code, ~net.code&mask, received, complement);
+      }
+   }
+}
+
+//! Boundary-scan interconnect test
+//!
+//! Each testable net is given a unique code that is driven onto the net one bit per vector
+//! as true and complement values.  All vectors are applied by extest() as batched scans.
+//! The values seen by the receivers on each net identify opens and shorts.
+//!
+//! @note Results are available from getNet() and reportResults()
+//!
+USBDM_ErrorCode BoundaryScan::interconnectTest(void) {
+   std::vector<bitVector> vectors;
+   std::vector<bitVector> responses;
+   bitVector              safeVector;
+   USBDM_ErrorCode        rc;
+
+   rc = setupChain();
+   if (rc != BDM_RC_OK) {
+      return rc;
+   }
+   unsigned int codeBits = assignCodes();
+   if (codeBits == 0) {
+      print("BoundaryScan::interconnectTest(): No testable nets\n");
+      return BDM_RC_ILLEGAL_PARAMS;
+   }
+   getSafeVector(safeVector);
+   for (unsigned int vectorNum=0; vectorNum<2*codeBits; vectorNum++) {
+      unsigned int codeBit    = vectorNum%codeBits;
+      unsigned int complement = (vectorNum>=codeBits)?1:0;
+      bitVector    vector(safeVector);
+      for (unsigned int netNum=0; netNum<nets.size(); netNum++) {
+         BoundaryScanNet &net = nets[netNum];
+         if (net.driver < 0) {
+            continue;
+         }
+         BoundaryScanPin        &pin    = net.pins[net.driver];
+         BoundaryScanDevice     &device = devices[pin.deviceIndex];
+         const BoundaryScanCell &cell   = device.cells[pin.outputCell];
+         if (cell.controlCell >= 0) {
+            vector.setField(device.drOffset+cell.controlCell, 1, !cell.disableValue);
+         }
+         vector.setField(device.drOffset+pin.outputCell, 1, ((net.code>>codeBit)&1)^complement);
+      }
+      vectors.push_back(vector);
+   }
+   rc = extest(vectors, responses);
+   if (rc != BDM_RC_OK) {
+      return rc;
+   }
+   diagnose(responses, codeBits);
+   return BDM_RC_OK;
+}
+
+//! Reports the pin values on each net captured by sample()
+//!
+void BoundaryScan::reportSample(bitVector &sample) {
+   for (unsigned int netNum=0; netNum<nets.size(); netNum++) {
+      BoundaryScanNet &net = nets[netNum];
+      print("BoundaryScan::reportSample(): %-20s :", net.name);
+      for (unsigned int pinNum=0; pinNum<net.pins.size(); pinNum++) {
+         BoundaryScanPin &pin = net.pins[pinNum];
+         if (pin.inputCell < 0) {
+            print(" -");
+         }
+         else {
+            print(" %d", (int)sample.getField(devices[pin.deviceIndex].drOffset+pin.inputCell, 1));
+         }
+      }
+      print("\n");
+   }
+}
+
+//! Reports the result of interconnectTest()
+//!
+void BoundaryScan::reportResults(void) {
+   static const char *statusNames[] = {"Untested", "Untestable", "OK", "Open", "Short"};
+
+   for (unsigned int netNum=0; netNum<nets.size(); netNum++) {
+      BoundaryScanNet &net = nets[netNum];
+      if (net.status == netShort) {
+         print("BoundaryScan::reportResults(): %-20s => %s to %s\n",
+               net.name, statusNames[net.status], nets[net.shortedWith].name);
+      }
+      else {
+         print("BoundaryScan::reportResults(): %-20s => %s\n", net.name, statusNames[net.status]);
+      }
+   }
+}
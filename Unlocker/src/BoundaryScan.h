@@ -0,0 +1,129 @@
+/*
+ * BoundaryScan.h
+ *
+ *  Created on: 19/10/2026
+ *      Author: agent
+ */
+
+#ifndef BOUNDARYSCAN_H_
+#define BOUNDARYSCAN_H_
+
+#include <vector>
+#include "USBDM_API.h"
+#include "BitVector.h"
+
+//! Function of a boundary-scan cell (BSDL BOUNDARY_REGISTER function)
+//!
+enum BoundaryCellFunction {
+   cellInput,     //!< INPUT    - observe only
+   cellOutput2,   //!< OUTPUT2  - 2-state output (always driving)
+   cellOutput3,   //!< OUTPUT3  - 3-state output (has control cell)
+   cellControl,   //!< CONTROL  - output enable for other cells
+   cellBidir,     //!< BIDIR    - 3-state output that also observes the pin
+   cellInternal   //!< INTERNAL - not associated with a pin
+};
+
+//! Information about a single boundary-scan cell
+//!
+class BoundaryScanCell {
+public:
+   BoundaryCellFunction function;     //!< Function of cell
+   char                 port[20];     //!< Port (pin) name or "*"
+   int                  safeValue;    //!< Safe value for cell (X => 0)
+   int                  controlCell;  //!< Cell controlling this output (-1 => none)
+   int                  disableValue; //!< Value in controlCell that disables this output
+};
+
+//! Boundary-scan description of a device in the JTAG chain
+//!
+class BoundaryScanDevice {
+public:
+   unsigned int                  deviceNum;         //!< Position in JTAG chain (0 => nearest TDO)
+   unsigned int                  boundaryLength;    //!< Length of boundary register
+   uint32_t                      extestInstruction; //!< EXTEST opcode
+   uint32_t                      sampleInstruction; //!< SAMPLE/PRELOAD opcode
+   std::vector<BoundaryScanCell> cells;             //!< Cells indexed by cell number
+   unsigned int                  drOffset;          //!< Offset of boundary register in chain DR
+
+   int findCell(const char *port, bool input) const;
+};
+
+//! A device pin connected to a net
+//!
+class BoundaryScanPin {
+public:
+   unsigned int deviceIndex;   //!< Index in BoundaryScan::devices
+   int          outputCell;    //!< Cell driving the pin (-1 => none)
+   int          inputCell;     //!< Cell observing the pin (-1 => none)
+};
+
+//! Result of interconnect test for a net
+//!
+enum NetStatus {
+   netUntested,    //!< Net has not been tested
+   netUntestable,  //!< Net has no usable driver or receiver
+   netOk,          //!< All receivers followed the driver
+   netOpen,        //!< A receiver did not follow the driver
+   netShort        //!< A receiver followed another net
+};
+
+//! A net on the board connecting device pins
+//!
+class BoundaryScanNet {
+public:
+   char                         name[40];    //!< Name of net
+   std::vector<BoundaryScanPin> pins;        //!< Pins on net
+   int                          driver;      //!< Index of driving pin (-1 => none)
+   uint32_t                     code;        //!< Code assigned for interconnect test
+   NetStatus                    status;      //!< Result of interconnect test
+   int                          shortedWith; //!< Net shorted to (-1 => none)
+};
+
+//! Boundary-scan (EXTEST/SAMPLE) pin tests on the devices in \ref JTAG_Chain
+//!
+//! The cell map is a text file derived from the BSDL of each device:
+//! \verbatim
+//!  device <chain #> <boundary length> <EXTEST opcode> <SAMPLE opcode>   (opcodes in hex)
+//!  cell   <cell #> <function> <port|*> <safe 0|1|X> [<control cell> <disable value>]
+//!  net    <name> <chain #>.<port> [<chain #>.<port> ...]
+//! \endverbatim
+//! Cells belong to the preceding device.  Devices without a cell map are placed in BYPASS.
+//!
+//! Scans are batched into as few USBDM_JTAG_ExecuteSequence() calls as the BDM buffers allow.
+//!
+class BoundaryScan {
+private:
+   static std::vector<BoundaryScanDevice> devices;
+   static std::vector<BoundaryScanNet>    nets;
+   static unsigned int                    drLength;
+
+   static int             findDevice(unsigned int deviceNum);
+   static USBDM_ErrorCode setupChain(void);
+   static void            getInstruction(bitVector &ir, bool extest);
+   static void            getSafeVector(bitVector &dr);
+   static bool            parsePin(const char *pinName, BoundaryScanPin &pin);
+   static unsigned int    assignCodes(void);
+   static void            diagnose(std::vector<bitVector> &responses, unsigned int codeBits);
+
+public:
+   //! Maximum length of the boundary-scan chain (limited by bitVector)
+   static const unsigned int MAX_DR_LENGTH = 1000;
+
+   static USBDM_ErrorCode loadCellMap(const char *fileName);
+   static USBDM_ErrorCode sample(unsigned int numSamples, std::vector<bitVector> &samples);
+   static USBDM_ErrorCode extest(std::vector<bitVector> &vectors, std::vector<bitVector> &responses);
+   static USBDM_ErrorCode interconnectTest(void);
+   static void            reportSample(bitVector &sample);
+   static void            reportResults(void);
+
+   //! Returns the number of nets in the cell map
+   static unsigned int getNetCount(void) {
+      return nets.size();
+   }
+   //! Returns information about a net
+   static const BoundaryScanNet &getNet(unsigned int netNum) {
+      return nets[netNum];
+   }
+};
+
+#endif /* BOUNDARYSCAN_H_ */
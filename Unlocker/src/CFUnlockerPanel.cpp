@@ -25,6 +25,7 @@
 #include "Log.h"
 #include "Version.h"
 #include "CFUnlockerPanel.h"
+#include "BoundaryScan.h"
 
 /*
  * ColdfireUnlockerDialogue type definition
@@ -36,6 +37,7 @@ IMPLEMENT_DYNAMIC_CLASS( ColdfireUnlockerPanel, wxPanel )
  */
 BEGIN_EVENT_TABLE( ColdfireUnlockerPanel, wxPanel )
     EVT_BUTTON( ID_INIT_CHAIN_BUTTON, ColdfireUnlockerPanel::OnInitChainButtonClick )
+    EVT_BUTTON( ID_BOUNDARY_SCAN_BUTTON, ColdfireUnlockerPanel::OnBoundaryScanButtonClick )
     EVT_CHOICE( ID_JTAG_DEVICE_CHOICE, ColdfireUnlockerPanel::OnJtagDeviceChoiceSelected )
     EVT_SPINCTRL( ID_IR_LENGTH_SPINCTRL, ColdfireUnlockerPanel::OnIrLengthSpinctrlUpdated )
 //    EVT_UPDATE_UI( wxID_PIN_STATIC, ColdfireUnlockerDialogue::OnPinStaticUpdate )
@@ -97,6 +99,7 @@ ColdfireUnlockerPanel::~ColdfireUnlockerPanel()
 void ColdfireUnlockerPanel::Init()
 {
    initChainButtonControl = NULL;
+   boundaryScanButtonControl = NULL;
    numberOfDeviceStaticControl = NULL;
    jtagIdcodeStaticText = NULL;
    jtagDeviceChoiceControl = NULL;
@@ -140,6 +143,11 @@ void ColdfireUnlockerPanel::CreateControls()
     numberOfDeviceStaticControl = new wxStaticText( dialogue, wxID_NUMBER_OF_DEVICES_STATIC, _("Number of devices found: -"), wxDefaultPosition, wxDefaultSize, 0 );
     itemStaticBoxSizer3->Add(numberOfDeviceStaticControl, 0, wxALIGN_CENTER_VERTICAL|wxALL, 5);
 
+    itemStaticBoxSizer3->AddStretchSpacer();
+
+    boundaryScanButtonControl = new wxButton( dialogue, ID_BOUNDARY_SCAN_BUTTON, _("Boundary scan test..."), wxDefaultPosition, wxDefaultSize, 0 );
+    itemStaticBoxSizer3->Add(boundaryScanButtonControl, 0, wxALIGN_CENTER_VERTICAL|wxALL, 5);
+
     //====================================================================
 
     wxStaticBox* itemStaticBoxSizer6Static = new wxStaticBox(dialogue, wxID_ANY, _("2. Select device in chain to erase"));
@@ -291,6 +299,53 @@ void ColdfireUnlockerPanel::OnInitChainButtonClick( wxCommandEvent& event )
    USBDM_SetTargetType(T_OFF);
 }
 
+/*
+ * wxEVT_COMMAND_BUTTON_CLICKED event handler for ID_BOUNDARY_SCAN_BUTTON
+ */
+void ColdfireUnlockerPanel::OnBoundaryScanButtonClick( wxCommandEvent& event )
+{
+   wxString caption  = _("Select Boundary-scan Cell Map");
+   wxString wildcard = _("Cell map files (*.txt)|*.txt|All Files|*");
+   wxFileDialog dialog(this, caption, wxEmptyString, wxEmptyString, wildcard, wxFD_OPEN);
+   if (dialog.ShowModal() != wxID_OK) {
+      return;
+   }
+   USBDM_SetExtendedOptions(&bdmOptions);
+#if TARGET == CFVx
+   if (USBDM_SetTargetTypeWithRetry(T_CFVx) != BDM_RC_OK) {
+      return;
+   }
+#elif TARGET == MC56F80xx
+   if (USBDM_SetTargetTypeWithRetry(T_MC56F80xx) != BDM_RC_OK) {
+      return;
+   }
+#endif
+   USBDM_ErrorCode rc = boundaryScanTest(dialog.GetPath().ToAscii());
+   USBDM_SetTargetType(T_OFF);
+
+   if (rc != BDM_RC_OK) {
+      wxMessageBox(_("Boundary-scan test failed.\n\n"
+                     "Reason: ") +
+                   wxString(USBDM_GetErrorString(rc), wxConvUTF8),
+                   _("Boundary-scan Test"),
+                   wxOK|wxICON_ERROR,
+                   this
+                   );
+      return;
+   }
+   unsigned int counts[netShort+1] = {0};
+   for (unsigned int netNum=0; netNum<BoundaryScan::getNetCount(); netNum++) {
+      counts[BoundaryScan::getNet(netNum).status]++;
+   }
+   wxMessageBox(wxString::Format(_("Nets OK: %d\nOpen: %d\nShorted: %d\nUntestable: %d\n\n"
+                                   "See the log for details."),
+                                 counts[netOk], counts[netOpen], counts[netShort], counts[netUntestable]),
+                _("Boundary-scan Test"),
+                wxOK|(((counts[netOpen]+counts[netShort]) != 0)?wxICON_WARNING:wxICON_INFORMATION),
+                this
+                );
+}
+
 /*
  * wxEVT_COMMAND_CHOICE_SELECTED event handler for ID_JTAG_DEVICE_CHOICE
  */
@@ -879,3 +934,38 @@ USBDM_ErrorCode ColdfireUnlockerPanel::eraseCFVxDevice() {
 
    return rc;
 }
+
+//! \brief Runs the boundary-scan tests described by a cell map on the JTAG chain
+//!
+//! Samples the pins once and then does an interconnect test of the nets in the cell map.
+//! Results are reported to the log.
+//!
+//! @param cellMapFile : Path of cell map file (see \ref BoundaryScan)
+//!
+//! @return error code, see \ref USBDM_ErrorCode
+//!
+USBDM_ErrorCode ColdfireUnlockerPanel::boundaryScanTest(const char *cellMapFile) {
+   std::vector<bitVector> samples;
+
+   print("Boundary-scan test using cell map \'%s\'\n", cellMapFile);
+
+   USBDM_ErrorCode rc = JTAG_Chain::initialiseJTAGChain();
+   if (rc != BDM_RC_OK) {
+      return rc;
+   }
+   rc = BoundaryScan::loadCellMap(cellMapFile);
+   if (rc != BDM_RC_OK) {
+      return rc;
+   }
+   rc = BoundaryScan::sample(1, samples);
+   if (rc != BDM_RC_OK) {
+      return rc;
+   }
+   BoundaryScan::reportSample(samples[0]);
+   rc = BoundaryScan::interconnectTest();
+   if (rc != BDM_RC_OK) {
+      return rc;
+   }
+   BoundaryScan::reportResults();
+   return BDM_RC_OK;
+}
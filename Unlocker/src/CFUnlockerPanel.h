@@ -52,6 +52,7 @@ private:
    void findDeviceInJTAGChain(unsigned int deviceNum);
    USBDM_ErrorCode eraseDscDevice();
    USBDM_ErrorCode eraseCFVxDevice();
+   USBDM_ErrorCode boundaryScanTest(const char *cellMapFile);
    USBDM_ExtendedOptions_t bdmOptions;
 
 public:
@@ -75,6 +76,9 @@ public:
     /// wxEVT_COMMAND_BUTTON_CLICKED event handler for ID_INIT_CHAIN_BUTTON
     void OnInitChainButtonClick( wxCommandEvent& event );
 
+    /// wxEVT_COMMAND_BUTTON_CLICKED event handler for ID_BOUNDARY_SCAN_BUTTON
+    void OnBoundaryScanButtonClick( wxCommandEvent& event );
+
     /// wxEVT_COMMAND_CHOICE_SELECTED event handler for ID_JTAG_DEVICE_CHOICE
     void OnJtagDeviceChoiceSelected( wxCommandEvent& event );
 
@@ -124,6 +128,7 @@ public:
     }
     // Controls
     wxButton*              initChainButtonControl;
+    wxButton*              boundaryScanButtonControl;
     wxStaticText*          numberOfDeviceStaticControl;
     wxStaticText*          jtagIdcodeStaticText;
     wxChoice*              jtagDeviceChoiceControl;
@@ -159,7 +164,8 @@ public:
         ID_UNLOCK_VALUE_TEXTCTRL          = 10003,
         ID_CLOCK_DIVIDER_VALUE_TEXTCTRL   = 10004,
         wxID_VERSION_STATIC               = 10015,
-        ID_UNLOCK_BUTTON                  = 10007
+        ID_UNLOCK_BUTTON                  = 10007,
+        ID_BOUNDARY_SCAN_BUTTON           = 10016
     };
 
 
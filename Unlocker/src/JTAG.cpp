@@ -26,12 +26,14 @@
     \endverbatim
 */
 #include "stddef.h"
+#include "string.h"
 #include "Log.h"
 #include "Debug.h"
 #include "Common.h"
 #include "USBDM_API.h"
 #include "BitVector.h"
 #include "KnownDevices.h"
+#include "JTAGSequence.h"
 #include "JTAG.h"
 
 // Useful vectors for use with JTAG interface
@@ -64,11 +66,74 @@ U32u temp1, temp2;
    *value         = temp2.longword;
 }
 
+//! Maximum number of bits in a single JTAG_SHIFT_IN_DP operation (multiple of 8)
+#define MAX_SHIFT_IN_BITS (224)
+
+//! Adds shift-in operations for numBits to a JTAG sequence
+//!
+//! @param sp         : Ptr to sequence
+//! @param numBits    : Number of bits to shift (multiple of 8)
+//! @param exitAction : JTAG_SET_EXIT_... action for the last shift
+//!
+//! @return ptr to end of sequence
+//!
+static uint8_t *addShiftIn(uint8_t *sp, unsigned int numBits, uint8_t exitAction) {
+   while (numBits > 0) {
+      unsigned int chunk = (numBits>MAX_SHIFT_IN_BITS)?MAX_SHIFT_IN_BITS:numBits;
+      numBits -= chunk;
+      if (numBits == 0)
+         *sp++ = exitAction;
+      *sp++ = JTAG_SHIFT_IN_DP;
+      *sp++ = (uint8_t)chunk;
+   }
+   return sp;
+}
+
+//! Converts data read by addShiftIn() operations to an array of words
+//!
+//! @param data    : Data read from the BDM (each shift is a right-justified big-endian value)
+//! @param numBits : Number of bits (as for addShiftIn())
+//! @param words   : Word array (zeroed) - bit n of the array is the n-th bit shifted from TDO
+//! @param bitNum  : Starting bit number in word array (multiple of 8)
+//!
+//! @return ptr to following data
+//!
+static const uint8_t *unpackBits(const uint8_t *data, unsigned int numBits, uint32_t words[], unsigned int bitNum) {
+   while (numBits > 0) {
+      unsigned int chunk = (numBits>MAX_SHIFT_IN_BITS)?MAX_SHIFT_IN_BITS:numBits;
+      numBits -= chunk;
+      data    += chunk/8;
+      const uint8_t *bp = data;
+      for (unsigned int count=0; count<chunk; count+=8) {
+         words[bitNum/32] |= ((uint32_t)*--bp)<<(bitNum%32);
+         bitNum += 8;
+      }
+   }
+   return data;
+}
+
+//! Returns a bit from a word array
+//!
+static inline unsigned int getBit(const uint32_t words[], unsigned int bitNum) {
+   return (words[bitNum/32]>>(bitNum%32))&0x01;
+}
+
+//! Returns a 32-bit field from a word array
+//!
+//! @note words[] must have an additional word following the field
+//!
+static uint32_t getField32(const uint32_t words[], unsigned int bitNum) {
+   unsigned int shift = bitNum%32;
+   uint32_t value = words[bitNum/32]>>shift;
+   if (shift != 0)
+      value |= words[bitNum/32+1]<<(32-shift);
+   return value;
+}
+
 //! \brief Initialises the JTAG chain
 //! \ref JTAG_Chain::devices is populated with the devices found
 //!
 USBDM_ErrorCode JTAG_Chain::initialiseJTAGChain(void) {
-uint32_t buff;
 unsigned int deviceNum;
 USBDM_ErrorCode rc = BDM_RC_OK;
 
@@ -79,6 +144,257 @@ USBDM_ErrorCode rc = BDM_RC_OK;
    deviceNum   = 0;
 
 #if (DEBUG & DEBUG_NOTLIVE) == 0
+   rc = scanJTAGChain();
+   if (rc != BDM_RC_OK) {
+      print("initialiseJTAGChain(): Chain scan failed, probing chain\n");
+      rc = probeJTAGChain();
+   }
+   if (rc != BDM_RC_OK)
+      return rc;
+   deviceNum = deviceCount;
+#endif
+
+#if (DEBUG & DEBUG_DEVICES) != 0
+   const DeviceData *deviceData;
+   uint32_t buff;
+
+   // Debug - add dummy devices
+   buff = (0x04B<<12)|(FREESCALE_JEDEC<<1)|1;
+   devices[deviceNum  ].idcode     = buff;
+   deviceData                      = KnownDevices::lookUpDevice(buff);
+   devices[deviceNum  ].irLength   = deviceData->instructionLength;
+   devices[deviceNum++].deviceData = deviceData;
+
+   buff = (0x053<<12)|(FREESCALE_JEDEC<<1)|1;
+   devices[deviceNum  ].idcode     = buff;
+   deviceData                      = KnownDevices::lookUpDevice(buff);
+   devices[deviceNum  ].irLength   = deviceData->instructionLength;
+   devices[deviceNum++].deviceData = deviceData;
+
+   buff = (0x123<<12)|(FREESCALE_JEDEC<<1)|1;
+   devices[deviceNum  ].idcode     = buff;
+   deviceData                      = KnownDevices::lookUpDevice(buff);
+   devices[deviceNum  ].irLength   = deviceData->instructionLength;
+   devices[deviceNum++].deviceData = deviceData;
+
+   buff = 0x12345678UL|1;
+   devices[deviceNum  ].idcode     = buff;
+   deviceData                      = KnownDevices::lookUpDevice(buff);
+   devices[deviceNum  ].irLength   = deviceData->instructionLength;
+   devices[deviceNum++].deviceData = deviceData;
+
+   buff = 0x0;
+   devices[deviceNum  ].idcode     = buff;
+   deviceData                      = KnownDevices::lookUpDevice(buff);
+   devices[deviceNum  ].irLength   = deviceData->instructionLength;
+   devices[deviceNum++].deviceData = deviceData;
+
+   buff = 0x06E5E093UL;
+   devices[deviceNum  ].idcode     = buff;
+   deviceData                      = KnownDevices::lookUpDevice(buff);
+   devices[deviceNum  ].irLength   = deviceData->instructionLength;
+   devices[deviceNum++].deviceData = deviceData;
+#endif
+
+   deviceCount = deviceNum;
+
+   print("initialiseJTAGChain(): Number of JTAG devices => %d\n", deviceCount);
+
+   rc = validateJTAGChain();
+   if (rc != BDM_RC_OK)
+      return rc;
+
+   reportDeviceIDs();
+
+   return rc;
+}
+
+//! \brief Scans the JTAG chain in a single BDM transaction
+//!
+//! All devices are reset (IDCODE or BYPASS selected) and the DR chain is read
+//! while shifting in '1's.  A '0' indicates a BYPASS register (no IDCODE) and a '1'
+//! the start of a 32-bit IDCODE.  The end of the chain is indicated by an IDCODE of all '1's.\n
+//! The IR chain is then read while shifting in '0's followed by '1's.  This gives the
+//! captured IR values and the total IR length and leaves all devices in BYPASS.
+//!
+//! \ref JTAG_Chain::devices is populated with the devices found
+//!
+USBDM_ErrorCode JTAG_Chain::scanJTAGChain(void) {
+   static const unsigned int irScanLength = 2*MAX_JTAG_IR_CHAIN_LENGTH;
+   uint8_t  sequence[40];
+   uint8_t  dataIn[(DR_SCAN_LENGTH+irScanLength)/8];
+   uint32_t drChain[DR_SCAN_LENGTH/32+1]  = {0};
+   uint32_t irChain[irScanLength/32+2]    = {0};
+   uint8_t *sp = sequence;
+   USBDM_ErrorCode rc;
+
+   *sp++ = JTAG_TEST_LOGIC_RESET;        // Loads IDCODE/BYPASS command into IR
+   *sp++ = JTAG_MOVE_DR_SCAN;
+   *sp++ = JTAG_SET_IN_FILL_1;
+   *sp++ = JTAG_SET_STAY_SHIFT;
+   sp    = addShiftIn(sp, DR_SCAN_LENGTH, JTAG_SET_EXIT_IDLE);
+   *sp++ = JTAG_MOVE_IR_SCAN;
+   *sp++ = JTAG_SET_IN_FILL_0;
+   *sp++ = JTAG_SET_STAY_SHIFT;
+   sp    = addShiftIn(sp, MAX_JTAG_IR_CHAIN_LENGTH, JTAG_SET_STAY_SHIFT);
+   *sp++ = JTAG_SET_IN_FILL_1;           // Leaves all devices in BYPASS
+   sp    = addShiftIn(sp, MAX_JTAG_IR_CHAIN_LENGTH, JTAG_SET_EXIT_IDLE);
+   *sp++ = JTAG_END;
+
+   rc = USBDM_JTAG_ExecuteSequence(sp-sequence, sequence, sizeof(dataIn), dataIn);
+   if (rc != BDM_RC_OK) {
+      print("scanJTAGChain(): Failed, reason = %s\n", USBDM_GetErrorString(rc));
+      return rc;
+   }
+   const uint8_t *dp = dataIn;
+   dp = unpackBits(dp, DR_SCAN_LENGTH,           drChain, 0);
+   dp = unpackBits(dp, MAX_JTAG_IR_CHAIN_LENGTH, irChain, 0);
+   dp = unpackBits(dp, MAX_JTAG_IR_CHAIN_LENGTH, irChain, MAX_JTAG_IR_CHAIN_LENGTH);
+
+   // Decode IDCODE/BYPASS chain
+   unsigned int bitNum = 0;
+   deviceCount = 0;
+   for(;;) {
+      uint32_t idcode = 0;
+      if (getBit(drChain, bitNum) != 0) {
+         idcode = getField32(drChain, bitNum);
+         if (idcode == 0xFFFFFFFFUL) {
+            break;
+         }
+      }
+      if ((deviceCount >= MAX_JTAG_DEVICES) || (bitNum+32 > DR_SCAN_LENGTH)) {
+         print("scanJTAGChain(): Too many devices\n");
+         return BDM_RC_FAIL;
+      }
+      if (idcode == 0) { // BYPASS register - No IDCODE
+         devices[deviceCount].idcode     = 0x00;
+         devices[deviceCount].irLength   = 2;
+         devices[deviceCount].deviceData = KnownDevices::lookUpDevice(0x00);
+         bitNum += 1;
+      }
+      else {
+         const DeviceData *deviceData    = KnownDevices::lookUpDevice(idcode);
+         devices[deviceCount].idcode     = idcode;
+         devices[deviceCount].irLength   = deviceData->instructionLength;
+         devices[deviceCount].deviceData = deviceData;
+         bitNum += 32;
+      }
+      deviceCount++;
+   }
+   if (deviceCount == 0) {
+      print("scanJTAGChain(): No devices found\n");
+      return BDM_RC_FAIL;
+   }
+   print("scanJTAGChain(): Number of JTAG devices => %d\n", deviceCount);
+
+   // Find total length of IR chain
+   // TDO => [captured IRs (irLength)]['0' x MAX_JTAG_IR_CHAIN_LENGTH]['1'...]
+   bitNum = MAX_JTAG_IR_CHAIN_LENGTH;
+   while ((bitNum < irScanLength) && (getBit(irChain, bitNum) == 0)) {
+      if (((bitNum%32) == 0) && (irChain[bitNum/32] == 0))
+         bitNum += 32;
+      else
+         bitNum++;
+   }
+   if ((bitNum == MAX_JTAG_IR_CHAIN_LENGTH) || (bitNum >= irScanLength)) {
+      print("scanJTAGChain(): Illegal IR length\n");
+      return BDM_RC_FAIL;
+   }
+   irLength = bitNum - MAX_JTAG_IR_CHAIN_LENGTH;
+   print("scanJTAGChain(): Total length of JTAG IRs => %d\n", irLength);
+
+   // Keep captured IR reg - used for validation
+   if (irReg != NULL)
+      delete irReg;
+   irReg = new bitVector(irLength, dataIn+(DR_SCAN_LENGTH+MAX_JTAG_IR_CHAIN_LENGTH)/8-BITS_TO_BYTES(irLength));
+   print("scanJTAGChain(): JTAG IRs => %s\n", irReg->toBinString());
+
+   inferIRLengths(irChain);
+
+   return BDM_RC_OK;
+}
+
+//! (deviceNum, bitNum) pairs already shown to have no fit - bounds the search in fitIRLengths()
+static bool irFitFailed[JTAG_Chain::MAX_JTAG_DEVICES][JTAG_Chain::MAX_JTAG_IR_CHAIN_LENGTH];
+
+//! Assigns IR lengths to devices from deviceNum onwards so that they are consistent with the captured IR values
+//!
+//! @param irCapture : Captured IR values (bit n is the n-th bit shifted from TDO)
+//! @param deviceNum : Device to start with
+//! @param bitNum    : Start of IR for this device
+//!
+//! @return true => consistent lengths found
+//!
+//! @note Failed (deviceNum, bitNum) pairs are recorded in irFitFailed[] so each is
+//!       only searched once
+//!
+bool JTAG_Chain::fitIRLengths(const uint32_t irCapture[], unsigned int deviceNum, unsigned int bitNum) {
+   if (deviceNum >= deviceCount)
+      return (bitNum == irLength);
+   if ((bitNum+2 > irLength) || (getBit(irCapture, bitNum) != 1) || (getBit(irCapture, bitNum+1) != 0))
+      return false;
+   if (irFitFailed[deviceNum][bitNum])
+      return false;
+   JTAG_Device &device = devices[deviceNum];
+   if (device.deviceData->irLengthKnown) {
+      if (fitIRLengths(irCapture, deviceNum+1, bitNum+device.irLength))
+         return true;
+      irFitFailed[deviceNum][bitNum] = true;
+      return false;
+   }
+   unsigned int remainder = 0;
+   for (unsigned int devNum = deviceNum+1; devNum < deviceCount; devNum++) {
+      remainder += devices[devNum].deviceData->irLengthKnown?devices[devNum].irLength:2;
+   }
+   for (unsigned int length = 2; bitNum+length+remainder <= irLength; length++) {
+      device.irLength = length;
+      if (fitIRLengths(irCapture, deviceNum+1, bitNum+length))
+         return true;
+   }
+   irFitFailed[deviceNum][bitNum] = true;
+   return false;
+}
+
+//! Determines the IR length of devices where this is unknown from the captured IR values
+//!
+//! IEEE 1149.1 requires the two least significant bits captured by each IR to be '01'.
+//! The shortest lengths that place a '01' at the start of every device's IR and agree
+//! with the total IR length are used.
+//!
+//! @param irCapture : Captured IR values (bit n is the n-th bit shifted from TDO)
+//!
+void JTAG_Chain::inferIRLengths(const uint32_t irCapture[]) {
+   unsigned int savedLengths[MAX_JTAG_DEVICES];
+   unsigned int deviceNum;
+
+   for (deviceNum = 0; deviceNum < deviceCount; deviceNum++) {
+      savedLengths[deviceNum] = devices[deviceNum].irLength;
+   }
+   memset(irFitFailed, 0, sizeof(irFitFailed));
+   if (!fitIRLengths(irCapture, 0, 0)) {
+      print("inferIRLengths(): IR capture inconsistent with devices\n");
+      for (deviceNum = 0; deviceNum < deviceCount; deviceNum++) {
+         devices[deviceNum].irLength = savedLengths[deviceNum];
+      }
+      return;
+   }
+   for (deviceNum = 0; deviceNum < deviceCount; deviceNum++) {
+      if (!devices[deviceNum].deviceData->irLengthKnown) {
+         print("inferIRLengths(): Device[%d] IR length => %d\n", deviceNum, devices[deviceNum].irLength);
+      }
+   }
+}
+
+//! \brief Determines the devices in the JTAG chain using a sequence of simple JTAG operations
+//!
+//! This is used if the BDM does not support JTAG sequences.
+//!
+//! \ref JTAG_Chain::devices is populated with the devices found
+//!
+USBDM_ErrorCode JTAG_Chain::probeJTAGChain(void) {
+uint32_t buff;
+USBDM_ErrorCode rc = BDM_RC_OK;
+
    // Find total length of JTAG IR chain
    //===========================================================================
    //
@@ -94,7 +410,7 @@ USBDM_ErrorCode rc = BDM_RC_OK;
    if (rc != BDM_RC_OK)
       return rc;
 
-   print("initialiseJTAGChain(): Total length of JTAG IRs => %d\n", irLength);
+   print("probeJTAGChain(): Total length of JTAG IRs => %d\n", irLength);
 
    // Chain still in SHIFT-IR
 
@@ -115,7 +431,7 @@ USBDM_ErrorCode rc = BDM_RC_OK;
    if (rc != BDM_RC_OK)
       return rc;
 
-   print("initialiseJTAGChain(): Number of JTAG devices => %d\n", deviceCount);
+   print("probeJTAGChain(): Number of JTAG devices => %d\n", deviceCount);
 
    // Re-fill the bypass chain with 0 to ensure we can differentiate
    // BYPASS and IDCODE register in next phase
@@ -134,7 +450,7 @@ USBDM_ErrorCode rc = BDM_RC_OK;
 
    uint8_t  temp;
    // Read each device IDCODE
-   for (deviceNum = 0; deviceNum < deviceCount; deviceNum++) {
+   for (unsigned int deviceNum = 0; deviceNum < deviceCount; deviceNum++) {
       rc = USBDM_JTAG_Read(1, JTAG_STAY_SHIFT, &temp);       // Read a single bit
       if (rc != BDM_RC_OK)
          return rc;
@@ -174,59 +490,7 @@ USBDM_ErrorCode rc = BDM_RC_OK;
    rc = USBDM_JTAG_Write(bypassAll.getLength(), JTAG_EXIT_IDLE, bypassAll.getArray());  // fill safe command
    if (rc != BDM_RC_OK)
       return rc;
-   print("initialiseJTAGChain(): JTAG IRs => %s\n", irReg->toBinString());
-#endif
-
-#if (DEBUG & DEBUG_DEVICES) != 0
-   const DeviceData *deviceData;
-
-   // Debug - add dummy devices
-   buff = (0x04B<<12)|(FREESCALE_JEDEC<<1)|1;
-   devices[deviceNum  ].idcode     = buff;
-   deviceData                      = KnownDevices::lookUpDevice(buff);
-   devices[deviceNum  ].irLength   = deviceData->instructionLength;
-   devices[deviceNum++].deviceData = deviceData;
-
-   buff = (0x053<<12)|(FREESCALE_JEDEC<<1)|1;
-   devices[deviceNum  ].idcode     = buff;
-   deviceData                      = KnownDevices::lookUpDevice(buff);
-   devices[deviceNum  ].irLength   = deviceData->instructionLength;
-   devices[deviceNum++].deviceData = deviceData;
-
-   buff = (0x123<<12)|(FREESCALE_JEDEC<<1)|1;
-   devices[deviceNum  ].idcode     = buff;
-   deviceData                      = KnownDevices::lookUpDevice(buff);
-   devices[deviceNum  ].irLength   = deviceData->instructionLength;
-   devices[deviceNum++].deviceData = deviceData;
-
-   buff = 0x12345678UL|1;
-   devices[deviceNum  ].idcode     = buff;
-   deviceData                      = KnownDevices::lookUpDevice(buff);
-   devices[deviceNum  ].irLength   = deviceData->instructionLength;
-   devices[deviceNum++].deviceData = deviceData;
-
-   buff = 0x0;
-   devices[deviceNum  ].idcode     = buff;
-   deviceData                      = KnownDevices::lookUpDevice(buff);
-   devices[deviceNum  ].irLength   = deviceData->instructionLength;
-   devices[deviceNum++].deviceData = deviceData;
-
-   buff = 0x06E5E093UL;
-   devices[deviceNum  ].idcode     = buff;
-   deviceData                      = KnownDevices::lookUpDevice(buff);
-   devices[deviceNum  ].irLength   = deviceData->instructionLength;
-   devices[deviceNum++].deviceData = deviceData;
-#endif
-
-   deviceCount = deviceNum;
-
-   print("initialiseJTAGChain(): Number of JTAG devices => %d\n", deviceCount);
-
-   rc = validateJTAGChain();
-   if (rc != BDM_RC_OK)
-      return rc;
-
-   reportDeviceIDs();
+   print("probeJTAGChain(): JTAG IRs => %s\n", irReg->toBinString());
 
    return rc;
 }
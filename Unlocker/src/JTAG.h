@@ -22,6 +22,7 @@ public:
 //!
 class  JTAG_Chain {
 private:
+   static bool fitIRLengths(const uint32_t irCapture[], unsigned int deviceNum, unsigned int bitNum);
 
 public:
    //! Maximum number of devices in the JTAG chain
@@ -31,6 +32,8 @@ public:
 #if (MAX_JTAG_IR_CHAIN_LENGTH > 240)
 #error "JTAG Chain too long"
 #endif
+   //! Length of DR scan used to read all IDCODEs (MAX_JTAG_DEVICES IDCODEs + end marker)
+   static const unsigned int DR_SCAN_LENGTH = 32*(MAX_JTAG_DEVICES+1);
    static unsigned int   deviceCount;
    static unsigned int   currentDeviceNum;
    static JTAG_Device    devices[MAX_JTAG_DEVICES];
@@ -42,6 +45,9 @@ public:
    static unsigned int   drPostambleLength;
 
    static USBDM_ErrorCode  initialiseJTAGChain(void);
+   static USBDM_ErrorCode  scanJTAGChain(void);
+   static USBDM_ErrorCode  probeJTAGChain(void);
+   static void             inferIRLengths(const uint32_t irCapture[]);
    static USBDM_ErrorCode  validateJTAGChain(void);
    static void             reportDeviceIDs(void);
 
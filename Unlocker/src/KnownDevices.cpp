@@ -42,6 +42,9 @@ unsigned int KnownDevices::deviceCount;
 //! Each known device
 DeviceData   KnownDevices::deviceData[MAX_KNOWN_DEVICES];
 
+//! Hash table used to look up devices by IDCODE
+unsigned short KnownDevices::hashTable[HASH_TABLE_SIZE];
+
 // Some 'dummy' devices types
 //                                                  Idx ID   IRl DRl IRKn UNLK  IDC   Fl  Fmin    Fmax    Name               Description
 //! Description of a Non-Freescale device
@@ -141,6 +144,8 @@ int lineNo = 0;
    }
    fclose(fp);
 
+   buildHashTable();
+
 #ifdef LOG
    for (deviceNum = 0; deviceData[deviceNum].description != NULL; deviceNum++) {
       print("0x%8.8x %d 0x%2.2x %10s %s\n",
@@ -153,6 +158,41 @@ int lineNo = 0;
 #endif
 }
 
+//! \brief Returns the part of the IDCODE used to identify a device
+//!
+//! Freescale devices are identified by JEDEC code and PIN, others by JEDEC code and part number.
+//! The revision is ignored.
+//!
+uint32_t KnownDevices::hashKey(uint32_t idcode) {
+   unsigned int jedec = JEDEC_ID(idcode);
+
+   if (jedec == FREESCALE_JEDEC)
+      return (jedec<<16)|FREESCALE_PIN(idcode);
+   return (jedec<<16)|PART_NUM(idcode);
+}
+
+//! \brief Returns the starting hash table index for a key
+//!
+unsigned int KnownDevices::hashIndex(uint32_t key) {
+   return ((key*2654435761UL)&0xFFFFFFFFUL)>>23;
+}
+
+//! \brief Builds the IDCODE hash table from the known devices list.
+//!
+//! The first matching entry in the list is used for each IDCODE
+//!
+void KnownDevices::buildHashTable(void) {
+   memset(hashTable, 0, sizeof(hashTable));
+   for (unsigned int sub=0; deviceData[sub].name != NULL; sub++) {
+      uint32_t     key   = hashKey(deviceData[sub].idcode);
+      unsigned int index = hashIndex(key);
+      while ((hashTable[index] != 0) && (hashKey(deviceData[hashTable[index]-1].idcode) != key))
+         index = (index+1)&(HASH_TABLE_SIZE-1);
+      if (hashTable[index] == 0)
+         hashTable[index] = (unsigned short)(sub+1);
+   }
+}
+
 //! \brief Finds information about a device from JTAG IDCODE value
 //!
 //! @param idcode : JTAG IDCODE read from device
@@ -160,34 +200,26 @@ int lineNo = 0;
 const DeviceData *KnownDevices::lookUpDevice(uint32_t idcode) {
 
 unsigned int       jedec          = JEDEC_ID(idcode);
-unsigned int       freescalePin   = FREESCALE_PIN(idcode);
-unsigned int       partNum        = PART_NUM(idcode);
-int                sub;
+uint32_t           key            = hashKey(idcode);
+unsigned int       index;
 const DeviceData  *device = NULL;
 
 #ifdef LOG
   print("lookUpDevice: idcode         => 0x%3.3lx\n",  idcode);
   print("lookUpDevice: JEDEC code     => 0x%3.3x%s\n",
            jedec, (jedec==FREESCALE_JEDEC)?"(Freescale)":"");
-  print("lookUpDevice: part Number    => 0x%3.3x\n",   partNum);
+  print("lookUpDevice: part Number    => 0x%3.3x\n",   PART_NUM(idcode));
    if (jedec==FREESCALE_JEDEC)
-     print("lookUpDevice: freescalePin   => 0x%3.3x\n",   freescalePin);
+     print("lookUpDevice: freescalePin   => 0x%3.3x\n",   FREESCALE_PIN(idcode));
 #endif
 
    if (idcode == 0x0) // No IDCODE from device
       device = &unknownDevice;
    else { // Search table for device
-      for (sub=0; deviceData[sub].name != NULL; sub++) {
-         if (jedec == JEDEC_ID(deviceData[sub].idcode)) { // Correct manufacturer
-            if ((jedec == FREESCALE_JEDEC) &&                              // Freescale device?
-                (freescalePin == FREESCALE_PIN(deviceData[sub].idcode))) { // Only need to match PIN
-               device = &deviceData[sub];
-               break;
-            }
-            if (partNum == PART_NUM(deviceData[sub].idcode)) { // Match entire partNum
-               device = &deviceData[sub];
-               break;
-            }
+      for (index = hashIndex(key); hashTable[index] != 0; index = (index+1)&(HASH_TABLE_SIZE-1)) {
+         if (hashKey(deviceData[hashTable[index]-1].idcode) == key) {
+            device = &deviceData[hashTable[index]-1];
+            break;
          }
       }
    }
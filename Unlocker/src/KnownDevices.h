@@ -31,6 +31,8 @@ public:
 class KnownDevices {
 public:
    static const unsigned int     MAX_KNOWN_DEVICES = 200;
+   //! Size of IDCODE hash table (power of 2, > 2*MAX_KNOWN_DEVICES)
+   static const unsigned int     HASH_TABLE_SIZE   = 512;
 
    static unsigned int           deviceCount;
    static DeviceData             deviceData[MAX_KNOWN_DEVICES];
@@ -38,6 +40,14 @@ public:
    static const DeviceData      *lookUpDevice(uint32_t idcode);
    static void                   loadConfigFile(void);
 
+private:
+   static unsigned short         hashTable[HASH_TABLE_SIZE];   //!< deviceData index+1, 0 => empty
+
+   static uint32_t               hashKey(uint32_t idcode);
+   static unsigned int           hashIndex(uint32_t key);
+   static void                   buildHashTable(void);
+
+public:
    // Some 'dummy' devices types
    static const DeviceData nonFreescaleDevice;
    static const DeviceData unknownDevice;
@@ -1477,6 +1477,223 @@ static int wlCommand(ClientData notneededhere, Tcl_Interp *interp, int argc, Tcl
    return TCL_OK;
 }
 
+//! Maximum number of bytes combined into a single memory transfer by regscript
+#define REGSCRIPT_MAX_RUN (64)
+
+//! Run of consecutive memory accesses being combined by regscript
+typedef struct {
+   int       write;        //!< TRUE => write run, FALSE => read run
+   int       memSpace;     //!< Memory space (including element size)
+   int       elementSize;  //!< Element size in bytes (1, 2 or 4)
+   uint32_t  address;      //!< Start address of run
+   uint32_t  nextAddress;  //!< Address that would extend the run
+   unsigned  byteCount;    //!< Number of bytes in run
+   uint8_t   buffer[REGSCRIPT_MAX_RUN];
+} RegScriptRun;
+
+//! Get value of memory element from buffer (target byte order)
+static uint32_t getElementValue(int elementSize, uint8_t *data) {
+   switch(elementSize) {
+   case 1  : return data[0];
+   case 2  : return getData16(data);
+   default : return getData32(data);
+   }
+}
+
+//! Address increment for a memory element of the given size
+static uint32_t getAddressIncrement(int elementSize) {
+   if (targetType == T_MC56F80xx) {
+      // Word addressed
+      return (elementSize+1)/2;
+   }
+   return elementSize;
+}
+
+//! Execute pending run of accesses
+//!
+//! @param interp     - TCL interpreter
+//! @param run        - Run of accesses to execute
+//! @param resultList - List to add values read to
+//! @param count      - Incremented for each memory transfer
+//!
+static int regScriptFlush(Tcl_Interp *interp, RegScriptRun *run, Tcl_Obj *resultList, unsigned *count) {
+   unsigned offset;
+   if (run->byteCount == 0) {
+      return TCL_OK;
+   }
+   (*count)++;
+   if (run->write) {
+      if (checkUsbdmRC(interp, pUSBDM_WriteMemory(run->memSpace, run->byteCount, run->address, run->buffer)) != 0) {
+         printf(":regscript write @0x%8.8X Failed\n", run->address);
+         return TCL_ERROR;
+      }
+   }
+   else {
+      if (checkUsbdmRC(interp, pUSBDM_ReadMemory(run->memSpace, run->byteCount, run->address, run->buffer)) != 0) {
+         printf(":regscript read @0x%8.8X Failed\n", run->address);
+         return TCL_ERROR;
+      }
+      for (offset=0; offset<run->byteCount; offset+=run->elementSize) {
+         Tcl_ListObjAppendElement(interp, resultList,
+               Tcl_NewLongObj((long)getElementValue(run->elementSize, run->buffer+offset)));
+      }
+   }
+   run->byteCount = 0;
+   return TCL_OK;
+}
+
+//! Execute a register script i.e. a sequence of memory writes, reads and polls
+//!
+//! regscript <list of operations>
+//!
+//! Operations:
+//!    {wb|ww|wl <addr> <value>}                       - write byte/word/long
+//!    {rb|rw|rl <addr>}                               - read byte/word/long
+//!    {pollb|pollw|polll <addr> <mask> <value> [<ms>]} - read until (data&mask) == value (default 1000 ms)
+//!    {delay <ms>}                                    - wait
+//!
+//! Writes (or reads) of the same size to consecutive addresses are combined into a single
+//! memory transfer. Values read (including the final value of each poll) are returned as a list.
+//!
+static int regScriptCommand(ClientData notneededhere, Tcl_Interp *interp, int argc, Tcl_Obj *const *argv) {
+   int           numOps;
+   Tcl_Obj     **ops;
+   int           opIndex;
+   RegScriptRun  run;
+   unsigned      transferCount = 0;
+
+   if (argc != 2) {
+      Tcl_WrongNumArgs(interp, 1, argv, "<operations>");
+      return TCL_ERROR;
+   }
+   if (Tcl_ListObjGetElements(interp, argv[1], &numOps, &ops) != TCL_OK) {
+      return TCL_ERROR;
+   }
+   Tcl_Obj *resultList = Tcl_NewListObj(0, NULL);
+   Tcl_IncrRefCount(resultList);
+   run.byteCount = 0;
+
+   for (opIndex=0; opIndex<numOps; opIndex++) {
+      int       numArgs;
+      Tcl_Obj **args;
+      if ((Tcl_ListObjGetElements(interp, ops[opIndex], &numArgs, &args) != TCL_OK) || (numArgs < 1)) {
+         Tcl_SetResult(interp, "regscript: Illegal operation", TCL_STATIC);
+         goto failed;
+      }
+      const char *op = Tcl_GetString(args[0]);
+      if (strcmp(op, "delay") == 0) {
+         int delay;
+         if ((numArgs != 2) || (Tcl_GetIntFromObj(interp, args[1], &delay) != TCL_OK)) {
+            Tcl_SetResult(interp, "regscript: Usage {delay <ms>}", TCL_STATIC);
+            goto failed;
+         }
+         if (regScriptFlush(interp, &run, resultList, &transferCount) != TCL_OK) {
+            goto failed;
+         }
+         milliSleep(delay);
+         continue;
+      }
+      // Memory operations - element size from last character
+      int elementSize;
+      int memSpace;
+      switch (op[strlen(op)-1]) {
+      case 'b' : elementSize = 1; memSpace = MS_Byte; break;
+      case 'w' : elementSize = 2; memSpace = MS_Word; break;
+      case 'l' : elementSize = 4; memSpace = MS_Long; break;
+      default  : elementSize = 0; memSpace = 0;       break;
+      }
+      uint32_t address;
+      if ((elementSize == 0) || (numArgs < 2) || (getAddress(args[1], &address, &memSpace) != TCL_OK)) {
+         Tcl_SetObjResult(interp, Tcl_ObjPrintf("regscript: Illegal operation '%s'", Tcl_GetString(ops[opIndex])));
+         goto failed;
+      }
+      if (strncmp(op, "poll", 4) == 0) {
+         int mask, value, data;
+         int timeout = 1000;
+         if ((numArgs < 4) || (numArgs > 5) ||
+             (Tcl_GetIntFromObj(interp, args[2], &mask) != TCL_OK) ||
+             (Tcl_GetIntFromObj(interp, args[3], &value) != TCL_OK) ||
+             ((numArgs == 5) && (Tcl_GetIntFromObj(interp, args[4], &timeout) != TCL_OK))) {
+            Tcl_SetResult(interp, "regscript: Usage {poll[bwl] <addr> <mask> <value> [<ms>]}", TCL_STATIC);
+            goto failed;
+         }
+         if (regScriptFlush(interp, &run, resultList, &transferCount) != TCL_OK) {
+            goto failed;
+         }
+         for(;;) {
+            uint8_t buff[4];
+            transferCount++;
+            if (checkUsbdmRC(interp, pUSBDM_ReadMemory(memSpace, elementSize, address, buff)) != 0) {
+               printf(":regscript poll @0x%8.8X Failed\n", address);
+               goto failed;
+            }
+            data = getElementValue(elementSize, buff);
+            if ((data&mask) == (value&mask)) {
+               break;
+            }
+            if (timeout-- <= 0) {
+               Tcl_SetObjResult(interp, Tcl_ObjPrintf("regscript: Timeout polling 0x%8.8X, last value = 0x%X", address, data));
+               goto failed;
+            }
+            milliSleep(1);
+         }
+         Tcl_ListObjAppendElement(interp, resultList, Tcl_NewLongObj((long)(uint32_t)data));
+         continue;
+      }
+      int write;
+      int data = 0;
+      if (op[0] == 'w') {
+         if ((numArgs != 3) || (Tcl_GetIntFromObj(interp, args[2], &data) != TCL_OK)) {
+            Tcl_SetObjResult(interp, Tcl_ObjPrintf("regscript: Usage {%s <addr> <value>}", op));
+            goto failed;
+         }
+         write = TRUE;
+      }
+      else if ((op[0] == 'r') && (numArgs == 2)) {
+         write = FALSE;
+      }
+      else {
+         Tcl_SetObjResult(interp, Tcl_ObjPrintf("regscript: Illegal operation '%s'", Tcl_GetString(ops[opIndex])));
+         goto failed;
+      }
+      // Start a new run unless this access extends the current one
+      if ((run.byteCount == 0) ||
+          (run.write != write) ||
+          (run.memSpace != memSpace) ||
+          (run.nextAddress != address) ||
+          (run.byteCount+elementSize > sizeof(run.buffer))) {
+         if (regScriptFlush(interp, &run, resultList, &transferCount) != TCL_OK) {
+            goto failed;
+         }
+         run.write       = write;
+         run.memSpace    = memSpace;
+         run.elementSize = elementSize;
+         run.address     = address;
+      }
+      if (write) {
+         const uint8_t *dataPtr;
+         switch (elementSize) {
+         case 1  : run.buffer[run.byteCount] = (uint8_t)data;      break;
+         case 2  : dataPtr = getData2x8(data); memcpy(run.buffer+run.byteCount, dataPtr, 2); break;
+         default : dataPtr = getData4x8(data); memcpy(run.buffer+run.byteCount, dataPtr, 4); break;
+         }
+      }
+      run.byteCount   += elementSize;
+      run.nextAddress  = address+getAddressIncrement(elementSize);
+   }
+   if (regScriptFlush(interp, &run, resultList, &transferCount) != TCL_OK) {
+      goto failed;
+   }
+   printf(":regscript %d operations => %d transfers\n", numOps, transferCount);
+   Tcl_SetObjResult(interp, resultList);
+   Tcl_DecrRefCount(resultList);
+   return TCL_OK;
+
+failed:
+   Tcl_DecrRefCount(resultList);
+   return TCL_ERROR;
+}
+
 //! Write to Target PC (HC12, HCS08 & RS08)
 static int wpcCommand(ClientData notneededhere, Tcl_Interp *interp, int argc, Tcl_Obj *const *argv) {
 // wpc<addr> <data>
@@ -2827,6 +3044,160 @@ static int setLogCommand(ClientData notneededhere, Tcl_Interp *interp, int argc,
    return TCL_OK;
 }
 
+//! Append name-value pair to list
+static void appendStatistic(Tcl_Interp *interp, Tcl_Obj *list, const char *name, uint64_t value) {
+   Tcl_ListObjAppendElement(interp, list, Tcl_NewStringObj(name, -1));
+   Tcl_ListObjAppendElement(interp, list, Tcl_NewWideIntObj((Tcl_WideInt)value));
+}
+
+//! Report/clear BDM communication statistics
+static int statisticsCommand(ClientData notneededhere, Tcl_Interp *interp, int argc, Tcl_Obj *const *argv) {
+   // statistics [reset]
+   static const char *bucketNames[USBDM_LATENCY_BUCKETS] = {
+         "<64", "<128", "<256", "<512", "<1K", "<2K", "<4K", "<8K", "<16K", "<32K", "<64K", ">=64K",
+   };
+   static USBDM_Statistics_t statistics;
+   unsigned command, bucket;
+
+   if (argc > 2) {
+      Tcl_WrongNumArgs(interp, 1, argv, "?reset?");
+      return TCL_ERROR;
+   }
+   if (argc == 2) {
+      if (stricmp(Tcl_GetString(argv[1]), "reset") != 0) {
+         Tcl_WrongNumArgs(interp, 1, argv, "?reset?");
+         return TCL_ERROR;
+      }
+      return checkUsbdmRC(interp, USBDM_ResetStatistics());
+   }
+   statistics.size = sizeof(statistics);
+   if (checkUsbdmRC(interp, USBDM_GetStatistics(&statistics))) {
+      return TCL_ERROR;
+   }
+   printf("Retries: toggle = %lu, USB = %lu, BUSY = %lu; Delays = %lu (%.1f ms)\n",
+          statistics.toggleRetries, statistics.usbRetries, statistics.busyResponses,
+          statistics.sleepCount, statistics.sleepTime/1000.0);
+   printf("%-36s %8s %6s %10s %10s %10s %8s %8s\n",
+          "Command", "Count", "Errors", "Bytes out", "Bytes in", "Time(ms)", "Mean(us)", "Max(us)");
+   for (command=0; command<sizeof(statistics.commands)/sizeof(statistics.commands[0]); command++) {
+      const USBDM_CommandStatistics_t *entry = &statistics.commands[command];
+      if (entry->count == 0) {
+         continue;
+      }
+      printf("%-36s %8lu %6lu %10llu %10llu %10.1f %8.0f %8lu\n",
+             getCommandName(command), entry->count, entry->errors,
+             (unsigned long long)entry->bytesOut, (unsigned long long)entry->bytesIn,
+             entry->totalTime/1000.0, (double)entry->totalTime/entry->count, entry->maxTime);
+   }
+   printf("%-36s", "Latency (us)");
+   for (bucket=0; bucket<USBDM_LATENCY_BUCKETS; bucket++) {
+      printf(" %6s", bucketNames[bucket]);
+   }
+   printf("\n");
+   Tcl_Obj *commandList = Tcl_NewListObj(0, NULL);
+   for (command=0; command<sizeof(statistics.commands)/sizeof(statistics.commands[0]); command++) {
+      const USBDM_CommandStatistics_t *entry = &statistics.commands[command];
+      if (entry->count == 0) {
+         continue;
+      }
+      printf("%-36s", getCommandName(command));
+      Tcl_Obj *latencyList = Tcl_NewListObj(0, NULL);
+      for (bucket=0; bucket<USBDM_LATENCY_BUCKETS; bucket++) {
+         printf(" %6lu", entry->latency[bucket]);
+         Tcl_ListObjAppendElement(interp, latencyList, Tcl_NewLongObj((long)entry->latency[bucket]));
+      }
+      printf("\n");
+      Tcl_Obj *commandStatistics = Tcl_NewListObj(0, NULL);
+      appendStatistic(interp, commandStatistics, "count",     entry->count);
+      appendStatistic(interp, commandStatistics, "errors",    entry->errors);
+      appendStatistic(interp, commandStatistics, "bytesOut",  entry->bytesOut);
+      appendStatistic(interp, commandStatistics, "bytesIn",   entry->bytesIn);
+      appendStatistic(interp, commandStatistics, "totalTime", entry->totalTime);
+      appendStatistic(interp, commandStatistics, "maxTime",   entry->maxTime);
+      Tcl_ListObjAppendElement(interp, commandStatistics, Tcl_NewStringObj("latency", -1));
+      Tcl_ListObjAppendElement(interp, commandStatistics, latencyList);
+      Tcl_ListObjAppendElement(interp, commandList, Tcl_NewStringObj(getCommandName(command), -1));
+      Tcl_ListObjAppendElement(interp, commandList, commandStatistics);
+   }
+   // Result is a dictionary
+   Tcl_Obj *resultList = Tcl_NewListObj(0, NULL);
+   appendStatistic(interp, resultList, "toggleRetries", statistics.toggleRetries);
+   appendStatistic(interp, resultList, "usbRetries",    statistics.usbRetries);
+   appendStatistic(interp, resultList, "busyResponses", statistics.busyResponses);
+   appendStatistic(interp, resultList, "sleepCount",    statistics.sleepCount);
+   appendStatistic(interp, resultList, "sleepTime",     statistics.sleepTime);
+   Tcl_ListObjAppendElement(interp, resultList, Tcl_NewStringObj("commands", -1));
+   Tcl_ListObjAppendElement(interp, resultList, commandList);
+   Tcl_SetObjResult(interp, resultList);
+   return TCL_OK;
+}
+
+//! Report & return a timing breakdown as a dictionary
+static Tcl_Obj *timingBreakdown(Tcl_Interp *interp, const char *title, const USBDM_TimingBreakdown_t *timing) {
+   unsigned command;
+   double   elapsed = (double)(timing->roundTrip+timing->idle);
+
+   printf("%s - %lu records (%lu discarded), elapsed = %.1f ms, USB = %.1f ms (%.0f%%), idle = %.1f ms\n",
+          title, timing->records, timing->discarded, elapsed/1000.0, timing->roundTrip/1000.0,
+          (elapsed>0)?(100*timing->roundTrip/elapsed):0.0, timing->idle/1000.0);
+   printf("%-36s %8s %6s %10s %8s %8s %8s %10s\n",
+          "Command", "Count", "Errors", "USB(ms)", "Mean(us)", "Min(us)", "Max(us)", "Idle(ms)");
+   Tcl_Obj *commandList = Tcl_NewListObj(0, NULL);
+   for (command=0; command<sizeof(timing->commands)/sizeof(timing->commands[0]); command++) {
+      const USBDM_CommandTiming_t *entry = &timing->commands[command];
+      if (entry->count == 0) {
+         continue;
+      }
+      printf("%-36s %8lu %6lu %10.1f %8.0f %8lu %8lu %10.1f\n",
+             getCommandName(command), entry->count, entry->errors,
+             entry->roundTrip/1000.0, (double)entry->roundTrip/entry->count,
+             entry->minimum, entry->maximum, entry->idle/1000.0);
+      Tcl_Obj *commandTiming = Tcl_NewListObj(0, NULL);
+      appendStatistic(interp, commandTiming, "count",     entry->count);
+      appendStatistic(interp, commandTiming, "errors",    entry->errors);
+      appendStatistic(interp, commandTiming, "roundTrip", entry->roundTrip);
+      appendStatistic(interp, commandTiming, "minimum",   entry->minimum);
+      appendStatistic(interp, commandTiming, "maximum",   entry->maximum);
+      appendStatistic(interp, commandTiming, "idle",      entry->idle);
+      Tcl_ListObjAppendElement(interp, commandList, Tcl_NewStringObj(getCommandName(command), -1));
+      Tcl_ListObjAppendElement(interp, commandList, commandTiming);
+   }
+   Tcl_Obj *resultList = Tcl_NewListObj(0, NULL);
+   appendStatistic(interp, resultList, "records",   timing->records);
+   appendStatistic(interp, resultList, "discarded", timing->discarded);
+   appendStatistic(interp, resultList, "roundTrip", timing->roundTrip);
+   appendStatistic(interp, resultList, "idle",      timing->idle);
+   Tcl_ListObjAppendElement(interp, resultList, Tcl_NewStringObj("commands", -1));
+   Tcl_ListObjAppendElement(interp, resultList, commandList);
+   return resultList;
+}
+
+//! Report timing breakdown of captured/replayed BDM transactions (USBDM_CAPTURE/USBDM_REPLAY)
+static int captureTimingCommand(ClientData notneededhere, Tcl_Interp *interp, int argc, Tcl_Obj *const *argv) {
+   // capturetiming
+   static USBDM_CaptureTiming_t timing;
+
+   if (argc != 1) {
+      Tcl_WrongNumArgs(interp, 1, argv, "");
+      return TCL_ERROR;
+   }
+   timing.size = sizeof(timing);
+   if (checkUsbdmRC(interp, USBDM_GetCaptureTiming(&timing))) {
+      return TCL_ERROR;
+   }
+   // Result is a dictionary
+   Tcl_Obj *resultList = Tcl_NewListObj(0, NULL);
+   Tcl_ListObjAppendElement(interp, resultList, Tcl_NewStringObj("capture", -1));
+   Tcl_ListObjAppendElement(interp, resultList, timingBreakdown(interp, "Capture", &timing.capture));
+   Tcl_ListObjAppendElement(interp, resultList, Tcl_NewStringObj("recorded", -1));
+   Tcl_ListObjAppendElement(interp, resultList, timingBreakdown(interp, "Recorded", &timing.recorded));
+   printf("Replayed = %lu, divergences = %lu\n", timing.replayed, timing.divergences);
+   appendStatistic(interp, resultList, "replayed",    timing.replayed);
+   appendStatistic(interp, resultList, "divergences", timing.divergences);
+   Tcl_SetObjResult(interp, resultList);
+   return TCL_OK;
+}
+
 #ifdef INTERACTIVE
 static int guiDialogue(ClientData notneededhere, Tcl_Interp *interp, int argc, Tcl_Obj *const *argv) {
    // dialogue title message options
@@ -2891,6 +3262,7 @@ static int exitCommand(ClientData notneededhere, Tcl_Interp *interp, int argc, T
 
 //! Usage message
 static const char usageText[] =
+   "capturetiming                - Report timing of captured/replayed BDM transactions\n"
    "connect                      - Connect to target\n"
    "closeBDM                     - Close BDM connection\n"
    "debug <value>                - Debug commands\n"
@@ -2928,6 +3300,7 @@ static const char usageText[] =
    "settargetvdd <0|3|5|on|off>  - Set target Vdd (only has effect if target set)\n"
    "settargetvpp <standby|on|off>- Set target Vpp\n"
    "speed ?Hz?                   - Set/Get speed \n"
+   "statistics [reset]           - Report/clear BDM communication statistics\n"
    "step                         - Execute a single instruction\n"
    "sync                         - Execute a low level sync\n"
    "tblock <start> <end> <count> - Random RAM write/read block test\n"
@@ -3025,10 +3398,13 @@ const char *name;
       { wbCommand,              "wb"},
       { wwCommand,              "ww"},
       { wlCommand,              "wl"},
+      { regScriptCommand,       "regscript"},
       { wRegCommand,            "wreg"},
       { wCRegCommand,           "wcreg"},
       { wDRegCommand,           "wdreg"},
       { setLogCommand,          "log"},
+      { statisticsCommand,      "statistics"},
+      { captureTimingCommand,   "capturetiming"},
       { setTargetVppCommand,    "settargetvpp" },
       { setTargetVddCommand,    "settargetvcc" },
       { setTargetVddCommand,    "settargetvdd" },
@@ -3084,27 +3460,108 @@ int main(int argc, char *argv[]) {
 #else
 static FILE *logFile = NULL;
 
+//! Write TCL stack trace to log file after a failed evaluation
+//!
+static void logTclError(Tcl_Interp *interp, int rc) {
+   if ((logFile == NULL) || (rc == TCL_OK)) {
+      return;
+   }
+   Tcl_Obj *options = Tcl_GetReturnOptions(interp, rc);
+   Tcl_Obj *key = Tcl_NewStringObj("-errorinfo", -1);
+   Tcl_Obj *stackTrace;
+   if ((options == NULL) || (key == NULL)) {
+      return;
+   }
+   Tcl_IncrRefCount(key);
+   Tcl_DictObjGet(NULL, options, key, &stackTrace);
+   Tcl_DecrRefCount(key);
+   const char *res = Tcl_GetString(stackTrace);
+   if (res == NULL) {
+      return;
+   }
+   fprintf(logFile, "TCL Stack Frame = %s\n", res);
+}
+
 TCL_API
 int evalTclScript(Tcl_Interp *interp, const char *script) {
    int rc = Tcl_Eval(interp, script);
-   if (logFile != NULL) {
-      if (rc != TCL_OK) {
-         Tcl_Obj *options = Tcl_GetReturnOptions(interp, rc);
-         Tcl_Obj *key = Tcl_NewStringObj("-errorinfo", -1);
-         Tcl_Obj *stackTrace;
-         if ((options == NULL) || (key == NULL)) {
-            return rc;
-         }
-         Tcl_IncrRefCount(key);
-         Tcl_DictObjGet(NULL, options, key, &stackTrace);
-         Tcl_DecrRefCount(key);
-         const char *res = Tcl_GetString(stackTrace);
-         if (res == NULL) {
-            return rc;
-         }
-         fprintf(logFile, "TCL Stack Frame = %s\n", res);
-      }
+   logTclError(interp, rc);
+   return rc;
+}
+
+#define COMMAND_CACHE_KEY "usbdm::commandCache"
+
+//! Release cached command objects when interpreter is deleted
+//!
+static void freeCommandCache(ClientData clientData, Tcl_Interp *interp) {
+   Tcl_HashTable  *commandCache = (Tcl_HashTable *)clientData;
+   Tcl_HashSearch  search;
+   Tcl_HashEntry  *entry;
+   for (entry = Tcl_FirstHashEntry(commandCache, &search); entry != NULL; entry = Tcl_NextHashEntry(&search)) {
+      Tcl_DecrRefCount((Tcl_Obj *)Tcl_GetHashValue(entry));
+   }
+   Tcl_DeleteHashTable(commandCache);
+   ckfree((char *)commandCache);
+}
+
+//! Get command name object for a command
+//!
+//! The object is cached with the interpreter so that the command lookup
+//! is only done on first use.
+//!
+static Tcl_Obj *getCommandObj(Tcl_Interp *interp, const char *command) {
+   Tcl_HashTable *commandCache = (Tcl_HashTable *)Tcl_GetAssocData(interp, COMMAND_CACHE_KEY, NULL);
+   if (commandCache == NULL) {
+      commandCache = (Tcl_HashTable *)ckalloc(sizeof(Tcl_HashTable));
+      Tcl_InitHashTable(commandCache, TCL_STRING_KEYS);
+      Tcl_SetAssocData(interp, COMMAND_CACHE_KEY, freeCommandCache, (ClientData)commandCache);
+   }
+   int isNew;
+   Tcl_HashEntry *entry = Tcl_CreateHashEntry(commandCache, command, &isNew);
+   if (isNew) {
+      Tcl_Obj *commandObj = Tcl_NewStringObj(command, -1);
+      Tcl_IncrRefCount(commandObj);
+      Tcl_SetHashValue(entry, commandObj);
+   }
+   return (Tcl_Obj *)Tcl_GetHashValue(entry);
+}
+
+//! Evaluate a command previously defined in the interpreter e.g. by a flash script
+//!
+//! @param interp    - Interpreter to use
+//! @param command   - Name of command
+//! @param arguments - Arguments as a TCL list (may be NULL)
+//!
+//! @return TCL result code
+//!
+//! @note The command is invoked directly (Tcl_EvalObjv) using a cached command object.
+//!       No substitutions are done on the arguments.
+//!
+TCL_API
+int evalTclCommand(Tcl_Interp *interp, const char *command, const char *arguments) {
+   int          argc = 0;
+   const char **argv = NULL;
+   if ((arguments != NULL) && (Tcl_SplitList(interp, arguments, &argc, &argv) != TCL_OK)) {
+      logTclError(interp, TCL_ERROR);
+      return TCL_ERROR;
+   }
+   Tcl_Obj **objv = (Tcl_Obj **)ckalloc((argc+1)*sizeof(Tcl_Obj *));
+   objv[0] = getCommandObj(interp, command);
+   Tcl_IncrRefCount(objv[0]);
+   int index;
+   for (index=0; index<argc; index++) {
+      objv[index+1] = Tcl_NewStringObj(argv[index], -1);
+      Tcl_IncrRefCount(objv[index+1]);
+   }
+   int rc = Tcl_EvalObjv(interp, argc+1, objv, 0);
+   for (index=0; index<=argc; index++) {
+      Tcl_DecrRefCount(objv[index]);
    }
+   ckfree((char *)objv);
+   if (argv != NULL) {
+      ckfree((char *)argv);
+   }
+   logTclError(interp, rc);
    return rc;
 }
 
@@ -3126,6 +3583,84 @@ Tcl_Interp *createTclInterpreter(TargetType_t target, FILE *fp) {
    return tclInterp;
 }
 
+//! Records the global variables & procs of an interpreter (excluding env)
+static const char saveStateScript[] =
+   "namespace eval ::usbdm::pool {\n"
+   "   variable globals [list]\n"
+   "   foreach name [info globals] {\n"
+   "      if {$name eq \"env\"} {\n"
+   "         continue\n"
+   "      }\n"
+   "      if {[array exists ::$name]} {\n"
+   "         lappend globals $name 1 [array get ::$name]\n"
+   "      } elseif {[info exists ::$name]} {\n"
+   "         lappend globals $name 0 [set ::$name]\n"
+   "      }\n"
+   "   }\n"
+   "   variable procs [info procs ::*]\n"
+   "}\n";
+
+//! Restores the global variables & procs recorded by saveStateScript
+//! Globals & procs created since are deleted
+static const char restoreStateScript[] =
+   "namespace eval ::usbdm::pool {\n"
+   "   variable globals\n"
+   "   variable procs\n"
+   "   set names [list]\n"
+   "   foreach {name isArray value} $globals {\n"
+   "      lappend names $name\n"
+   "   }\n"
+   "   foreach name [info globals] {\n"
+   "      if {($name ne \"env\") && ([lsearch -exact $names $name] < 0)} {\n"
+   "         unset -nocomplain ::$name\n"
+   "      }\n"
+   "   }\n"
+   "   foreach {name isArray value} $globals {\n"
+   "      unset -nocomplain ::$name\n"
+   "      if {$isArray} {\n"
+   "         array set ::$name $value\n"
+   "      } else {\n"
+   "         set ::$name $value\n"
+   "      }\n"
+   "   }\n"
+   "   foreach procName [info procs ::*] {\n"
+   "      if {[lsearch -exact $procs $procName] < 0} {\n"
+   "         rename $procName {}\n"
+   "      }\n"
+   "   }\n"
+   "}\n";
+
+//! Record the state of an interpreter e.g. after loading a script
+//!
+//! @param interp - Interpreter previously obtained from createTclInterpreter()
+//!
+//! @note The state is restored by reuseTclInterpreter()
+//!
+TCL_API
+void saveTclInterpreterState(Tcl_Interp *interp) {
+   logTclError(interp, Tcl_Eval(interp, saveStateScript));
+   Tcl_ResetResult(interp);
+}
+
+//! Prepare an existing interpreter for re-use
+//!
+//! @param interp - Interpreter previously obtained from createTclInterpreter()
+//! @param target - Target type
+//! @param fp     - Log file
+//!
+//! @note Global variables and procs are returned to the state recorded by
+//!       saveTclInterpreterState() (if called)
+//!
+TCL_API
+void reuseTclInterpreter(Tcl_Interp *interp, TargetType_t target, FILE *fp) {
+   logFile = fp;
+   setTargetType(target);
+   if (Tcl_FindNamespace(interp, "::usbdm::pool", NULL, 0) != NULL) {
+      logTclError(interp, Tcl_Eval(interp, restoreStateScript));
+   }
+   Tcl_ResetResult(interp);
+}
+
 TCL_API
 void freeTclInterpreter(Tcl_Interp *interp) {
    Tcl_DeleteInterp(interp);
@@ -21,6 +21,9 @@
 TCL_API Tcl_Interp *createTclInterpreter(TargetType_t target, FILE *fp);
 TCL_API void freeTclInterpreter(Tcl_Interp *interp);
 TCL_API int evalTclScript(Tcl_Interp *interp, const char *script);
+TCL_API int evalTclCommand(Tcl_Interp *interp, const char *command, const char *arguments);
+TCL_API void reuseTclInterpreter(Tcl_Interp *interp, TargetType_t target, FILE *fp);
+TCL_API void saveTclInterpreterState(Tcl_Interp *interp);
 
 #if defined __cplusplus
     }
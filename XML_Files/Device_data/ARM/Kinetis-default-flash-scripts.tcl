@@ -170,24 +170,15 @@ proc loadSymbols {} {
 ;#   rb $::NV_FSEC
 ;#}
 proc executeCommand {} {
-   ;# Clear any existing errors
-   wb $::FTFL_FSTAT [expr $::FTFL_FSTAT_ACCERR|$::FTFL_FSTAT_FPVIOL]
-
-   ;# Start command
-   wb $::FTFL_FSTAT $::FTFL_FSTAT_CCIF
-
-   ;# Wait for command complete
-   set flashBusy 0
-   set retry 0
-   while { $flashBusy == 0} {
-      set fstat [ rb $::FTFL_FSTAT ]
-      set flashBusy [expr $fstat & $::FTFL_FSTAT_CCIF]
-      if [ expr $retry == 10] {
-         error "Flash busy timeout"
-      }
-      after 100
-      incr retry
+   ;# Clear any existing errors, start command & wait for command complete
+   set ops [list]
+   lappend ops [list wb $::FTFL_FSTAT [expr $::FTFL_FSTAT_ACCERR|$::FTFL_FSTAT_FPVIOL]]
+   lappend ops [list wb $::FTFL_FSTAT $::FTFL_FSTAT_CCIF]
+   lappend ops [list pollb $::FTFL_FSTAT $::FTFL_FSTAT_CCIF $::FTFL_FSTAT_CCIF 1000]
+   if [ catch { regscript $ops } result ] {
+      error "Flash busy timeout"
    }
+   set fstat [lindex $result end]
    if [ expr ( $fstat & $::FTFL_FSTAT_ACCERR ) != 0 ] {
       error "Flash access error"
    }
@@ -127,44 +127,34 @@ proc calculateFlashDivider { busFrequency } {
 proc executeFlashCommand { cmd {address "none"} {data0 "none"} {data1 "none"} {data2 "none"} {data3 "none"} } {
    ;# puts "executeFlashCommand {}"
    
-   wb $::HCS12_FSTAT   $::HCS12_FSTAT_CLEAR           ;# clear any error flags
-   wb $::HCS12_FCCOBIX   0                            ;# index = 0
-   wb $::HCS12_FCCOBHI $cmd                           ;# load program command
+   ;# Register accesses are done as a single register script
+   set ops [list]
+   lappend ops [list wb $::HCS12_FSTAT   $::HCS12_FSTAT_CLEAR]            ;# clear any error flags
+   lappend ops [list wb $::HCS12_FCCOBIX 0]                               ;# index = 0
+   lappend ops [list wb $::HCS12_FCCOBHI $cmd]                            ;# load program command
    if {$address != "none"} {
-      wb $::HCS12_FCCOBLO [expr ($address>>16)&0xFF]  ;# load GPAGE
-      wb $::HCS12_FCCOBIX    1                        ;# index = 1
-      ww $::HCS12_FCCOBHI [expr $address&0xFFFF]      ;# load addr
+      lappend ops [list wb $::HCS12_FCCOBLO [expr ($address>>16)&0xFF]]   ;# load GPAGE
+      lappend ops [list wb $::HCS12_FCCOBIX 1]                            ;# index = 1
+      lappend ops [list ww $::HCS12_FCCOBHI [expr $address&0xFFFF]]       ;# load addr
       if {$data0 != "none"} { 
-         wb $::HCS12_FCCOBIX    2                     ;# index = 2
-         ww $::HCS12_FCCOBHI [expr $data0]            ;# load data
-         wb $::HCS12_FCCOBIX    3                     ;# index = 3
-         ww $::HCS12_FCCOBHI [expr $data1]            ;# load data
-         wb $::HCS12_FCCOBIX    4                     ;# index = 4
-         ww $::HCS12_FCCOBHI [expr $data2]            ;# load data
-         wb $::HCS12_FCCOBIX    5                     ;# index = 5
-         ww $::HCS12_FCCOBHI [expr $data3]            ;# load data
+         set index 2
+         foreach data [list $data0 $data1 $data2 $data3] {
+            lappend ops [list wb $::HCS12_FCCOBIX $index]                 ;# index = 2..5
+            lappend ops [list ww $::HCS12_FCCOBHI [expr $data]]           ;# load data
+            incr index
+         }
       }
    }
-   wb $::HCS12_FSTAT $::HCS12_FSTAT_CCIF  ;# Clear CCIF to execute the command 
-
-   ;# Wait for command completion
-   set flashBusy 1
-   set retry 0
-   while { $flashBusy } {
-      after 20
-      set status [rb $::HCS12_FSTAT]
-      set flashBusy  [expr ($status & $::HCS12_FSTAT_CCIF) == 0x00]
-      set flashError [expr ($status & ($::HCS12_FSTAT_FPVIOL|$::HCS12_FSTAT_ACCERR))]
-      if [expr $flashError != 0] {
-         break;
-      }
-      if [expr $retry == 20] {
-         break;
-      }
-      incr retry
+   lappend ops [list wb $::HCS12_FSTAT $::HCS12_FSTAT_CCIF]               ;# Clear CCIF to execute the command 
+   lappend ops [list pollb $::HCS12_FSTAT $::HCS12_FSTAT_CCIF $::HCS12_FSTAT_CCIF 400] ;# Wait for command completion
+
+   if [ catch { regscript $ops } result ] {
+      ;# puts "Flash command error $result"
+      error "Flash command failed"
    }
-   if [ expr ($flashError || ($retry>=20)) ] {
-      ;# puts [ format "Flash command error HCS12_FSTAT=0x%02X, retry=%d" $status $retry ]
+   set status [lindex $result end]
+   if [ expr ($status & ($::HCS12_FSTAT_FPVIOL|$::HCS12_FSTAT_ACCERR)) != 0 ] {
+      ;# puts [ format "Flash command error HCS12_FSTAT=0x%02X" $status ]
       error "Flash command failed"
    }
 }